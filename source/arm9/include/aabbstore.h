@@ -0,0 +1,150 @@
+/**
+ * @file aabbstore.h
+ *
+ * @brief The aabbStore class that keeps every object's world space bounding box
+ *
+ * This file contains the aabbStore class. The narrowphase used to get every object's
+ * box by following object->frame to its gfxAsset and adding its topleft and dimensions
+ * to the object's position, for both objects of every pair it tested. The aabbStore
+ * does that once per object per frame instead and keeps the results in four flat
+ * arrays (structure of arrays) of raw fixed32 values indexed by object id.
+ *
+ * overlapBatch() then runs over two lists of object ids and tests every pair of boxes
+ * at once, so the narrowphase only has to run the real collision tests on the pairs
+ * that are touching. On the DS it's a branchless loop kept in ITCM. Built with SSE2
+ * (by a host compiler, for benchmarking big scenes) it tests four pairs at a time.
+ *
+ * @see level.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AABBSTORE_H_INCLUDED
+#define AABBSTORE_H_INCLUDED
+
+// Use the four-at-a-time kernel when the compiler can do SSE2
+#if defined(__SSE2__)
+#define ZBE_AABB_SSE2
+#endif
+
+#include <nds.h>
+#include <vector>
+#include "object.h"
+#include "vector.h"
+#include "fixed32.h"
+#include "broadphase.h"
+
+using namespace std;
+
+
+/**
+ * aabbStore class
+ *
+ * Every object's bounding box, one array per side. See the top of this file for how it works.
+ *
+ * @author Joe Balough
+ */
+class aabbStore
+{
+public:
+	/**
+	 * resize function
+	 *
+	 * Makes room for a box for every object id below numObjects. New boxes are empty.
+	 *
+	 * @param unsigned int numObjects
+	 *   How many objects there are
+	 * @author Joe Balough
+	 */
+	void resize(unsigned int numObjects);
+
+	/**
+	 * update function
+	 *
+	 * Refreshes an object's box from its position and frame. Call this once an object
+	 * is done moving for the frame and again if something pushes it.
+	 *
+	 * @param object *obj
+	 *   The object to refresh. Its id has to be below what was passed to resize.
+	 * @author Joe Balough
+	 */
+	inline void update(object *obj)
+	{
+		vector2D<fixed32> topleft, bottomright;
+		getBounds(obj, topleft, bottomright);
+		int id = obj->getObjectId();
+		minX[id] = topleft.x.getRaw();
+		minY[id] = topleft.y.getRaw();
+		maxX[id] = bottomright.x.getRaw();
+		maxY[id] = bottomright.y.getRaw();
+	}
+
+	/**
+	 * touching function
+	 *
+	 * Tests one pair of boxes, touching counts.
+	 *
+	 * @param int a, int b
+	 *   The ids of the two objects
+	 * @return bool
+	 *   Whether or not their boxes are touching
+	 * @author Joe Balough
+	 */
+	inline bool touching(int a, int b) const
+	{
+		return minX[a] <= maxX[b] && minX[b] <= maxX[a] && minY[a] <= maxY[b] && minY[b] <= maxY[a];
+	}
+
+	/**
+	 * overlapBatch function
+	 *
+	 * Tests the boxes of idsA[i] and idsB[i] for every i below count, touching counts.
+	 *
+	 * @param const int *idsA, const int *idsB
+	 *   The ids of the objects in each pair
+	 * @param unsigned int count
+	 *   How many pairs there are
+	 * @param uint8 *hits
+	 *   Set to 1 for every pair whose boxes are touching and 0 for the rest
+	 * @return unsigned int
+	 *   How many pairs are touching
+	 * @author Joe Balough
+	 */
+	unsigned int overlapBatch(const int *idsA, const int *idsB, unsigned int count, uint8 *hits) const;
+
+	/**
+	 * overlapBatchScalar function
+	 *
+	 * overlapBatch one pair at a time. This is what overlapBatch runs when it isn't
+	 * built with SSE2, it's only public so the two can be compared.
+	 *
+	 * @see overlapBatch
+	 * @author Joe Balough
+	 */
+	unsigned int overlapBatchScalar(const int *idsA, const int *idsB, unsigned int count, uint8 *hits) const;
+
+private:
+	// Indexed by object id, the raw fixed32 values of its box's sides
+	vector<int32> minX, minY, maxX, maxY;
+};
+
+
+#endif
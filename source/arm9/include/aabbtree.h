@@ -0,0 +1,392 @@
+/**
+ * @file aabbtree.h
+ *
+ * @brief The aabbTree broadphase engine
+ *
+ * This file contains the aabbTree class, a dynamic bounding volume tree broadphase.
+ * Every object gets a leaf holding a "fat" bounding box: its real box grown by
+ * ZBE_TREE_MARGIN pixels on every side. Each branch holds the box around both of its
+ * children. An object that moves but stays inside its fat box costs nothing; only once
+ * it leaves it is the leaf pulled out and re-inserted, refitting and rebalancing the
+ * branches above it on the way.
+ *
+ * Unlike the collisionMatrix, which allocates an objGroup for every block of the level
+ * up front, the tree only ever has 2n - 1 nodes for n objects. This makes it the engine
+ * to use for big levels with only a few things in them. It also answers region and ray
+ * queries by only descending into branches whose box is hit.
+ *
+ * @see broadphase.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AABBTREE_H_INCLUDED
+#define AABBTREE_H_INCLUDED
+
+// How many pixels to grow every leaf's box by on each side
+#define ZBE_TREE_MARGIN 8
+
+// Used as the index of a node that doesn't exist
+#define ZBE_TREE_NULL -1
+
+#include <nds.h>
+#include <vector>
+#include "object.h"
+#include "vector.h"
+#include "fixed32.h"
+#include "broadphase.h"
+
+using namespace std;
+
+
+/**
+ * aabbTree class
+ *
+ * The ZBE_BROADPHASE_TREE broadphase engine. See the top of this file for how it works.
+ *
+ * The query functions use a stack kept in the tree, so a visitor must not start
+ * another query on the same tree or change the tree while one is running.
+ *
+ * @author Joe Balough
+ */
+class aabbTree : public broadphase
+{
+public:
+	/**
+	 * aabbTree constructor
+	 *
+	 * Makes an empty tree
+	 *
+	 * @author Joe Balough
+	 */
+	aabbTree();
+
+	/**
+	 * insertObject function
+	 *
+	 * Makes a leaf for the object and inserts it into the tree
+	 *
+	 * @param object *add
+	 *   A pointer to the object to add
+	 * @author Joe Balough
+	 */
+	virtual void insertObject(object *add);
+
+	/**
+	 * updateObject function
+	 *
+	 * If the object has moved out of its fat box, re-inserts its leaf with a new one.
+	 *
+	 * @param object *move
+	 *   A pointer to the object that moved
+	 * @author Joe Balough
+	 */
+	virtual void updateObject(object *move);
+
+	/**
+	 * removeObject function
+	 *
+	 * Takes an object's leaf out of the tree
+	 *
+	 * @param object *remove
+	 *   A pointer to the object to remove
+	 * @return bool
+	 *   Whether or not the object was in the tree
+	 * @author Joe Balough
+	 */
+	virtual bool removeObject(object *remove);
+
+	/**
+	 * findPairs function
+	 *
+	 * Queries the tree with the fat box of every object that moved. A pair of
+	 * objects that both moved is only reported from the one with the lower id.
+	 *
+	 * @param vector<bool> &objMoved
+	 *   Indexed by object id, whether or not that object moved this frame
+	 * @param vector<objPair> &pairs
+	 *   The vector to append the pairs to
+	 * @return unsigned int
+	 *   The number of pairs found
+	 * @author Joe Balough
+	 */
+	virtual unsigned int findPairs(vector<bool> &objMoved, vector<objPair> &pairs);
+
+	/**
+	 * findCandidates function
+	 *
+	 * broadphase interface for queryRegion
+	 *
+	 * @param vector2D<fixed32> min, vector2D<fixed32> max
+	 *   The top-left and bottom-right corners of the region
+	 * @param vector<object*> &found
+	 *   The vector to append the objects to
+	 * @author Joe Balough
+	 */
+	virtual void findCandidates(vector2D<fixed32> min, vector2D<fixed32> max, vector<object*> &found);
+
+	/**
+	 * queryRegion function
+	 *
+	 * Calls visit(object*) for every object whose bounding box overlaps the
+	 * region. If visit returns false, the query stops.
+	 *
+	 * @param vector2D<fixed32> min, vector2D<fixed32> max
+	 *   The top-left and bottom-right corners of the region
+	 * @param Visitor &visit
+	 *   Anything that can be called like bool visit(object *found)
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	void queryRegion(vector2D<fixed32> min, vector2D<fixed32> max, Visitor &visit)
+	{
+		stack.clear();
+		if (root != ZBE_TREE_NULL)
+			stack.push_back(root);
+
+		while (!stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+			treeNode &node = nodes[index];
+			if (!overlaps(node.min, node.max, min, max))
+				continue;
+
+			if (node.isLeaf())
+			{
+				// Check the object's real box
+				vector2D<fixed32> objMin, objMax;
+				getBounds(node.obj, objMin, objMax);
+				if (overlaps(objMin, objMax, min, max) && !visit(node.obj))
+					return;
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	/**
+	 * rayCast function
+	 *
+	 * Calls visit(object*) for every object whose bounding box is crossed by the
+	 * line segment from start to end. Objects are not visited in any particular
+	 * order. If visit returns false, the cast stops.
+	 *
+	 * @param vector2D<fixed32> start, vector2D<fixed32> end
+	 *   The two ends of the segment
+	 * @param Visitor &visit
+	 *   Anything that can be called like bool visit(object *hit)
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	void rayCast(vector2D<fixed32> start, vector2D<fixed32> end, Visitor &visit)
+	{
+		vector2D<fixed32> delta = end - start;
+
+		stack.clear();
+		if (root != ZBE_TREE_NULL)
+			stack.push_back(root);
+
+		while (!stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+			treeNode &node = nodes[index];
+			if (!segmentHits(start, delta, node.min, node.max))
+				continue;
+
+			if (node.isLeaf())
+			{
+				// Check the object's real box
+				vector2D<fixed32> objMin, objMax;
+				getBounds(node.obj, objMin, objMax);
+				if (segmentHits(start, delta, objMin, objMax) && !visit(node.obj))
+					return;
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	/**
+	 * getNumNodes function
+	 *
+	 * @return unsigned int
+	 *   How many nodes the tree has allocated, used or not
+	 * @author Joe Balough
+	 */
+	inline unsigned int getNumNodes()
+	{
+		return nodes.size();
+	}
+
+	/**
+	 * getHeight function
+	 *
+	 * @return int
+	 *   The height of the tree. 0 for just one leaf or -1 when empty.
+	 * @author Joe Balough
+	 */
+	inline int getHeight()
+	{
+		return (root == ZBE_TREE_NULL) ? -1 : nodes[root].height;
+	}
+
+private:
+	// One node of the tree. Leaves have an object, branches have two children.
+	struct treeNode
+	{
+		// The fat bounding box
+		vector2D<fixed32> min, max;
+
+		// The object for a leaf
+		object *obj;
+
+		// The parent node. For nodes in the free list, the next free node.
+		int parent;
+
+		// The two children of a branch. ZBE_TREE_NULL for a leaf.
+		int child1, child2;
+
+		// 0 for a leaf, -1 for a free node
+		int height;
+
+		inline bool isLeaf() const
+		{
+			return child1 == ZBE_TREE_NULL;
+		}
+	};
+
+	/**
+	 * overlaps function
+	 *
+	 * @return bool
+	 *   Whether or not the two boxes overlap (touching counts)
+	 * @author Joe Balough
+	 */
+	static inline bool overlaps(const vector2D<fixed32> &min1, const vector2D<fixed32> &max1, const vector2D<fixed32> &min2, const vector2D<fixed32> &max2)
+	{
+		return !(max1.x < min2.x || max2.x < min1.x || max1.y < min2.y || max2.y < min1.y);
+	}
+
+	/**
+	 * allocateNode function
+	 *
+	 * Takes a node off the free list or makes a new one if there are none
+	 *
+	 * @return int
+	 *   The index of the node
+	 * @author Joe Balough
+	 */
+	int allocateNode();
+
+	/**
+	 * freeNode function
+	 *
+	 * Puts a node onto the free list
+	 *
+	 * @param int index
+	 *   The index of the node to free
+	 * @author Joe Balough
+	 */
+	void freeNode(int index);
+
+	/**
+	 * insertLeaf function
+	 *
+	 * Finds the cheapest sibling for a leaf, gives the two a new parent, and
+	 * refits everything above it.
+	 *
+	 * @param int leaf
+	 *   The index of the leaf to insert
+	 * @author Joe Balough
+	 */
+	void insertLeaf(int leaf);
+
+	/**
+	 * removeLeaf function
+	 *
+	 * Takes a leaf out of the tree, replacing its parent with its sibling, and
+	 * refits everything above it. The leaf itself is not freed.
+	 *
+	 * @param int leaf
+	 *   The index of the leaf to remove
+	 * @author Joe Balough
+	 */
+	void removeLeaf(int leaf);
+
+	/**
+	 * refitUp function
+	 *
+	 * Walks from a node up to the root rebalancing and refitting the boxes
+	 *
+	 * @param int index
+	 *   The index of the first node to refit
+	 * @author Joe Balough
+	 */
+	void refitUp(int index);
+
+	/**
+	 * balance function
+	 *
+	 * If one child of a node is more than one level taller than the other,
+	 * rotates the taller child up into the node's place.
+	 *
+	 * @param int a
+	 *   The index of the node to balance
+	 * @return int
+	 *   The index of the node now at a's old place in the tree
+	 * @author Joe Balough
+	 */
+	int balance(int a);
+
+	/**
+	 * setFatBox function
+	 *
+	 * Sets a leaf's box to its object's box grown by ZBE_TREE_MARGIN
+	 *
+	 * @param int leaf
+	 *   The index of the leaf
+	 * @author Joe Balough
+	 */
+	void setFatBox(int leaf);
+
+	// Every node in the tree, used or free
+	vector<treeNode> nodes;
+
+	// The root node and the first node in the free list
+	int root, freeList;
+
+	// Indexed by object id, the leaf for that object or ZBE_TREE_NULL
+	vector<int> leafOf;
+
+	// Used by the queries so they don't have to allocate
+	vector<int> stack;
+};
+
+
+#endif
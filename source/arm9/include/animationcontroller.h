@@ -0,0 +1,235 @@
+/**
+ * @file animationcontroller.h
+ *
+ * @brief The animationController class that plays an object's animations
+ *
+ * This file contains the animationController class. The zbe file has every object's
+ * animations, each one a list of frames with how many blanks to show each frame for
+ * (frameAsset::time), but objects only ever showed the first frame of their first
+ * animation and asked the assets class for its gfx and palette every time they drew.
+ *
+ * Every object now has an animationController. step() is called once a frame and
+ * counts down the current frame's time, moving on to the next frame when it runs
+ * out and going back to the first one after the last. A frame with a time of 0 is
+ * shown until something asks for another animation, with either function below.
+ *
+ * Gameplay code switches animations with play(), which takes effect on the next
+ * step(), or playAfter(), which waits for the current animation to get to its end.
+ * Neither does anything but remember the request, so they're cheap to call every frame.
+ *
+ * The video memory the current frame's gfx is in and the palette slot it uses are
+ * kept once they're looked up, and only looked up again after the frame changes.
+ *
+ * @see object.h
+ * @see assettypes.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANIMATIONCONTROLLER_H_INCLUDED
+#define ANIMATIONCONTROLLER_H_INCLUDED
+
+// Means there isn't an animation waiting to be played
+#define ZBE_NO_ANIMATION -1
+
+#include <nds.h>
+#include <vector>
+#include "assettypes.h"
+
+using namespace std;
+
+
+/**
+ * animationController class
+ *
+ * Plays one object's animations. See the top of this file for how it works.
+ *
+ * @author Joe Balough
+ */
+class animationController
+{
+public:
+	/**
+	 * animationController constructor
+	 *
+	 * Makes a controller with no animations. step() does nothing until it's given some.
+	 *
+	 * @author Joe Balough
+	 */
+	animationController();
+
+	/**
+	 * setAnimations function
+	 *
+	 * Gives the controller the animations it plays and starts the first frame of the first one.
+	 *
+	 * @param frameAsset ***animations
+	 *   A NULL terminated array of NULL terminated arrays of frames, like objectAsset::animations
+	 * @author Joe Balough
+	 */
+	void setAnimations(frameAsset ***animations);
+
+	/**
+	 * play function
+	 *
+	 * Switches to an animation on the next step(), starting on its first frame. Does nothing if
+	 * it's already playing, or if there's no such animation.
+	 *
+	 * @param int animationId
+	 *   Which animation to play
+	 * @author Joe Balough
+	 */
+	void play(int animationId);
+
+	/**
+	 * playAfter function
+	 *
+	 * Switches to an animation once the current one is done showing its last frame instead of
+	 * starting it over. Does nothing if there's no such animation.
+	 *
+	 * @param int animationId
+	 *   Which animation to play next
+	 * @author Joe Balough
+	 */
+	void playAfter(int animationId);
+
+	/**
+	 * step function
+	 *
+	 * Moves the animation along by one blank. Call this once a frame.
+	 *
+	 * @return bool
+	 *   Whether or not the frame being shown changed
+	 * @author Joe Balough
+	 */
+	bool step();
+
+	/**
+	 * getFrame function
+	 *
+	 * @return frameAsset*
+	 *   The frame being shown, NULL if there aren't any animations
+	 * @author Joe Balough
+	 */
+	inline frameAsset *getFrame() const
+	{
+		return current;
+	}
+
+	/**
+	 * getGfx function
+	 *
+	 * Gets the video memory the frame being shown is in. Only asks the assets class the first
+	 * time after the frame changes.
+	 *
+	 * @return uint16*
+	 *   Where the frame's gfx are in video memory
+	 * @author Joe Balough
+	 */
+	inline uint16 *getGfx()
+	{
+		if (stale)
+			resolve();
+		return gfxMem;
+	}
+
+	/**
+	 * getPaletteId function
+	 *
+	 * Gets the palette slot the frame being shown uses. Only asks the assets class the first
+	 * time after the frame changes.
+	 *
+	 * @return uint8
+	 *   The frame's palette slot
+	 * @author Joe Balough
+	 */
+	inline uint8 getPaletteId()
+	{
+		if (stale)
+			resolve();
+		return paletteId;
+	}
+
+	/**
+	 * getAnimation function
+	 *
+	 * @return int
+	 *   Which animation is playing
+	 * @author Joe Balough
+	 */
+	inline int getAnimation() const
+	{
+		return animation;
+	}
+
+	/**
+	 * getFrameIndex function
+	 *
+	 * @return int
+	 *   Which frame of the animation is being shown
+	 * @author Joe Balough
+	 */
+	inline int getFrameIndex() const
+	{
+		return frameIndex;
+	}
+
+private:
+	/**
+	 * show function
+	 *
+	 * Starts showing a frame and starts its time over.
+	 *
+	 * @author Joe Balough
+	 */
+	void show(int animationId, int frameId);
+
+	/**
+	 * resolve function
+	 *
+	 * Looks up the frame's gfx and palette with the assets class.
+	 *
+	 * @author Joe Balough
+	 */
+	void resolve();
+
+	// The animations, and how many there are
+	frameAsset ***animations;
+	int numAnimations;
+
+	// The animation playing, the frame of it being shown and that frame
+	int animation, frameIndex;
+	frameAsset *current;
+
+	// How many more blanks to show the frame for. 0 if it's shown until the animation changes.
+	uint8 timer;
+
+	// The animations play() and playAfter() asked for, or ZBE_NO_ANIMATION
+	int requested, queued;
+
+	// The frame's gfx in video memory and its palette slot, and whether they need to be looked up again
+	uint16 *gfxMem;
+	uint8 paletteId;
+	bool stale;
+};
+
+
+#endif
@@ -43,7 +43,7 @@
 #ifndef ASSETS_H_INCLUDED
 #define ASSETS_H_INCLUDED
 
-#define ZBE_VERSION_SUPPORTED 1
+#define ZBE_VERSION_SUPPORTED 3
 
 #include <stdio.h>
 #include <string.h>
@@ -227,6 +227,19 @@ public:
 		return uint32(levelAssets.size());
 	}
 
+	/**
+	 * Get an objectAsset
+	 * @param uint32 id
+	 *   Id of the objectAsset, in the order they are in the assets file
+	 * @return objectAsset*
+	 *   The objectAsset or NULL if there isn't one with that id
+	 * @author Joe Balough
+	 */
+	inline objectAsset *getObjectAsset(uint32 id)
+	{
+		return (id < objectAssets.size()) ? objectAssets[id] : NULL;
+	}
+
 	/**
 	 * Get the name of a level
 	 * @param uint32
@@ -273,6 +286,18 @@ private:
 	 */
 	template <class T> T load(FILE *input);
 
+	/**
+	 * loadFrameBox function
+	 *
+	 * Reads a hitbox or hurtbox off of the zbeData: its left, top, width and
+	 * height, one byte each.
+	 *
+	 * @param frameBox &box
+	 *   The box to read into
+	 * @author Joe Balough
+	 */
+	void loadFrameBox(frameBox &box);
+
 
 	/**
 	 * openFile function
@@ -32,9 +32,14 @@
 #include <nds.h>
 #include <fat.h>
 #include "vector.h"
+#include "fixed32.h"
 
 using namespace std;
 
+// levelAsset::collisionLayer when the level doesn't collide with any background.
+// This value is stored in the zbe file so don't change it.
+#define ZBE_NO_COLLISION_LAYER 0xFF
+
 // TODO: Add refCount values to gfx and palette assets and use that to remove them from video memory when out of video memory
 
 /**
@@ -93,7 +98,17 @@ struct paletteAsset : public assetStatus
 struct gfxAsset : public assetStatus
 {
 	gfxAsset() : assetStatus()
-	{}
+	{
+		size = SpriteSize_8x8;
+		mask = NULL;
+		maskWords = 0;
+	}
+
+	~gfxAsset()
+	{
+		if (mask)
+			delete[] mask;
+	}
 
 	void dumpData()
 	{
@@ -116,6 +131,20 @@ struct gfxAsset : public assetStatus
 	// Dimensions and position
 	vector2D<uint8> dimensions;
 	vector2D<uint8> topleft;
+
+	// How wide the sprite this gfx is drawn in is. A flipped sprite is mirrored across all of it,
+	// not just the dimensions sized box.
+	inline int spriteWidth() const
+	{
+		static const uint8 widths[4][4] = {{8, 16, 32, 64}, {16, 32, 32, 64}, {8, 8, 16, 32}, {0, 0, 0, 0}};
+		return widths[SPRITE_SIZE_SHAPE(size)][SPRITE_SIZE_SIZE(size)];
+	}
+
+	// Collision mask for the dimensions sized box at topleft, made by cliCreator. One bit per
+	// pixel, set if the pixel isn't transparent. Each row is maskWords words long with the
+	// leftmost pixel in bit 0 of the first word. Always in main memory, NULL if there isn't one.
+	uint32 *mask;
+	uint8 maskWords;
 };
 
 
@@ -128,17 +157,28 @@ struct backgroundAsset : public assetStatus
 {
 	backgroundAsset() : assetStatus()
 	{
-		w = h = length = 0;
+		w = h = length = colLength = 0;
+		collision = NULL;
 	}
 
 	~backgroundAsset()
-	{}
+	{
+		if (collision)
+			delete[] collision;
+	}
 
 	// width and height in tiles of the background
 	uint32 w, h;
 
 	// The number of bytes in the data section of the MAP data
 	uint32 length;
+
+	// The collision layer, one ZBE_TILE_ value per tile in the same order as the map.
+	// NULL if this background doesn't have one.
+	uint8 *collision;
+
+	// The number of bytes in the collision layer
+	uint32 colLength;
 };
 
 
@@ -155,28 +195,77 @@ struct levelBackgroundAsset
 };
 
 
+// Most hitboxes or hurtboxes a frame can have. Their counts share a byte in the zbe file.
+#define ZBE_MAX_FRAME_BOXES 15
+
+/**
+ * frameBox struct. A box on an animation frame, relative to the top-left corner of
+ * the sprite like gfxAsset's topleft.
+ * @author Joe Balough
+ */
+struct frameBox
+{
+	vector2D<uint8> topleft;
+	vector2D<uint8> dimensions;
+};
+
 /**
  * frameAsset struct. Used in keeping track of animations. Has a gfx id, time it should be on screen
- * and a pointer to the gfx in main memory (or NULL if not loaded)
+ * and a pointer to the gfx in main memory (or NULL if not loaded). Can also have hitboxes, the
+ * boxes the narrowphase collides it with, and hurtboxes, the boxes where it can be hurt.
  * @author Joe Balough
  */
 struct frameAsset
 {
+	frameAsset()
+	{
+		gfx = NULL;
+		pal = NULL;
+		time = 0;
+		hitboxes = hurtboxes = NULL;
+		numHitboxes = numHurtboxes = 0;
+	}
+
+	~frameAsset()
+	{
+		if (hitboxes)
+			delete[] hitboxes;
+		if (hurtboxes)
+			delete[] hurtboxes;
+	}
+
 	gfxAsset *gfx;
 	paletteAsset *pal;
 	uint8 time;
+
+	// The boxes used for collisions with other objects. If there aren't any, the gfx's box is used.
+	frameBox *hitboxes;
+	uint8 numHitboxes;
+
+	// The boxes where this frame can be hurt. See decapod::hurtDetect.
+	frameBox *hurtboxes;
+	uint8 numHurtboxes;
 };
 
 
+// Collision layers objects are on and collide with when their XML doesn't say. These values are
+// also cliCreator's defaults so don't change them.
+#define ZBE_CATEGORY_DEFAULT 0x0001
+#define ZBE_MASK_ALL 0xFFFF
+
+
 /**
  * objectAsset struct. contains the object data from the asset file
  * @author Joe Balough
  */
 struct objectAsset
 {
-	objectAsset(uint8 w)
+	objectAsset(uint8 w, uint16 c = ZBE_CATEGORY_DEFAULT, uint16 m = ZBE_MASK_ALL, bool s = false)
 	{
 		weight = w;
+		category = c;
+		mask = m;
+		isSensor = s;
 	}
 
 	~objectAsset()
@@ -199,6 +288,12 @@ struct objectAsset
 
 	// The weight of this object
 	uint8 weight;
+
+	// The collision layers it's on and the ones it collides with. See object::category.
+	uint16 category, mask;
+
+	// Whether or not it's a sensor. See object::isSensor.
+	bool isSensor;
 };
 
 
@@ -212,21 +307,25 @@ struct objectAsset
 struct levelObjectAsset
 {
 	// Construcotr
-	levelObjectAsset(vector2D<float> pos, vector2D<float> grav, objectAsset *o)
+	levelObjectAsset(vector2D<fixed32> pos, vector2D<fixed32> grav, objectAsset *o, bool s = false)
 	{
 		gravity = grav;
 		position = pos;
 		obj = o;
+		isStatic = s;
 	}
 
 	// coordinates on screen
-	vector2D<float> position;
+	vector2D<fixed32> position;
 
-	// Gravity
-	vector2D<float> gravity;
+	// Gravity, 20.12 fixed point straight out of the zbe file
+	vector2D<fixed32> gravity;
 
 	// pointer to general objectAsset
 	objectAsset *obj;
+
+	// Whether or not this is static level geometry that never moves
+	bool isStatic;
 };
 
 
@@ -298,6 +397,10 @@ struct levelAsset : assetStatus
 	// The gfxAsset to use as this level's background tileset
 	gfxAsset *tileset;
 
+	// Which background layer's collision layer objects collide with, or ZBE_NO_COLLISION_LAYER
+	// if the level doesn't have one.
+	uint8 collisionLayer;
+
 	// The background that this level uses
 	levelBackgroundAsset bgs[4];
 
@@ -309,6 +412,9 @@ struct levelAsset : assetStatus
 	// to add: level geometry, villians, etc.
 
 	vector2D<uint32> dimensions;
+
+	// Which broadphase collision engine to use. One of the ZBE_BROADPHASE_ values.
+	uint8 broadphase;
 };
 
 
@@ -145,7 +145,7 @@ private:
 	uint16 *mapPtr;
 
 	// Keep track of last values
-	vector2D<float> lastScreenOffset;
+	vector2D<fixed32> lastScreenOffset;
 	vector2D<int> lastBgMapRepTL;
 	vector2D<int> lastBgMapRepBR;
 };
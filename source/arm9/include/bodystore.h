@@ -0,0 +1,164 @@
+/**
+ * @file bodystore.h
+ *
+ * @brief The bodyStore class that keeps every object's physics and render state together
+ *
+ * This file contains the bodyStore class. Every object used to keep its position,
+ * velocity, acceleration, gravity and frame in among everything else it has, like its
+ * OAM, animations, affine matrix and flip flags, and the level moved them by calling
+ * each object's update function through its vtable. Doing that for every object every
+ * frame pulled a whole object into the data cache just to add a few numbers together.
+ *
+ * Now those fields live here instead, in one array per field (structure of arrays)
+ * indexed by object id, and an object's fields are references into its slot so
+ * everything that uses obj->position still works. integrate() moves every awake object
+ * in one tight loop over the arrays, kept in ITCM on the DS. Objects that need to do
+ * something of their own first, like heroes reading the buttons, say so with their
+ * hooks (see object.h) and only they get called.
+ *
+ * Objects are bound to their slots when they're made, so the store has to be resized
+ * for all of them before the first one is made and never again after that.
+ *
+ * @see object.h
+ * @see level.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BODYSTORE_H_INCLUDED
+#define BODYSTORE_H_INCLUDED
+
+#include <nds.h>
+#include <vector>
+#include "vector.h"
+#include "fixed32.h"
+#include "assettypes.h"
+
+using namespace std;
+
+
+/**
+ * bodyStore class
+ *
+ * Every object's physics and render state, one array per field. See the top of this file for how it works.
+ *
+ * @author Joe Balough
+ */
+class bodyStore
+{
+public:
+	/**
+	 * body struct
+	 *
+	 * One object's worth of what the store keeps. Only used by objects that aren't in a store.
+	 *
+	 * @author Joe Balough
+	 */
+	struct body
+	{
+		vector2D<fixed32> position, velocity, acceleration, gravity;
+		uint8 falling;
+		gfxAsset *frame;
+	};
+
+	/**
+	 * resize function
+	 *
+	 * Makes a slot for every object id below numObjects. New slots are at rest, falling and inactive.
+	 * Any object already bound to the store is left pointing at the old arrays, so only do this
+	 * before making the objects.
+	 *
+	 * @param unsigned int numObjects
+	 *   How many objects there are
+	 * @author Joe Balough
+	 */
+	void resize(unsigned int numObjects);
+
+	/**
+	 * setActive function
+	 *
+	 * Sets whether or not integrate() moves an object. The level keeps sleeping and static objects inactive.
+	 *
+	 * @param int id
+	 *   The object's id
+	 * @param bool isActive
+	 *   Whether or not it should be moved
+	 * @author Joe Balough
+	 */
+	inline void setActive(int id, bool isActive)
+	{
+		active[id] = isActive;
+	}
+
+	/**
+	 * isActive function
+	 *
+	 * @param int id
+	 *   The object's id
+	 * @return bool
+	 *   Whether or not integrate() moves it
+	 * @author Joe Balough
+	 */
+	inline bool isActive(int id) const
+	{
+		return active[id];
+	}
+
+	/**
+	 * integrate function
+	 *
+	 * Moves every active object by its velocity after adding its acceleration and, if it's falling,
+	 * its gravity to it. Remembers where each one was before in start.
+	 *
+	 * @param vector<int> &moved
+	 *   The id of every object that's still moving afterwards is pushed onto this
+	 * @author Joe Balough
+	 */
+	void integrate(vector<int> &moved);
+
+	/**
+	 * size function
+	 *
+	 * @return unsigned int
+	 *   How many slots there are
+	 * @author Joe Balough
+	 */
+	inline unsigned int size() const
+	{
+		return position.size();
+	}
+
+	// Indexed by object id. Objects' fields of the same names are references to these.
+	// These are all 20.12 fixed point, the ARM9 has no FPU.
+	vector< vector2D<fixed32> > position, velocity, acceleration, gravity;
+	vector<uint8> falling;
+	vector<gfxAsset*> frame;
+
+	// Indexed by object id, where it was before the last integrate() or since the level woke it.
+	vector< vector2D<fixed32> > start;
+
+private:
+	// Indexed by object id, whether or not integrate() moves it
+	vector<uint8> active;
+};
+
+
+#endif
@@ -0,0 +1,275 @@
+/**
+ * @file broadphase.h
+ *
+ * @brief The broadphase interface that every collision broadphase engine implements
+ *
+ * This file contains the abstract broadphase class that the level uses to find the
+ * pairs of objects that might be colliding each frame, along with the few bits and
+ * pieces that every broadphase engine shares. The level picks which engine it uses
+ * with the newBroadphase() function, either from the value stored in the zbe file
+ * or from one passed to the level constructor.
+ *
+ * @see collisionmatrix.h
+ * @see sweepandprune.h
+ * @see aabbtree.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BROADPHASE_H_INCLUDED
+#define BROADPHASE_H_INCLUDED
+
+// Broadphase engines. These values are stored in the zbe file so don't change them.
+#define ZBE_BROADPHASE_GRID 0
+#define ZBE_BROADPHASE_SAP 1
+#define ZBE_BROADPHASE_TREE 2
+
+// Pass this to the level constructor to use the engine set in the level's data
+#define ZBE_BROADPHASE_FROM_LEVEL -1
+
+#include <nds.h>
+#include <vector>
+#include "object.h"
+#include "vector.h"
+#include "fixed32.h"
+
+using namespace std;
+
+
+/**
+ * objPair struct
+ *
+ * Two objects that might be colliding. Filled by the broadphase so the
+ * narrowphase can run over a flat list.
+ *
+ * @author Joe Balough
+ */
+struct objPair
+{
+	object *a, *b;
+};
+
+
+/**
+ * movedPairCollector struct
+ *
+ * A pair visitor that keeps only the pairs in which at least one of the objects
+ * moved this frame and whose collision layers let them collide. Every broadphase
+ * engine uses this to fill findPairs' vector.
+ *
+ * @author Joe Balough
+ */
+struct movedPairCollector
+{
+	movedPairCollector(vector<bool> &ObjMoved, vector<objPair> &Pairs) : objMoved(ObjMoved), pairs(Pairs) {}
+
+	inline void operator()(object *a, object *b)
+	{
+		if (!a->layersCollide(b))
+			return;
+
+		if (objMoved[a->getObjectId()] || objMoved[b->getObjectId()])
+		{
+			objPair pair = {a, b};
+			pairs.push_back(pair);
+		}
+	}
+
+	// Indexed by object id, whether or not that object moved
+	vector<bool> &objMoved;
+
+	// Where to put the pairs
+	vector<objPair> &pairs;
+};
+
+
+/**
+ * regionCollector struct
+ *
+ * A region query visitor that appends everything it's handed to a vector. The
+ * broadphase engines with queryRegion use this to fill findCandidates' vector.
+ *
+ * @author Joe Balough
+ */
+struct regionCollector
+{
+	regionCollector(vector<object*> &Found) : found(Found) {}
+
+	inline bool operator()(object *obj)
+	{
+		found.push_back(obj);
+		return true;
+	}
+
+	// Where to put the objects
+	vector<object*> &found;
+};
+
+
+/**
+ * getBounds function
+ *
+ * Gets the world space bounding box of an object's current frame, mirrored if the
+ * sprite is flipped. cliCreator clamps hitboxes and hurtboxes to this box so it holds
+ * all of them. Objects without a frame are treated as a single point at their position.
+ *
+ * @param object *obj
+ *   The object whose bounds are wanted
+ * @param vector2D<fixed32> &topleft, vector2D<fixed32> &bottomright
+ *   Set to the top-left and bottom-right corners of the bounding box
+ * @author Joe Balough
+ */
+inline void getBounds(object *obj, vector2D<fixed32> &topleft, vector2D<fixed32> &bottomright)
+{
+	topleft = obj->position;
+	if (obj->frame)
+	{
+		topleft += vector2D<fixed32>(obj->boxLeft(obj->frame->topleft.x, obj->frame->dimensions.x), obj->frame->topleft.y);
+		bottomright = topleft + vector2D<fixed32>(obj->frame->dimensions.x, obj->frame->dimensions.y);
+	}
+	else
+		bottomright = topleft;
+}
+
+
+/**
+ * segmentHits function
+ *
+ * Slab test for whether the segment from start to start + delta crosses a box.
+ * Used by the broadphase engines' ray casts.
+ *
+ * @param vector2D<fixed32> &start, vector2D<fixed32> &delta
+ *   Where the segment starts and how far it goes on each axis
+ * @param vector2D<fixed32> &min, vector2D<fixed32> &max
+ *   The top-left and bottom-right corners of the box
+ * @return bool
+ *   Whether or not the segment touches the box
+ * @author Joe Balough
+ */
+bool segmentHits(const vector2D<fixed32> &start, const vector2D<fixed32> &delta, const vector2D<fixed32> &min, const vector2D<fixed32> &max);
+
+
+/**
+ * broadphase class
+ *
+ * The abstract interface for a collision broadphase engine. A broadphase keeps track
+ * of where every object in a level is and, once per frame, finds the pairs of objects
+ * that might be colliding so the (much more expensive) narrowphase only has to look
+ * at those.
+ *
+ * @author Joe Balough
+ */
+class broadphase
+{
+public:
+	virtual ~broadphase() {}
+
+	/**
+	 * insertObject function
+	 *
+	 * Starts keeping track of an object
+	 *
+	 * @param object *add
+	 *   A pointer to the object to add
+	 * @author Joe Balough
+	 */
+	virtual void insertObject(object *add) = 0;
+
+	/**
+	 * updateObject function
+	 *
+	 * Should be called after an object has moved so the broadphase can update
+	 * where it thinks the object is.
+	 *
+	 * @param object *move
+	 *   A pointer to the object that moved
+	 * @author Joe Balough
+	 */
+	virtual void updateObject(object *move) = 0;
+
+	/**
+	 * removeObject function
+	 *
+	 * Stops keeping track of an object
+	 *
+	 * @param object *remove
+	 *   A pointer to the object to remove
+	 * @return bool
+	 *   Whether or not the object was being kept track of
+	 * @author Joe Balough
+	 */
+	virtual bool removeObject(object *remove) = 0;
+
+	/**
+	 * findPairs function
+	 *
+	 * Finds every pair of objects that might be colliding, each exactly once,
+	 * and appends the ones in which at least one object moved to pairs.
+	 *
+	 * @param vector<bool> &objMoved
+	 *   Indexed by object id, whether or not that object moved this frame
+	 * @param vector<objPair> &pairs
+	 *   The vector to append the pairs to
+	 * @return unsigned int
+	 *   The number of candidate pairs that were considered, moved or not
+	 * @author Joe Balough
+	 */
+	virtual unsigned int findPairs(vector<bool> &objMoved, vector<objPair> &pairs) = 0;
+
+	/**
+	 * findCandidates function
+	 *
+	 * Finds every object whose bounding box overlaps a region and appends it to
+	 * found. Used for the odd query that isn't part of the once a frame pair
+	 * search, like the box a fast object swept through, so it doesn't have to be
+	 * as quick as findPairs.
+	 *
+	 * @param vector2D<fixed32> min, vector2D<fixed32> max
+	 *   The top-left and bottom-right corners of the region
+	 * @param vector<object*> &found
+	 *   The vector to append the objects to
+	 * @author Joe Balough
+	 */
+	virtual void findCandidates(vector2D<fixed32> min, vector2D<fixed32> max, vector<object*> &found) = 0;
+};
+
+
+/**
+ * newBroadphase function
+ *
+ * Makes a new broadphase engine of the requested type for a level of the given size.
+ * Unknown types print a warning and get a grid.
+ *
+ * @param int type
+ *   One of the ZBE_BROADPHASE_ values
+ * @param int levelWidth, int levelHeight
+ *   The width and height of the whole level in pixels
+ * @param vector<int> *objectExtents
+ *   How far each of the level's objects reaches from its position, used by the
+ *   grid to size its blocks. Gets reordered. NULL for the default block size.
+ * @return broadphase*
+ *   A pointer to the new engine. Delete it when done.
+ * @author Joe Balough
+ */
+broadphase *newBroadphase(int type, int levelWidth, int levelHeight, vector<int> *objectExtents = NULL);
+
+
+#endif
@@ -4,22 +4,42 @@
  * @brief The collisonMatrix and objGroup classes used for fast collision detection
  *
  * This file contains the collisionMatrix and objGroup classes that are used by the
- * zoidberg engine to perform fast collision detection. It is used by breaking the level
- * world down into large-ish blocks (at least as big as the biggest object), that keep
- * track of a vector of object pointers.
+ * zoidberg engine to perform fast collision detection. It is used by breaking the
+ * world down into large-ish blocks that keep track of an intrusive linked list of object
+ * pointers. Only the blocks that have something in them get an objGroup, kept in a
+ * hash table by block coordinates, so memory goes with how many objects there are
+ * rather than how big the level is. Blocks off the edges of the level (even at negative
+ * coordinates) work just like the ones in it, so objects that leave the level keep
+ * colliding with each other. newBroadphase() picks the block size from the sizes of the level's objects
+ * so that nearly all of them fit in a block.
  *
  * While running the level, each object will update and if that object has moved,
- * it will remove itself from its objGroup and re-adds itself to the collisionMatrix
- * which will put it in its proper objGroup.
+ * the level asks the collisionMatrix to move it. If it has crossed into another
+ * block it is unlinked from its old objGroup and linked into the new one, both of
+ * which are constant time operations. An objGroup that ends up empty is put aside to
+ * be reused for the next block that needs one.
  *
  * When it comes time to check for collisions, the object will check for collisions
  * between itself and the objects in the objGroups above, to the the left, and to the
  * upper left of its own objGroup. Because each group represents a square of the screen
- * at least as large as the largest object and each object's position is its top-left
+ * as large as any object kept in one and each object's position is its top-left
  * pixel, no object outside these four objGroups could possibly be interacting with
  * the object in question. This will cut the number of collision detections down from
  * hundreds or thousands to maybe tens per moving object. Much better.
  *
+ * The few objects that don't fit in a block (a boss, a long platform) can't be found
+ * that way, so they're kept in a bigObject instead and listed in every block their
+ * bounding box overlaps. A pair that shares more than one block is only reported from
+ * the top-left block they have in common so it still only comes up once.
+ *
+ * Neighbourhoods hardly change from one frame to the next, so the matrix keeps every
+ * object's list of nearby objects (everything in the blocks around it) from frame to
+ * frame. A list is only rebuilt when its object crosses into another block, or when
+ * a big object's range of blocks changes. findPairs then walks only the lists of the
+ * objects that were inserted or updated since the last findPairs. A dense scene where
+ * things move slowly costs about as much as what changed, not as much as everything
+ * in it.
+ *
  * @see object.h
  * @author Joe Balough
  */
@@ -51,38 +71,122 @@
 #include <vector>
 #include "object.h"
 #include "vector.h"
+#include "broadphase.h"
 
 using namespace std;
 
+// The range of block sizes chooseBlockSize picks from, in pixels. Always a power of two.
+#define ZBE_GRID_MIN_BLOCK 16
+#define ZBE_GRID_MAX_BLOCK 256
+
+// The block size used when there's nothing to go on
+#define ZBE_GRID_DEFAULT_BLOCK 64
+
+// How many percent of the objects a block should be big enough for
+#define ZBE_GRID_FIT_PERCENT 90
+
+// The most hash buckets a collisionMatrix starts with. It doubles them whenever there
+// are more occupied blocks than buckets. Always a power of two.
+#define ZBE_GRID_START_BUCKETS 64
+
 // TODO: Though I have this coded and implemented and everything, I haven't really
 //       fully tested it. I need to make sure that everything is working correctly here.
 
 
+/**
+ * bigObject struct
+ *
+ * An object whose bounding box is bigger than a block, along with the range of
+ * blocks it's listed in.
+ *
+ * @author Joe Balough
+ */
+struct bigObject
+{
+	object *obj;
+
+	// The first and last block it overlaps on each axis. Empty (minX > maxX) until
+	// it's first placed.
+	int minX, minY, maxX, maxY;
+};
+
+
 /**
  * objGroup class
  *
- * The objGroup class is used to simply keep a vector of pointers to objects that
+ * The objGroup class is used to simply keep a list of pointers to objects that
  * are in a discrete region of the level. Used for good performance with collision
  * detection.
  *
+ * The list is intrusive: the links live in the objects themselves (object::group,
+ * object::groupPrev and object::groupNext) so adding and removing never allocates
+ * or searches. Walk it like so:
+ *   for (object *o = group->first; o; o = o->groupNext)
+ *
  * @author Joe Balough
  */
 struct objGroup
 {
-	vector<object*> objects;
+	/**
+	 * objGroup constructor
+	 *
+	 * Starts the group off empty.
+	 *
+	 * @author Joe Balough
+	 */
+	objGroup()
+	{
+		first = NULL;
+		numObjects = 0;
+		x = y = 0;
+		hashNext = NULL;
+		slot = 0;
+	}
+
+	/**
+	 * add function
+	 *
+	 * Links passed object into the front of this group's list. The object must
+	 * not currently be in any other group.
+	 *
+	 * @param object *add
+	 *   A pointer to the object to add to the group
+	 * @author Joe Balough
+	 */
+	void add(object *add);
 
 	/**
 	 * remove function
 	 *
-	 * Removes passed object from the vector.
+	 * Unlinks passed object from this group's list.
 	 *
 	 * @param object *remove
-	 *   A pointer to the object to remove from the vector
+	 *   A pointer to the object to remove from the group
 	 * @return bool
-	 *   Whether or not the object was successfully removed
+	 *   Whether or not the object was successfully removed. False if the object
+	 *   was not in this group.
 	 * @author Joe Balough
 	 */
 	bool remove(object *remove);
+
+	// The first object in the list or NULL if the group is empty
+	object *first;
+
+	// How many objects are currently in the list
+	unsigned int numObjects;
+
+	// The objects too big for a block that overlap this one. They're listed in
+	// every group they overlap, not linked through the object.
+	vector<bigObject*> big;
+
+	// The block this group is for
+	int x, y;
+
+	// The next group in the same hash bucket
+	objGroup *hashNext;
+
+	// Where this group is in the collisionMatrix's list of occupied groups
+	unsigned int slot;
 };
 
 
@@ -91,23 +195,22 @@ struct objGroup
  *
  * The collisionMatrix class is used to manage all of the objGroups. It will create
  * and delete them and provides many useful utility functions for adding objects to
- * groups and the like.
+ * groups and the like. It is the ZBE_BROADPHASE_GRID broadphase engine.
  *
- * @todo Add 4 additional objGroups to the collisionMatrix: above, below, left, and
- *  right to hold the objects that are out of the level bounds.
  * @author Joe Balough
  */
-class collisionMatrix
+class collisionMatrix : public broadphase
 {
 public:
 	/**
 	 * collisionMatrix constructor
 	 *
 	 * Initializes the collisionMatrix for use with a level with the dimesions
-	 * indicated.
+	 * indicated. No objGroups are made until something is added.
 	 *
 	 * @param int levelWidth, int levelHeight
-	 *   The width and height of the whole level in pixels
+	 *   The width and height of the whole level in pixels. Only used to keep the
+	 *   hash table small for small levels; objects can go anywhere.
 	 * @param int blockSqSize
 	 *   The width and height of the blocks into which the level's objects should
 	 *   be broken down in order to fit into objGroups
@@ -115,10 +218,40 @@ public:
 	 */
 	collisionMatrix(int levelWidth, int levelHeight, int blockSqSize);
 
+	/**
+	 * chooseBlockSize function
+	 *
+	 * Picks the block size for a level from how big its objects are. It's the
+	 * smallest power of two that ZBE_GRID_FIT_PERCENT of the objects fit in,
+	 * between ZBE_GRID_MIN_BLOCK and ZBE_GRID_MAX_BLOCK. Smaller blocks mean
+	 * fewer candidates per block, and the odd object that doesn't fit is just
+	 * listed in more than one.
+	 *
+	 * @param vector<int> &extents
+	 *   How far each object reaches from its position, the bigger of its width
+	 *   and height. Gets reordered.
+	 * @return int
+	 *   The block size in pixels
+	 * @author Joe Balough
+	 */
+	static int chooseBlockSize(vector<int> &extents);
+
+	/**
+	 * getBlockSize function
+	 *
+	 * @return int
+	 *   The width and height of each block in pixels
+	 * @author Joe Balough
+	 */
+	inline int getBlockSize()
+	{
+		return blockSqSize;
+	}
+
 	/**
 	 * collisionMatrix deconstructor
 	 *
-	 * Frees the memory allocted for the objGroups
+	 * Frees the memory allocted for the objGroups and big objects
 	 *
 	 * @author Joe Balough
 	 */
@@ -129,13 +262,13 @@ public:
 	 *
 	 * Will get the correct objGroup for the passed coordinates
 	 *
-	 * @param vector2D<float> position
+	 * @param vector2D<fixed32> position
 	 *   The position of the object whose objGroup is wanted.
-	 * @return a pointer to the desired objGroup or NULL if parameters
-	 *   out of bounds
+	 * @return a pointer to the desired objGroup or NULL if there's nothing
+	 *   in that block
 	 * @author Joe Balough
 	 */
-	objGroup *getObjGroup(vector2D<float> position);
+	objGroup *getObjGroup(vector2D<fixed32> position);
 
 	/**
 	 * addObject function
@@ -145,49 +278,967 @@ public:
 	 * @param object *add
 	 *   A pointer to the object to add to the matrix
 	 * @return
-	 *   A pointer to the objGroup into which it was added or NULL if position
-	 *   was out of scope.
+	 *   A pointer to the objGroup into which it was added. Objects too big for a
+	 *   block return the top-left group they were listed in.
 	 * @author Joe Balough
 	 */
 	objGroup* addObject(object *add);
 
+	/**
+	 * moveObject function
+	 *
+	 * Should be called after an object has moved. Finds the objGroup for the
+	 * object's new position and, if it differs from the one the object is in,
+	 * moves the object into it. Does nothing if the object stayed in its block.
+	 * Objects that grew too big for a block (or shrank back to fit in one) are
+	 * switched over here too.
+	 *
+	 * @param object *move
+	 *   A pointer to the object that moved
+	 * @return
+	 *   A pointer to the objGroup the object is now in. Objects too big for a
+	 *   block return the top-left group they're listed in.
+	 * @author Joe Balough
+	 */
+	objGroup* moveObject(object *move);
+
+	/**
+	 * removeObject function
+	 *
+	 * Takes an object out of whatever objGroup it is in. The group is put aside
+	 * if that leaves it empty.
+	 *
+	 * @param object *remove
+	 *   A pointer to the object to remove from the matrix
+	 * @return bool
+	 *   Whether or not the object was in the matrix
+	 * @author Joe Balough
+	 */
+	virtual bool removeObject(object *remove);
+
+	/**
+	 * insertObject function
+	 *
+	 * broadphase interface for addObject
+	 *
+	 * @param object *add
+	 *   A pointer to the object to add to the matrix
+	 * @author Joe Balough
+	 */
+	virtual void insertObject(object *add)
+	{
+		addObject(add);
+		queueChanged(add);
+	}
+
+	/**
+	 * updateObject function
+	 *
+	 * broadphase interface for moveObject
+	 *
+	 * @param object *move
+	 *   A pointer to the object that moved
+	 * @author Joe Balough
+	 */
+	virtual void updateObject(object *move)
+	{
+		moveObject(move);
+		queueChanged(move);
+	}
+
+	/**
+	 * findPairs function
+	 *
+	 * broadphase interface for the pair cache. Walks the nearby objects of every
+	 * object that was inserted or updated since the last findPairs and moved this
+	 * frame. A pair where both moved is only reported from the one with the lower id.
+	 * Gives the same pairs as forEachPair with a movedPairCollector, but only costs as
+	 * much as the objects that moved.
+	 *
+	 * @param vector<bool> &objMoved
+	 *   Indexed by object id, whether or not that object moved this frame
+	 * @param vector<objPair> &pairs
+	 *   The vector to append the pairs to
+	 * @return unsigned int
+	 *   The number of cached pairs that were looked at
+	 * @author Joe Balough
+	 */
+	virtual unsigned int findPairs(vector<bool> &objMoved, vector<objPair> &pairs);
+
+	/**
+	 * findCandidates function
+	 *
+	 * broadphase interface for queryRegion
+	 *
+	 * @param vector2D<fixed32> min, vector2D<fixed32> max
+	 *   The top-left and bottom-right corners of the region
+	 * @param vector<object*> &found
+	 *   The vector to append the objects to
+	 * @author Joe Balough
+	 */
+	virtual void findCandidates(vector2D<fixed32> min, vector2D<fixed32> max, vector<object*> &found);
+
+	/**
+	 * queryRegion function
+	 *
+	 * Calls visit(object*) for every object whose bounding box overlaps the
+	 * region. Walks the objGroups under the region, plus one more row and column
+	 * up and to the left since objects are binned by their position. Objects too
+	 * big for a block are only visited once no matter how many of those groups
+	 * they're in. If visit returns false, the query stops.
+	 *
+	 * The visitor must not move anything in the matrix until the query is over.
+	 *
+	 * @param vector2D<fixed32> min, vector2D<fixed32> max
+	 *   The top-left and bottom-right corners of the region
+	 * @param Visitor &visit
+	 *   Anything that can be called like bool visit(object *found)
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	void queryRegion(vector2D<fixed32> min, vector2D<fixed32> max, Visitor &visit)
+	{
+		int minX = blockOf(min.x) - 1, minY = blockOf(min.y) - 1;
+		int maxX = blockOf(max.x), maxY = blockOf(max.y);
+
+		// Big regions have more blocks than there are groups, so just look at every group
+		if ((maxX - minX + 1) * (maxY - minY + 1) > (int) occupied.size())
+		{
+			for (unsigned int i = 0; i < occupied.size(); i++)
+			{
+				objGroup *group = occupied[i];
+				if (group->x >= minX && group->x <= maxX && group->y >= minY && group->y <= maxY &&
+				    !visitRegionGroup(group, minX, minY, min, max, visit))
+					return;
+			}
+			return;
+		}
+
+		for (int x = minX; x <= maxX; x++)
+		{
+			for (int y = minY; y <= maxY; y++)
+			{
+				objGroup *group = findGroup(x, y);
+				if (group && !visitRegionGroup(group, minX, minY, min, max, visit))
+					return;
+			}
+		}
+	}
+
+	/**
+	 * rayCast function
+	 *
+	 * Calls visit(object*) for every object whose bounding box is crossed by the
+	 * line segment from start to end. Only the blocks the segment passes through
+	 * are looked at, one after the other from start to end (a grid DDA), so a
+	 * short cast only costs a few groups however many objects the level has.
+	 * Objects are visited block by block in the order the segment reaches them,
+	 * but not sorted within a block. If visit returns false, the cast stops.
+	 *
+	 * The visitor must not move anything in the matrix until the cast is over.
+	 *
+	 * @param vector2D<fixed32> start, vector2D<fixed32> end
+	 *   The two ends of the segment
+	 * @param Visitor &visit
+	 *   Anything that can be called like bool visit(object *hit)
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	void rayCast(vector2D<fixed32> start, vector2D<fixed32> end, Visitor &visit)
+	{
+		vector2D<fixed32> delta = end - start;
+		int x = blockOf(start.x), y = blockOf(start.y);
+		int endX = blockOf(end.x), endY = blockOf(end.y);
+		int stepX = (endX > x) ? 1 : -1;
+		int stepY = (endY > y) ? 1 : -1;
+
+		// How far the segment has to go on each axis to get to the next block and
+		// how far it goes in all, as raw fixed32 values so they can be compared
+		// without dividing
+		int64 blockRaw = fixed32(blockSqSize).getRaw();
+		int64 toEdgeX = (stepX > 0) ? fixed32((x + 1) * blockSqSize).getRaw() - start.x.getRaw() : start.x.getRaw() - fixed32(x * blockSqSize).getRaw();
+		int64 toEdgeY = (stepY > 0) ? fixed32((y + 1) * blockSqSize).getRaw() - start.y.getRaw() : start.y.getRaw() - fixed32(y * blockSqSize).getRaw();
+		int64 lengthX = abs(delta.x).getRaw(), lengthY = abs(delta.y).getRaw();
+
+		bool first = true;
+		int prevX = x, prevY = y;
+		while (visitRayBlock(x, y, first, prevX, prevY, start, delta, visit))
+		{
+			if (x == endX && y == endY)
+				return;
+
+			first = false;
+			prevX = x;
+			prevY = y;
+
+			// Go into whichever block the segment gets to first
+			bool alongX;
+			if (x == endX)
+				alongX = false;
+			else if (y == endY)
+				alongX = true;
+			else
+				alongX = toEdgeX * lengthY < toEdgeY * lengthX;
+
+			if (alongX)
+			{
+				x += stepX;
+				toEdgeX += blockRaw;
+			}
+			else
+			{
+				y += stepY;
+				toEdgeY += blockRaw;
+			}
+		}
+	}
+
+	/**
+	 * findNearest function
+	 *
+	 * Finds the object whose bounding box is closest to a position. The blocks
+	 * around the position are searched in rings going out from it, and the
+	 * search stops once no block in the next ring can hold anything closer than
+	 * what's been found.
+	 *
+	 * accept(object*) is only asked about objects closer than the best one so
+	 * far and can be used to skip the object doing the looking, objects on the
+	 * wrong collision layers and the like.
+	 *
+	 * @param vector2D<fixed32> position
+	 *   Where to look from
+	 * @param fixed32 maxDistance
+	 *   How far away to look in pixels
+	 * @param Filter &accept
+	 *   Anything that can be called like bool accept(object *candidate)
+	 * @return object*
+	 *   The nearest accepted object or NULL if there isn't one within maxDistance
+	 * @author Joe Balough
+	 */
+	template <typename Filter>
+	object *findNearest(vector2D<fixed32> position, fixed32 maxDistance, Filter &accept)
+	{
+		int x = blockOf(position.x), y = blockOf(position.y);
+
+		// An object binned in a block r rings out can reach back to within r - 2
+		// blocks of the position
+		int rings = maxDistance.toInt() / blockSqSize + 2;
+
+		object *best = NULL;
+		int64 maxRaw = maxDistance.getRaw();
+		int64 bestDistance = maxRaw * maxRaw + 1;
+
+		// Far searches have more blocks than there are groups, so just look at every group
+		if ((2 * rings + 1) * (2 * rings + 1) > (int) occupied.size())
+		{
+			for (unsigned int i = 0; i < occupied.size(); i++)
+			{
+				objGroup *group = occupied[i];
+				if (group->x >= x - rings && group->x <= x + rings && group->y >= y - rings && group->y <= y + rings)
+					nearestInGroup(group, x, y, position, accept, best, bestDistance);
+			}
+			return best;
+		}
+
+		for (int r = 0; r <= rings; r++)
+		{
+			// Nothing in this ring or past it can be closer than what's been found
+			if (best && r >= 2)
+			{
+				int64 closest = fixed32((r - 2) * blockSqSize).getRaw();
+				if (closest * closest >= bestDistance)
+					break;
+			}
+
+			// Only the top and bottom blocks of the columns between the ends are in the ring
+			for (int nx = x - r; nx <= x + r; nx++)
+			{
+				int stepY = (nx == x - r || nx == x + r) ? 1 : 2 * r;
+				for (int ny = y - r; ny <= y + r; ny += stepY)
+					nearestInGroup(findGroup(nx, ny), x, y, position, accept, best, bestDistance);
+			}
+		}
+
+		return best;
+	}
+
+	/**
+	 * forEachCandidate function
+	 *
+	 * Takes a position and calls visit(object*) once for every object that
+	 * MIGHT be colliding with an object at these coordinates. Walks the
+	 * objGroup for that position and its (up to) eight neighbours in place so
+	 * nothing is copied or allocated.
+	 *
+	 * Objects too big for a block are visited once, from the first of these
+	 * groups they're in.
+	 *
+	 * The visitor may move or remove the candidate it was just handed, unless
+	 * it's too big for a block, but must not move any other object in the
+	 * matrix until the walk is over.
+	 *
+	 * @param vector2D<fixed32> position
+	 *   The position at which collisions are being looked for
+	 * @param Visitor &visit
+	 *   Anything that can be called like visit(object *candidate)
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	void forEachCandidate(vector2D<fixed32> position, Visitor &visit)
+	{
+		vector2D<int> coords = convertCoords(position);
+
+		// The top-left group of the neighbourhood, where big objects that reach
+		// into more than one of these groups are visited from
+		int left = coords.x - 1;
+		int top = coords.y - 1;
+
+		// This group first, then the neighbours clockwise starting from the left
+		static const int dx[9] = {0, -1, -1,  0,  1, 1, 1, 0, -1};
+		static const int dy[9] = {0,  0, -1, -1, -1, 0, 1, 1,  1};
+		for (int n = 0; n < 9; n++)
+		{
+			// Skip the blocks with nothing in them
+			int x = coords.x + dx[n];
+			int y = coords.y + dy[n];
+			objGroup *group = findGroup(x, y);
+			if (!group)
+				continue;
+
+			// The big objects that are first listed in this group go first. Moving
+			// the last normal object out can hand this group to another block.
+			vector<bigObject*> &big = group->big;
+			for (unsigned int b = 0; b < big.size(); b++)
+			{
+				if (x == (big[b]->minX > left ? big[b]->minX : left) &&
+				    y == (big[b]->minY > top ? big[b]->minY : top))
+					visit(big[b]->obj);
+			}
+
+			// Grab the next link first in case the visitor moves this one
+			object *next;
+			for (object *o = group->first; o; o = next)
+			{
+				next = o->groupNext;
+				visit(o);
+			}
+		}
+	}
+
+	/**
+	 * forEachPair function
+	 *
+	 * Calls visit(object*, object*) exactly once for every pair of objects that
+	 * MIGHT be colliding anywhere in the matrix. Each occupied objGroup is paired
+	 * with itself and only the half of its neighbours that come after it (right,
+	 * down-left, down, and down-right) so no pair is ever reported twice.
+	 * Objects too big for a block are paired by pairBig.
+	 *
+	 * The visitor must not move anything in the matrix; collect the pairs and
+	 * resolve them once the sweep is over.
+	 *
+	 * @param Visitor &visit
+	 *   Anything that can be called like visit(object *a, object *b)
+	 * @return unsigned int
+	 *   The number of pairs that were visited
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	unsigned int forEachPair(Visitor &visit)
+	{
+		unsigned int numPairs = 0;
+
+		for (unsigned int i = 0; i < occupied.size(); i++)
+		{
+			objGroup *group = occupied[i];
+			int x = group->x, y = group->y;
+
+			// Pairs within this group
+			for (object *a = group->first; a; a = a->groupNext)
+			{
+				for (object *b = a->groupNext; b; b = b->groupNext)
+				{
+					visit(a, b);
+					numPairs++;
+				}
+			}
+
+			// Pairs with the forward half of the neighbourhood
+			if (group->first)
+			{
+				numPairs += pairGroups(group, findGroup(x + 1, y), visit);
+				numPairs += pairGroups(group, findGroup(x - 1, y + 1), visit);
+				numPairs += pairGroups(group, findGroup(x, y + 1), visit);
+				numPairs += pairGroups(group, findGroup(x + 1, y + 1), visit);
+			}
+
+			// Pairs with the big objects in this group
+			if (!group->big.empty())
+				numPairs += pairBig(group, visit);
+		}
+
+		return numPairs;
+	}
+
 	/**
 	 * getCollisionCandidates function
 	 *
 	 * Takes a position and returns an array full of pointers of all of the
 	 * objects that MIGHT be colliding with an object at these coordinates.
-	 * Takes the object pointers from a region of the nearest 4 objGroups
+	 * Takes the object pointers from a region of the nearest 9 objGroups
 	 * and adds them together for the return.
 	 *
-	 * @param vector2D<float> position
+	 * This allocates; anything run every frame should use forEachCandidate.
+	 *
+	 * @param vector2D<fixed32> position
 	 *   The position at which collisions are being looked for
 	 * @return vector<object*>
 	 *   A vector of object pointers that may be colliding with an object
 	 *   at position
 	 * @author Joe Balough
 	 */
-	vector<object*> getCollisionCandidates(vector2D<float> position);
+	vector<object*> getCollisionCandidates(vector2D<fixed32> position);
 
 private:
+	/**
+	 * pairGroups function
+	 *
+	 * Calls visit(a, b) for every object a in group1 and b in group2
+	 *
+	 * @param objGroup *group1, objGroup *group2
+	 *   The two (different) groups to pair up. group2 can be NULL.
+	 * @param Visitor &visit
+	 *   The forEachPair visitor
+	 * @return unsigned int
+	 *   The number of pairs that were visited
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	inline unsigned int pairGroups(objGroup *group1, objGroup *group2, Visitor &visit)
+	{
+		if (!group2)
+			return 0;
+		for (object *a = group1->first; a; a = a->groupNext)
+			for (object *b = group2->first; b; b = b->groupNext)
+				visit(a, b);
+		return group1->numObjects * group2->numObjects;
+	}
+
+	/**
+	 * pairBig function
+	 *
+	 * Calls visit(a, b) for the pairs between the big objects listed in a group
+	 * and everything else that might be touching them there. A pair is only
+	 * visited from the top-left group both of them can reach, so one that
+	 * shares several groups still comes up once. A normal object can reach its
+	 * own block and the ones right, down, and down-right of it, so those in
+	 * this group and the three up and to the left are looked at.
+	 *
+	 * @param objGroup *group
+	 *   The group whose big objects to pair up
+	 * @param Visitor &visit
+	 *   The forEachPair visitor
+	 * @return unsigned int
+	 *   The number of pairs that were visited
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	unsigned int pairBig(objGroup *group, Visitor &visit)
+	{
+		unsigned int numPairs = 0;
+		int x = group->x, y = group->y;
+		vector<bigObject*> &big = group->big;
+
+		for (unsigned int i = 0; i < big.size(); i++)
+		{
+			bigObject *a = big[i];
+
+			// The other big objects listed here
+			for (unsigned int j = i + 1; j < big.size(); j++)
+			{
+				bigObject *b = big[j];
+				if (x == (a->minX > b->minX ? a->minX : b->minX) &&
+				    y == (a->minY > b->minY ? a->minY : b->minY))
+				{
+					visit(a->obj, b->obj);
+					numPairs++;
+				}
+			}
+
+			// The normal objects that can reach into this group
+			for (int nx = x - 1; nx <= x; nx++)
+			{
+				for (int ny = y - 1; ny <= y; ny++)
+				{
+					if (x != (nx > a->minX ? nx : a->minX) || y != (ny > a->minY ? ny : a->minY))
+						continue;
+
+					objGroup *near = findGroup(nx, ny);
+					if (!near)
+						continue;
+					for (object *o = near->first; o; o = o->groupNext)
+					{
+						visit(a->obj, o);
+						numPairs++;
+					}
+				}
+			}
+		}
+
+		return numPairs;
+	}
+
+	/**
+	 * fitsInBlock function
+	 *
+	 * @param object *obj
+	 *   The object to check
+	 * @return bool
+	 *   Whether or not the object's bounding box fits in a block from its
+	 *   position, which is all the normal objGroup search can find
+	 * @author Joe Balough
+	 */
+	inline bool fitsInBlock(object *obj)
+	{
+		if (!obj->frame)
+			return true;
+		return obj->boxLeft(obj->frame->topleft.x, obj->frame->dimensions.x) + obj->frame->dimensions.x <= blockSqSize &&
+		       obj->frame->topleft.y + obj->frame->dimensions.y <= blockSqSize;
+	}
+
+	/**
+	 * findBig function
+	 *
+	 * @param object *obj
+	 *   The object to look for
+	 * @return bigObject*
+	 *   The obj's bigObject or NULL if it isn't a big object
+	 * @author Joe Balough
+	 */
+	bigObject *findBig(object *obj);
+
+	/**
+	 * placeBig function
+	 *
+	 * Lists a big object in every group its bounding box overlaps, taking it out
+	 * of the ones it doesn't overlap anymore.
+	 *
+	 * @param object *obj
+	 *   The object to place
+	 * @param bigObject *big
+	 *   The object's bigObject or NULL to make a new one
+	 * @return objGroup*
+	 *   The top-left group it's listed in
+	 * @author Joe Balough
+	 */
+	objGroup *placeBig(object *obj, bigObject *big);
+
+	/**
+	 * unlistBig function
+	 *
+	 * Takes a big object out of every group it's listed in
+	 *
+	 * @param bigObject *big
+	 *   The object to unlist
+	 * @author Joe Balough
+	 */
+	void unlistBig(bigObject *big);
+
+	/**
+	 * dropBig function
+	 *
+	 * Unlists a big object and deletes its bigObject
+	 *
+	 * @param bigObject *big
+	 *   The object to drop
+	 * @author Joe Balough
+	 */
+	void dropBig(bigObject *big);
+
+	/**
+	 * visitRegionGroup function
+	 *
+	 * queryRegion's work for one group: visits the objects in it that overlap the
+	 * region, and the big objects that are first listed in it.
+	 *
+	 * @param objGroup *group
+	 *   The group to look in
+	 * @param int minX, int minY
+	 *   The top-left block queryRegion is looking at
+	 * @param vector2D<fixed32> &min, vector2D<fixed32> &max
+	 *   The region
+	 * @param Visitor &visit
+	 *   The queryRegion visitor
+	 * @return bool
+	 *   False if the visitor wants the query to stop
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	bool visitRegionGroup(objGroup *group, int minX, int minY, const vector2D<fixed32> &min, const vector2D<fixed32> &max, Visitor &visit)
+	{
+		for (object *o = group->first; o; o = o->groupNext)
+		{
+			vector2D<fixed32> objMin, objMax;
+			getBounds(o, objMin, objMax);
+			if (objMax.x < min.x || max.x < objMin.x || objMax.y < min.y || max.y < objMin.y)
+				continue;
+
+			if (!visit(o))
+				return false;
+		}
+
+		// Big objects are only looked at from the first of these blocks they're in
+		for (unsigned int i = 0; i < group->big.size(); i++)
+		{
+			bigObject *big = group->big[i];
+			if (group->x != (big->minX > minX ? big->minX : minX) ||
+			    group->y != (big->minY > minY ? big->minY : minY))
+				continue;
+
+			vector2D<fixed32> objMin, objMax;
+			getBounds(big->obj, objMin, objMax);
+			if (objMax.x < min.x || max.x < objMin.x || objMax.y < min.y || max.y < objMin.y)
+				continue;
+
+			if (!visit(big->obj))
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * visitRayBlock function
+	 *
+	 * rayCast's work for one block the segment passes through. A normal object
+	 * can reach into a block from its own group or the three up and to the left,
+	 * so those are looked at, skipping any the previous block could reach too
+	 * since they were looked at from there. The segment never turns back, so
+	 * once it leaves the blocks an object can reach it's done with that object.
+	 * For the same reason, big objects are looked at from the first block of
+	 * theirs the segment gets to.
+	 *
+	 * @param int x, int y
+	 *   The block
+	 * @param bool first
+	 *   Whether or not this is the first block of the cast
+	 * @param int prevX, int prevY
+	 *   The block looked at before this one
+	 * @param vector2D<fixed32> &start, vector2D<fixed32> &delta
+	 *   Where the segment starts and how far it goes
+	 * @param Visitor &visit
+	 *   The rayCast visitor
+	 * @return bool
+	 *   False if the visitor wants the cast to stop
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	bool visitRayBlock(int x, int y, bool first, int prevX, int prevY, const vector2D<fixed32> &start, const vector2D<fixed32> &delta, Visitor &visit)
+	{
+		for (int nx = x - 1; nx <= x; nx++)
+		{
+			for (int ny = y - 1; ny <= y; ny++)
+			{
+				if (!first && prevX - nx >= 0 && prevX - nx <= 1 && prevY - ny >= 0 && prevY - ny <= 1)
+					continue;
+
+				objGroup *group = findGroup(nx, ny);
+				if (!group)
+					continue;
+				for (object *o = group->first; o; o = o->groupNext)
+				{
+					vector2D<fixed32> objMin, objMax;
+					getBounds(o, objMin, objMax);
+					if (segmentHits(start, delta, objMin, objMax) && !visit(o))
+						return false;
+				}
+			}
+		}
+
+		objGroup *group = findGroup(x, y);
+		if (!group)
+			return true;
+		for (unsigned int i = 0; i < group->big.size(); i++)
+		{
+			bigObject *big = group->big[i];
+			if (!first && prevX >= big->minX && prevX <= big->maxX && prevY >= big->minY && prevY <= big->maxY)
+				continue;
+
+			vector2D<fixed32> objMin, objMax;
+			getBounds(big->obj, objMin, objMax);
+			if (segmentHits(start, delta, objMin, objMax) && !visit(big->obj))
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * nearestInGroup function
+	 *
+	 * findNearest's work for one group. Big objects are only looked at from the
+	 * block of theirs closest to the one findNearest started in.
+	 *
+	 * @param objGroup *group
+	 *   The group to look in. Can be NULL.
+	 * @param int x, int y
+	 *   The block findNearest started in
+	 * @param vector2D<fixed32> &position
+	 *   Where findNearest is looking from
+	 * @param Filter &accept
+	 *   The findNearest filter
+	 * @param object *&best
+	 *   The nearest object so far, replaced if one in this group is closer
+	 * @param int64 &bestDistance
+	 *   The squared distance to best as a raw fixed32 value
+	 * @author Joe Balough
+	 */
+	template <typename Filter>
+	void nearestInGroup(objGroup *group, int x, int y, const vector2D<fixed32> &position, Filter &accept, object *&best, int64 &bestDistance)
+	{
+		if (!group)
+			return;
+
+		for (object *o = group->first; o; o = o->groupNext)
+			considerNearest(o, position, accept, best, bestDistance);
+
+		for (unsigned int i = 0; i < group->big.size(); i++)
+		{
+			bigObject *big = group->big[i];
+			int closestX = (x < big->minX) ? big->minX : (x > big->maxX) ? big->maxX : x;
+			int closestY = (y < big->minY) ? big->minY : (y > big->maxY) ? big->maxY : y;
+			if (group->x == closestX && group->y == closestY)
+				considerNearest(big->obj, position, accept, best, bestDistance);
+		}
+	}
+
+	/**
+	 * considerNearest function
+	 *
+	 * Makes an object findNearest's best so far if it's closer than best and
+	 * accept takes it.
+	 *
+	 * @see nearestInGroup
+	 * @author Joe Balough
+	 */
+	template <typename Filter>
+	inline void considerNearest(object *obj, const vector2D<fixed32> &position, Filter &accept, object *&best, int64 &bestDistance)
+	{
+		vector2D<fixed32> objMin, objMax;
+		getBounds(obj, objMin, objMax);
+
+		// How far outside the box the position is on each axis
+		int64 dx = 0, dy = 0;
+		if (position.x < objMin.x)
+			dx = (objMin.x - position.x).getRaw();
+		else if (position.x > objMax.x)
+			dx = (position.x - objMax.x).getRaw();
+		if (position.y < objMin.y)
+			dy = (objMin.y - position.y).getRaw();
+		else if (position.y > objMax.y)
+			dy = (position.y - objMax.y).getRaw();
+
+		int64 distance = dx * dx + dy * dy;
+		if (distance < bestDistance && accept(obj))
+		{
+			best = obj;
+			bestDistance = distance;
+		}
+	}
+
+	/**
+	 * nearOf function
+	 *
+	 * @param object *obj
+	 *   The object
+	 * @return vector<object*>&
+	 *   The cached list of objects near obj, made room for if needed
+	 * @author Joe Balough
+	 */
+	inline vector<object*> &nearOf(object *obj)
+	{
+		unsigned int id = obj->getObjectId();
+		if (id >= near.size())
+			near.resize(id + 1);
+		return near[id];
+	}
+
+	/**
+	 * linkNear function
+	 *
+	 * Puts two objects in each other's lists of nearby objects
+	 *
+	 * @param object *a, object *b
+	 *   The two objects
+	 * @author Joe Balough
+	 */
+	inline void linkNear(object *a, object *b)
+	{
+		nearOf(a).push_back(b);
+		nearOf(b).push_back(a);
+	}
+
+	/**
+	 * cachePairs function
+	 *
+	 * Fills the list of nearby objects for an object that was just linked into a
+	 * group: the objects in its group and the eight around it, and the big objects
+	 * listed in the blocks it can reach.
+	 *
+	 * @param object *obj
+	 *   The object, which must be in a group and have an empty list
+	 * @author Joe Balough
+	 */
+	void cachePairs(object *obj);
+
+	/**
+	 * cacheBigPairs function
+	 *
+	 * Fills the list of nearby objects for a big object that was just listed in its
+	 * blocks: the objects that can reach into them and the other big objects listed
+	 * in them.
+	 *
+	 * @param bigObject *big
+	 *   The big object, which must have an empty list
+	 * @author Joe Balough
+	 */
+	void cacheBigPairs(bigObject *big);
+
+	/**
+	 * uncachePairs function
+	 *
+	 * Takes an object out of the lists of everything near it and empties its own
+	 *
+	 * @param object *obj
+	 *   The object
+	 * @author Joe Balough
+	 */
+	void uncachePairs(object *obj);
+
+	/**
+	 * queueChanged function
+	 *
+	 * Remembers that an object was inserted or updated so the next findPairs looks at it
+	 *
+	 * @param object *obj
+	 *   The object
+	 * @author Joe Balough
+	 */
+	inline void queueChanged(object *obj)
+	{
+		unsigned int id = obj->getObjectId();
+		if (id >= isChanged.size())
+			isChanged.resize(id + 1, false);
+		if (isChanged[id])
+			return;
+		isChanged[id] = true;
+		changed.push_back(obj);
+	}
+
+	/**
+	 * hashBlock function
+	 *
+	 * @param int x, int y
+	 *   The block coordinates
+	 * @return unsigned int
+	 *   Which hash bucket that block's group goes in
+	 * @author Joe Balough
+	 */
+	inline unsigned int hashBlock(int x, int y)
+	{
+		return (((unsigned int) x * 73856093u) ^ ((unsigned int) y * 19349663u)) & (buckets.size() - 1);
+	}
+
+	/**
+	 * findGroup function
+	 *
+	 * @param int x, int y
+	 *   The block coordinates
+	 * @return objGroup*
+	 *   The group for that block or NULL if it doesn't have one
+	 * @author Joe Balough
+	 */
+	inline objGroup *findGroup(int x, int y)
+	{
+		for (objGroup *group = buckets[hashBlock(x, y)]; group; group = group->hashNext)
+			if (group->x == x && group->y == y)
+				return group;
+		return NULL;
+	}
+
+	/**
+	 * makeGroup function
+	 *
+	 * @param int x, int y
+	 *   The block coordinates
+	 * @return objGroup*
+	 *   The group for that block, which is made (or reused) if it didn't have one
+	 * @author Joe Balough
+	 */
+	objGroup *makeGroup(int x, int y);
+
+	/**
+	 * releaseGroup function
+	 *
+	 * Puts a group aside to be reused if it's empty. Does nothing otherwise.
+	 *
+	 * @param objGroup *group
+	 *   The group that something was just taken out of
+	 * @author Joe Balough
+	 */
+	void releaseGroup(objGroup *group);
+
+	/**
+	 * blockOf function
+	 *
+	 * @param fixed32 coord
+	 *   A world coordinate
+	 * @return int
+	 *   The block that coordinate is in, rounding down so negative ones work too
+	 * @author Joe Balough
+	 */
+	inline int blockOf(fixed32 coord)
+	{
+		int pixel = coord.toInt();
+		return pixel >= 0 ? pixel / blockSqSize : -((-pixel - 1) / blockSqSize) - 1;
+	}
+
 	/**
 	 * convertCoords function
 	 *
 	 * Takes a world coordinate position and converts it to a objGroup position
 	 *
-	 * @param vector2D<float> position
+	 * @param vector2D<fixed32> position
 	 *   The position to convert in world coordinates
 	 * @return vector2D<int>
-	 *   objGroup coordinates. If either is -1, input position was out of bounds
+	 *   objGroup coordinates
 	 * @author Joe Balough
 	 */
-	vector2D<int> convertCoords(vector2D<float> position);
+	inline vector2D<int> convertCoords(vector2D<fixed32> position)
+	{
+		return vector2D<int>(blockOf(position.x), blockOf(position.y));
+	}
+
+	// The hash table of occupied groups. Each bucket is a list linked through
+	// objGroup::hashNext. Its size is always a power of two.
+	vector<objGroup*> buckets;
+
+	// Every group with something in it, in no particular order
+	vector<objGroup*> occupied;
+
+	// Empty groups waiting to be reused
+	vector<objGroup*> spare;
+
+	// Every object that's too big for a block
+	vector<bigObject*> bigObjects;
 
-	// A dynamically allocated 2D array of objGroups. Can be referenced like
-	// groups[x][y]
-	objGroup*** groups;
+	// Indexed by object id, every object in the blocks around it. See the top of this file.
+	vector< vector<object*> > near;
 
-	// The bounds for the group array
-	int groupsWidth, groupsHeight;
+	// The objects inserted or updated since the last findPairs, and indexed by object id
+	// whether or not each one is in there
+	vector<object*> changed;
+	vector<bool> isChanged;
 
 	// The width and height of each block into which the level's objects are
 	// broken to be put into objGroups.
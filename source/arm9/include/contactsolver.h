@@ -0,0 +1,221 @@
+/**
+ * @file contactsolver.h
+ *
+ * @brief The contactSolver class that resolves all of a frame's collisions together
+ *
+ * This file contains the contactSolver class. The narrowphase used to push the lighter
+ * object of every colliding pair out by the whole overlap as soon as it was found. In
+ * a stack, pushing one box out of the box below it pushes it into the box above, which
+ * gets pushed back down on a later pair, so stacks never settled within a frame and
+ * everything got rebinned over and over.
+ *
+ * Now the narrowphase only gathers a contact for each colliding pair. Once they're all
+ * found, solve() works out how many contacts away from something static each object is.
+ * Whatever is closer can't be pushed by what it's holding up (objects the same distance
+ * away push each other by weight like before), and the contacts are sorted from the
+ * bottom of the stack up. Then it goes over the whole list a fixed number of times:
+ *
+ *  - Velocity iterations take away any velocity that has the objects moving into each
+ *    other. Each contact remembers the total it took (its impulse) and never pulls the
+ *    objects together, so the contacts settle on the right amount between them.
+ *  - Position iterations push the objects apart by however much they still overlap.
+ *
+ * Each contact's impulse is kept until the next frame and applied up front if the same
+ * two objects are still touching the same way (warm starting), so something resting on
+ * something else starts out already held up and stacks don't jitter.
+ *
+ * The number of iterations is fixed, so the cost of a frame only depends on how many
+ * contacts there are. Object ids have to fit in 16 bits for the warm starting.
+ *
+ * @see physics.h
+ * @see level.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONTACTSOLVER_H_INCLUDED
+#define CONTACTSOLVER_H_INCLUDED
+
+// How many times a frame the solver goes over every contact
+#define ZBE_SOLVER_VELOCITY_ITERATIONS 8
+#define ZBE_SOLVER_POSITION_ITERATIONS 4
+
+// How tall a stack the solver looks through to find what's holding what up
+#define ZBE_SOLVER_MAX_DEPTH 16
+
+// The depth of objects that aren't held up by anything
+#define ZBE_SOLVER_FLOATING 0xFFFF
+
+#include <nds.h>
+#include <vector>
+#include "object.h"
+#include "vector.h"
+#include "fixed32.h"
+#include "physics.h"
+
+using namespace std;
+
+
+/**
+ * contactSolver class
+ *
+ * Resolves a frame's worth of contacts together. See the top of this file for how it works.
+ *
+ * @author Joe Balough
+ */
+class contactSolver
+{
+public:
+	/**
+	 * addContact function
+	 *
+	 * Adds a contact between two objects that are colliding. Nothing is moved until solve().
+	 *
+	 * @param object *a, object *b
+	 *   The two objects
+	 * @author Joe Balough
+	 */
+	void addContact(object *a, object *b);
+
+	/**
+	 * solve function
+	 *
+	 * Resolves every contact added since the last solve, then forgets them (but keeps
+	 * their impulses for warm starting next frame). Runs moved() on every object it pushed.
+	 *
+	 * @param vector<object*> &pushed
+	 *   Cleared, then set to every object that was pushed, each once
+	 * @author Joe Balough
+	 */
+	void solve(vector<object*> &pushed);
+
+	/**
+	 * removeObject function
+	 *
+	 * Forgets the impulses kept for an object that's going away so whatever gets its
+	 * id next doesn't start out with them. Call this between solves.
+	 *
+	 * @param object *obj
+	 *   The object
+	 * @author Joe Balough
+	 */
+	void removeObject(object *obj);
+
+	/**
+	 * getNumContacts function
+	 *
+	 * @return unsigned int
+	 *   How many contacts there are to solve
+	 * @author Joe Balough
+	 */
+	inline unsigned int getNumContacts() const
+	{
+		return contacts.size();
+	}
+
+private:
+	// A contact's impulse from last frame
+	struct cachedImpulse
+	{
+		uint32 key;
+		bool xAxis;
+		int sign;
+		fixed32 impulse;
+
+		inline bool operator<(const cachedImpulse &other) const
+		{
+			return key < other.key;
+		}
+	};
+
+	/**
+	 * pairKey function
+	 *
+	 * @return uint32
+	 *   A number that's the same for a pair of objects whichever order they're in
+	 * @author Joe Balough
+	 */
+	static inline uint32 pairKey(object *a, object *b)
+	{
+		uint32 idA = a->getObjectId(), idB = b->getObjectId();
+		return (idA < idB) ? (idA << 16 | idB) : (idB << 16 | idA);
+	}
+
+	/**
+	 * axis function
+	 *
+	 * @return fixed32&
+	 *   The x or y part of a vector
+	 * @author Joe Balough
+	 */
+	static inline fixed32 &axis(vector2D<fixed32> &v, bool x)
+	{
+		return x ? v.x : v.y;
+	}
+
+	/**
+	 * applyImpulse function
+	 *
+	 * Changes the objects' velocities along a contact's normal by an impulse, split by their shares.
+	 *
+	 * @author Joe Balough
+	 */
+	static inline void applyImpulse(decapod::contact &c, fixed32 impulse)
+	{
+		fixed32 along = (c.sign > 0) ? impulse : -impulse;
+		axis(c.a->velocity, c.xAxis) -= along * c.shareA;
+		axis(c.b->velocity, c.xAxis) += along * c.shareB;
+	}
+
+	// Sorts contacts by the depth of the lower of their two objects
+	struct depthSorter
+	{
+		depthSorter(const vector<uint16> &DepthOf) : depthOf(DepthOf) {}
+
+		inline uint16 depth(const decapod::contact &c) const
+		{
+			uint16 depthA = depthOf[c.a->getObjectId()], depthB = depthOf[c.b->getObjectId()];
+			return (depthA < depthB) ? depthA : depthB;
+		}
+
+		inline bool operator()(const decapod::contact &c1, const decapod::contact &c2) const
+		{
+			return depth(c1) < depth(c2);
+		}
+
+		const vector<uint16> &depthOf;
+	};
+
+	// This frame's contacts
+	vector<decapod::contact> contacts;
+
+	// Last frame's impulses, sorted by key
+	vector<cachedImpulse> cache, nextCache;
+
+	// Indexed by object id, how many contacts away from something static it is this frame
+	vector<uint16> depthOf;
+
+	// Indexed by object id, whether or not it's in solve's pushed vector yet
+	vector<bool> isPushed;
+};
+
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file fixed32.h
+ *
+ * @brief The fixed32 class represents a 20.12 fixed-point number.
+ *
+ * The ARM9 in the Nintendo DS has no floating point unit, so every float operation the engine does is emulated
+ * in software. This file contains the fixed32 class which keeps a number in a 32 bit integer with 12 fractional bits.
+ * That is the same format used by the libnds mulf32() and divf32() functions and by the gravity values stored
+ * in the zbe datafile, so those values can be used directly without any conversion.
+ *
+ * @see vector.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FIXED32_H_INCLUDED
+#define FIXED32_H_INCLUDED
+
+// The number of fractional bits and the raw value that represents 1.0
+#define ZBE_FIXED_SHIFT 12
+#define ZBE_FIXED_ONE (1 << ZBE_FIXED_SHIFT)
+
+#include <nds.h> // mulf32(), divf32()
+
+/**
+ * fixed32 class
+ *
+ * The fixed32 class is a drop-in replacement for float in all of the per-frame math. It can be constructed from
+ * ints, unsigned ints, floats, and doubles so constants like fixed32(0.05) are folded by the compiler. Conversions
+ * back out are always explicit (toInt(), toFloat()) so that no float math sneaks back into the engine by accident.
+ *
+ * Multiplication uses mulf32 and division uses divf32 which uses the DS' hardware divider.
+ *
+ * @author Joe Balough
+ */
+class fixed32
+{
+public:
+	/**
+	 * Generic Constructor
+	 *
+	 * Initializes value to 0
+	 */
+	fixed32()
+	{
+		raw = 0;
+	}
+
+	/**
+	 * Conversion Constructors
+	 *
+	 * Convert the passed number into 20.12 fixed point.
+	 *
+	 * @param int i, unsigned int u, float f, double d
+	 *   The value to convert
+	 */
+	fixed32(int i)
+	{
+		raw = int32(i * ZBE_FIXED_ONE);
+	}
+	fixed32(unsigned int u)
+	{
+		raw = int32(u * ZBE_FIXED_ONE);
+	}
+	fixed32(float f)
+	{
+		raw = int32(f * ZBE_FIXED_ONE);
+	}
+	fixed32(double d)
+	{
+		raw = int32(d * ZBE_FIXED_ONE);
+	}
+
+	/**
+	 * fromRaw function
+	 *
+	 * Makes a fixed32 out of a number that is already in 20.12 format, like the gravity values
+	 * found in the zbe datafile.
+	 *
+	 * @param int32 r
+	 *   The 20.12 value
+	 * @return fixed32
+	 *   A fixed32 representing that value
+	 * @author Joe Balough
+	 */
+	static inline fixed32 fromRaw(int32 r)
+	{
+		fixed32 f;
+		f.raw = r;
+		return f;
+	}
+
+	/**
+	 * Returns the underlying 20.12 value
+	 * @author Joe Balough
+	 */
+	inline int32 getRaw() const
+	{
+		return raw;
+	}
+
+	/**
+	 * Returns the value rounded down to an integer
+	 * @author Joe Balough
+	 */
+	inline int toInt() const
+	{
+		return raw >> ZBE_FIXED_SHIFT;
+	}
+
+	/**
+	 * Returns the value as a float. Do not use this in anything that runs every frame.
+	 * @author Joe Balough
+	 */
+	inline float toFloat() const
+	{
+		return float(raw) / float(ZBE_FIXED_ONE);
+	}
+
+	// Arithmetic assignment operators
+	inline fixed32 &operator+=(const fixed32 &b)
+	{
+		raw += b.raw;
+		return *this;
+	}
+	inline fixed32 &operator-=(const fixed32 &b)
+	{
+		raw -= b.raw;
+		return *this;
+	}
+	inline fixed32 &operator*=(const fixed32 &b)
+	{
+		raw = mulf32(raw, b.raw);
+		return *this;
+	}
+	inline fixed32 &operator/=(const fixed32 &b)
+	{
+		raw = divf32(raw, b.raw);
+		return *this;
+	}
+
+	// Unary operators
+	inline fixed32 operator-() const
+	{
+		return fromRaw(-raw);
+	}
+	inline fixed32 operator+() const
+	{
+		return *this;
+	}
+
+private:
+	// The 20.12 value
+	int32 raw;
+};
+
+// Arithmetic operators
+inline fixed32 operator+(const fixed32 &a, const fixed32 &b)
+{
+	return fixed32::fromRaw(a.getRaw() + b.getRaw());
+}
+inline fixed32 operator-(const fixed32 &a, const fixed32 &b)
+{
+	return fixed32::fromRaw(a.getRaw() - b.getRaw());
+}
+inline fixed32 operator*(const fixed32 &a, const fixed32 &b)
+{
+	return fixed32::fromRaw(mulf32(a.getRaw(), b.getRaw()));
+}
+inline fixed32 operator/(const fixed32 &a, const fixed32 &b)
+{
+	return fixed32::fromRaw(divf32(a.getRaw(), b.getRaw()));
+}
+
+// Comparison operators
+inline bool operator==(const fixed32 &a, const fixed32 &b)
+{
+	return a.getRaw() == b.getRaw();
+}
+inline bool operator!=(const fixed32 &a, const fixed32 &b)
+{
+	return a.getRaw() != b.getRaw();
+}
+inline bool operator<(const fixed32 &a, const fixed32 &b)
+{
+	return a.getRaw() < b.getRaw();
+}
+inline bool operator>(const fixed32 &a, const fixed32 &b)
+{
+	return a.getRaw() > b.getRaw();
+}
+inline bool operator<=(const fixed32 &a, const fixed32 &b)
+{
+	return a.getRaw() <= b.getRaw();
+}
+inline bool operator>=(const fixed32 &a, const fixed32 &b)
+{
+	return a.getRaw() >= b.getRaw();
+}
+
+/**
+ * abs function
+ *
+ * Returns the absolute value of a fixed32. Replaces fabs() in the physics engine.
+ *
+ * @param fixed32 a
+ *   The value whose absolute value is desired
+ * @return fixed32
+ *   |a|
+ * @author Joe Balough
+ */
+inline fixed32 abs(const fixed32 &a)
+{
+	return (a.getRaw() < 0) ? -a : a;
+}
+
+#endif // FIXED32_H_INCLUDED
@@ -34,7 +34,7 @@
 #include <nds.h>
 #include <math.h>
 #include "object.h"
-#include "level.h"
+#include "vars.h"
 #include "assettypes.h"
 
 /**
@@ -58,31 +58,76 @@ public:
 	 * @see object::object()
 	 * @author Joe Balough
 	 */
-	hero(OamState *Oam, int id,
+	hero(OamState *Oam, int id, bodyStore *bodies,
 		frameAsset ***animations,
-		vector2D<float> position, vector2D<float> gravity, uint8 weight, bool hidden = false,
+		vector2D<fixed32> position, vector2D<fixed32> gravity, uint8 weight, bool hidden = false,
 		int matrixId = -1, int ScaleX = 1 << 8, int ScaleY = 1 << 8, int Angle = 0,
 		bool Mosaic = false)
-	: object(Oam, id,
+	: object(Oam, id, bodies,
 		 animations,
 		 position, gravity, weight, hidden,
 		 matrixId, ScaleX, ScaleY, Angle,
 		 Mosaic)
 	{
+		hooks = typeHooks;
+
 		// Give screen offset a default value
 		moved();
 	}
 
+	// Heroes read the buttons before they move and keep the screen on themselves after
+	static const uint8 typeHooks = ZBE_HOOK_UPDATE | ZBE_HOOK_MOVED;
+
 	/**
 	 * Implementation of update function
 	 *
-	 * Polls the buttons for input and moves the sprite accordingly. After doing that, it calls the object's update function to
-	 * apply physics features.
+	 * Polls the buttons for input and changes the hero's velocity accordingly. The level applies the physics afterwards.
+	 * Inline so the heroes' objectBucket can inline it.
 	 *
 	 * @see object::update()
 	 * @author Joe Balough
 	 */
-	virtual bool update(touchPosition *touch);
+	virtual void update(touchPosition * /*touch*/)
+	{
+		// TODO (jbb5044#6#): Generalize the input stuff so that users can drop multiple heros in to the level with different key mappings.
+
+		// If the user is pressing left or right, move the object slightly to the left or right
+		// if the user is pressing up, jump.
+		// In all of those cases, set falling to true to force gravity.
+		if (keysHeld() & KEY_LEFT)
+		{
+			velocity.x -= fixed32(0.05);
+			falling = true;
+		}
+		else if (keysHeld() & KEY_RIGHT)
+		{
+			velocity.x += fixed32(0.05);
+			falling = true;
+		}
+		if (keysHeld() & KEY_UP)
+		{
+			velocity.y -= fixed32(0.1); //0.3;
+			falling = true;
+		}
+		if (keysHeld() & KEY_DOWN)
+		{
+			velocity.y += fixed32(0.1); //0.3;
+			falling = true;
+		}
+	}
+
+	/**
+	 * Implementation of canSleep function
+	 *
+	 * Heroes need to keep polling the buttons, so they never sleep.
+	 *
+	 * @see object::canSleep()
+	 * @author Joe Balough
+	 */
+	virtual bool canSleep()
+	{
+		return false;
+	}
 
 
 	/**
@@ -103,8 +148,8 @@ public:
 		{
 			// ansi escape sequence to set print co-ordinates
 			// /x1b[line;columnH
-			iprintf("\x1b[1;24HX: %5ld\n", (long int) position.x);
-			iprintf("\x1b[2;24HY: %5ld\n", (long int) position.y);
+			iprintf("\x1b[1;24HX: %5ld\n", (long int) position.x.toInt());
+			iprintf("\x1b[2;24HY: %5ld\n", (long int) position.y.toInt());
 		}
 		++numCalls;
 
@@ -115,7 +160,7 @@ public:
 
 	/**
 	 * Implementation of moved callback
-	 * Called whenever the hero is moved by an object other than hero, e.g. collision detection.
+	 * Called whenever the hero is moved, by itself or by something else like collision detection.
 	 *
 	 * @author Joe Balough
 	 */
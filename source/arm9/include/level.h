@@ -41,6 +41,15 @@
 #define ZBE_NO_MATRICES -1
 #define ZBE_NO_SPRITES -2
 
+// How many frames in a row an island of objects has to be at rest before it falls asleep
+#define ZBE_SLEEP_FRAMES 30
+
+// How far (in 1/4096ths of a pixel) an object can move in one frame and still be at rest
+#define ZBE_SLEEP_EPSILON (ZBE_FIXED_ONE / 16)
+
+// How many objects can be spawned into a level on top of the ones it starts with
+#define ZBE_SPAWN_CAPACITY 32
+
 #include <nds.h>
 #include <vector>
 #include <time.h>  // used in FPS calculation
@@ -51,10 +60,17 @@
 // Level objects
 #include "object.h"
 #include "hero.h"
+#include "bodystore.h"
+#include "objectbucket.h"
 
 // For Collision detection
 #include "physics.h"
-#include "collisionmatrix.h"
+#include "broadphase.h"
+#include "staticgeometry.h"
+#include "tilemap.h"
+#include "aabbstore.h"
+#include "contactsolver.h"
+#include "sensortracker.h"
 
 // For zbeAssets
 #include "assets.h"
@@ -65,6 +81,52 @@
 using namespace std;
 using namespace decapod;
 
+/**
+ * objectHandle struct
+ *
+ * Refers to an object made with level::spawn(). Object ids are reused once an object is despawned,
+ * so a handle also has the generation of the id it was made with. It stops finding anything once
+ * its object is despawned, even if something else gets the id.
+ *
+ * @author Joe Balough
+ */
+struct objectHandle
+{
+	objectHandle(int Id = -1, uint16 Generation = 0)
+	{
+		id = Id;
+		generation = Generation;
+	}
+
+	// Whether or not this handle never referred to anything, like when spawn() fails
+	inline bool isNull() const
+	{
+		return id < 0;
+	}
+
+	int id;
+	uint16 generation;
+};
+
+
+/**
+ * spawnRequest struct
+ *
+ * An object level::spawn() was asked for that hasn't been made yet: the handle it was given
+ * and where to put it.
+ *
+ * @author Joe Balough
+ */
+struct spawnRequest
+{
+	spawnRequest(objectHandle Handle, const levelObjectAsset &Place) : handle(Handle), place(Place)
+	{}
+
+	objectHandle handle;
+	levelObjectAsset place;
+};
+
+
 /**
  * level class
  *
@@ -84,14 +146,21 @@ public:
 	 * Initializes the local copy of the OAMTable and sets up the arrays that keep track of what
 	 * SpriteEntries and what matrices are available.
 	 *
+	 * @param levelAsset *metadata
+	 *   The levelAsset to build this level from
+	 * @param OamState *oam
+	 *   The OAM to put this level's sprites on
+	 * @param int broadphaseType
+	 *   Which broadphase collision engine to use. One of the ZBE_BROADPHASE_ values.
+	 *   Defaults to the one set in the level's data.
 	 * @author Joe Balough
 	 */
-	level(levelAsset *metadata, OamState *oam);
+	level(levelAsset *metadata, OamState *oam, int broadphaseType = ZBE_BROADPHASE_FROM_LEVEL);
 
 	/**
 	 * level deconstructor
 	 *
-	 * Goes through array of objects and deletes them, since they were dynamically allocated.
+	 * Cleans up everything the level made. The objects are destroyed by their buckets.
 	 *
 	 * libnds API calls:
 	 *   oamClear -- Clears all sprites defined in the OAM
@@ -118,11 +187,10 @@ public:
 	/**
 	 * update function
 	 *
-	 * Gets touchscreen information then iterates through the list of objects
-	 * telling each one to update giving them the touchscreen update information.
-	 * Those functions return a boolean value indicating whether they've moved
-	 * because of the update. If they have moved, run collision detection on
-	 * them.
+	 * Gets touchscreen information then runs the update function of every type of
+	 * object that has one, giving them the touchscreen update information. Then it moves
+	 * every awake object at once with the bodyStore and runs collision detection
+	 * on the ones that moved.
 	 *
 	 * libnds API calls:
 	 *   scanKeys -- Check for buttons that have been pressed
@@ -133,14 +201,83 @@ public:
 	 */
 	void update();
 
+	/**
+	 * spawn function
+	 *
+	 * Asks for a new object in the level. It's made at the end of the next update(), after the
+	 * sensors hear about this frame's overlaps, and is awake and colliding from the update after
+	 * that. Its storage and id come out of pools set up when the level was made, so nothing is
+	 * allocated. Safe to call from inside an object's functions.
+	 *
+	 * @param uint32 objectAssetId
+	 *   Which objectAsset the new object is
+	 * @param vector2D<fixed32> position
+	 *   Where to put it
+	 * @param vector2D<fixed32> gravity
+	 *   Its gravity, defaults to none
+	 * @return objectHandle
+	 *   A handle to the new object. It's null if there's no such objectAsset or if there are
+	 *   already ZBE_SPAWN_CAPACITY spawned objects, counting the ones waiting to be made.
+	 * @author Joe Balough
+	 */
+	objectHandle spawn(uint32 objectAssetId, vector2D<fixed32> position, vector2D<fixed32> gravity = vector2D<fixed32>(0, 0));
+
+	/**
+	 * despawn function
+	 *
+	 * Asks for an object made with spawn() to be taken out of the level. Its handle stops finding
+	 * it right away, but it's only destroyed at the end of the next update(), where spawn()'s
+	 * objects are made. Then anything asleep on it is woken up, any sensor it was overlapping gets
+	 * sensorExit and its storage and id go back in the pools. Safe to call from inside an
+	 * object's functions, even on itself.
+	 *
+	 * @param objectHandle handle
+	 *   The object's handle
+	 * @return bool
+	 *   Whether or not there was an object to despawn. False if it was already despawned.
+	 * @author Joe Balough
+	 */
+	bool despawn(objectHandle handle);
+
+	/**
+	 * getObject function
+	 *
+	 * @param objectHandle handle
+	 *   An object's handle
+	 * @return object*
+	 *   The object or NULL if it's been despawned or hasn't been made yet
+	 * @author Joe Balough
+	 */
+	object *getObject(objectHandle handle);
+
 private:
 
 	// A pointer to the oam table that the level should put its obects on.
 	OamState *oam;
 
-	// A standard library vector containing all of the objects in this level
+	// Every object's physics and render state. The objects' fields are references into it.
+	bodyStore bodies;
+
+	// The objects themselves, one bucket per type. These are all the types a level can make,
+	// see objectbucket.h. The heroes come first so they get the lowest ids and sprites.
+	objectBucket<hero> heroes;
+	objectBucket<object> plainObjects;
+
+	// Every object in this level, indexed by id, pointing into the buckets. NULL for the
+	// spawn ids that aren't being used.
 	vector<object*> objects;
 
+	// The ids from firstSpawnId up are for spawned objects. freeIds are the ones that aren't being
+	// used, lowest last, and generations has how many times each one has been despawned.
+	int firstSpawnId;
+	vector<int> freeIds;
+	vector<uint16> generations;
+
+	// The objects spawn() and despawn() were asked for since the last applySpawns(). The spawns
+	// already have their ids. Both are reserved big enough that they never reallocate.
+	vector<spawnRequest> pendingSpawns;
+	vector<object*> pendingDespawns;
+
 	// A vector of pointers to backgrounds
 	vector<background*> backgrounds;
 
@@ -184,17 +321,137 @@ private:
 		matrixAvail[index] = true;
 	}
 
+	/**
+	 * applySpawns function
+	 *
+	 * Called once every update(), after the sensors have been told what's overlapping them and
+	 * before anything is drawn. Destroys the objects despawn() was asked to get rid of, then makes
+	 * the ones spawn() was asked for. Nothing is looking through the objects at that point, so
+	 * they can safely come and go.
+	 *
+	 * @author Joe Balough
+	 */
+	void applySpawns();
+
+	/**
+	 * wake function
+	 *
+	 * Wakes up a sleeping object along with every other object that fell asleep in its island.
+	 * Only looks at the objects in that island.
+	 *
+	 * @param object *obj
+	 *   The object to wake
+	 * @author Joe Balough
+	 */
+	void wake(object *obj);
+
+	/**
+	 * findIsland function
+	 *
+	 * Finds the island an object is in this frame. Islands are groups of objects
+	 * that touched each other and are tracked with a union-find in islandParent.
+	 *
+	 * @param int id
+	 *   The object id to look up
+	 * @return int
+	 *   The id of the object at the root of its island
+	 * @author Joe Balough
+	 */
+	int findIsland(int id);
+
+	/**
+	 * sleepObjects function
+	 *
+	 * Called at the end of update(). Counts up how long every awake object has been at
+	 * rest and puts whole islands to sleep once all of their objects have been at rest
+	 * for ZBE_SLEEP_FRAMES frames.
+	 *
+	 * @author Joe Balough
+	 */
+	void sleepObjects();
+
+	/**
+	 * sweepObject function
+	 *
+	 * Called on objects that moved further than they are big this frame. Finds the
+	 * first object in the box it swept through that it would have hit on the way and
+	 * stops it there. Objects that move less than that can't get all the way through
+	 * anything, so the regular overlap check is enough for them.
+	 *
+	 * @param unsigned int i
+	 *   The id of the object that moved
+	 * @author Joe Balough
+	 */
+	void sweepObject(unsigned int i);
+
 
 	/**
 	 * Variables for collision detection
 	 */
 
-	// An array of pointers to objGroups. Each index represents an object id which points
-	// to its objGroup.. probalby not best, but it'll work for now.
-	vector<objGroup*> objectsGroups;
+	// A pointer to the broadphase collision engine we're using. Has every object but the static ones.
+	broadphase *colEngine;
+
+	// The static objects, baked when the level is constructed
+	staticGeometry *staticGeo;
+
+	// The background tiles objects collide with. Also keeps objects inside the level.
+	tileMap *tiles;
+
+	// Indexed by object id, whether or not that object moved this frame.
+	vector<bool> objMoved;
+
+	// The pairs the broadphase found this frame that involve at least one moved object.
+	// Kept around between frames so it doesn't have to reallocate.
+	vector<objPair> pairs;
+
+	// Every object's bounding box, refreshed once they're done moving each frame
+	aabbStore boxes;
+
+	// The ids of the objects in each of this frame's pairs and whether their boxes are
+	// touching, for aabbStore::overlapBatch. Kept around so they don't have to reallocate.
+	vector<int> pairIdsA, pairIdsB;
+	vector<uint8> pairHits;
+
+	// Resolves the collisions the narrowphase finds
+	contactSolver solver;
+
+	// The objects the solver pushed this frame. Kept around so it doesn't have to reallocate.
+	vector<object*> pushed;
+
+	// Tells the sensors what's overlapping them
+	sensorTracker sensors;
+
+	// The objects sweepObject is looking at. Kept around so it doesn't have to reallocate.
+	vector<object*> sweepCandidates;
+
+	// The objects near one that's being despawned. Kept around so it doesn't have to reallocate.
+	vector<object*> despawnNeighbours;
+
+	// Pair counts from the last frame: every candidate pair the broadphase visited and
+	// the ones that were passed on to narrowphase.
+	uint32 numBroadPairs, numNarrowPairs;
+
+	/**
+	 * Variables for sleeping
+	 */
+
+	// Indexed by object id, the union-find parent of that object's island this frame.
+	vector<int> islandParent;
+
+	// Indexed by island root, the fewest restFrames of any object in that island.
+	vector<uint8> islandRest;
+
+	// The objects in each sleeping island, as a list through their ids so waking one only visits
+	// its own objects. sleeperHead is indexed by island root and sleeperNext by object id, -1 ends
+	// the list.
+	vector<int> sleeperHead, sleeperNext;
+
+	// How many objects are asleep
+	uint32 numAsleep;
 
-	// A pointer to the collisionMatrix we're using
-	collisionMatrix *colMatrix;
+	// How many sprite ids were drawn with last frame. Only the ones after this frame's are cleared.
+	int spritesUsed;
 
 };
 
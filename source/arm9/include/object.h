@@ -36,8 +36,18 @@
 #include <nds.h>
 #include <stdio.h>
 #include "vector.h"
+#include "fixed32.h"
 #include "vars.h"
 #include "assettypes.h"
+#include "bodystore.h"
+#include "animationcontroller.h"
+
+// Which per-type hooks an object has, see object::hooks
+#define ZBE_HOOK_UPDATE 1
+#define ZBE_HOOK_MOVED  2
+
+// Defined in collisionmatrix.h
+struct objGroup;
 
 /**
  * object class
@@ -68,12 +78,16 @@ public:
 	 *
 	 * @param OamState *oam
 	 *  The oam in which this sprite should update. Should be oamMain or oamSub,.
+	 * @param int id
+	 *  This object's id
+	 * @param bodyStore *bodies
+	 *  The store to keep this object's physics and render state in. It has to have a slot for id already.
 	 * @param frameAsset ***animations
 	 *  A 2D array of pointers to frameAssets that define the animations for this object.
 	 *
-	 * @param vector2D<float> postion
+	 * @param vector2D<fixed32> postion
 	 *  Where on screen this object is to be drawn
-	 * @param vector2D<float> gravity
+	 * @param vector2D<fixed32> gravity
 	 *  The gravity vector for this object
 	 * @param uint8 weight
 	 *  The weight of the object, heavier objects push lighter objects with the default collision resolution
@@ -96,9 +110,9 @@ public:
 	 *  Defaults to false, whether or not this sprite should be a mosaic'd (blurry)
 	 * @author Joe Balough
 	 */
-	object(OamState *Oam, int id,
+	object(OamState *Oam, int id, bodyStore *bodies,
 	   frameAsset ***animations,
-	   vector2D<float> position, vector2D<float> gravity, uint8 weight, bool Hidden = false,
+	   vector2D<fixed32> position, vector2D<fixed32> gravity, uint8 weight, bool Hidden = false,
 	   int MatrixId = -1, int ScaleX = 1 << 8, int ScaleY = 1 << 8, int Angle = 0,
 	   bool Mosaic = false);
 
@@ -109,32 +123,59 @@ public:
 	 *
 	 * Only available in the testing build. Used by the collisionMatrix functional test.
 	 * Doesn't set any variables. Do not use this for anything other than a functional test.
+	 * The object keeps its own physics state instead of using a bodyStore.
 	 *
-	 * @param vector2D<float> Position
+	 * @param vector2D<fixed32> Position
 	 *   The position of this object
+	 * @param int id
+	 *   The id of this object. Broadphase engines index by it so keep them unique.
 	 * @author Joe Balough
 	 */
-	object(vector2D<float> Position)
+	object(vector2D<fixed32> Position, int id = 0)
+	: position(own.position), velocity(own.velocity), acceleration(own.acceleration), gravity(own.gravity),
+	  falling(own.falling), frame(own.frame)
 	{
 		position = Position;
+		velocity = acceleration = gravity = vector2D<fixed32>(0, 0);
+		falling = true;
+		objectId = id;
+		frame = NULL;
+		animFrame = NULL;
+		group = NULL;
+		groupPrev = groupNext = NULL;
+		asleep = false;
+		restFrames = 0;
+		island = id;
+		isStatic = false;
+		isSensor = false;
+		category = ZBE_CATEGORY_DEFAULT;
+		mask = ZBE_MASK_ALL;
+		weight = 0;
+		hooks = 0;
+		hflip = vflip = false;
+		isRotateScale = false;
+		oamSlot = -1;
+		oamFlipped = false;
+		oamDirty = true;
 	}
 #endif
 
 	/**
 	 * Object update function
 	 *
-	 * Called every frame by the level::run() function, this function updates the object's position
-	 * on screen based on game events. This is where the decapodian physics engine is implemented.
-	 * After moving the object, its entry in the oam is updated.
+	 * Called every frame by the level::update() function, before the object is moved, on objects
+	 * whose type has ZBE_HOOK_UPDATE in its typeHooks. This is where an object reacts to game events by
+	 * changing its velocity or acceleration. The physics are applied to every object at once
+	 * afterwards by bodyStore::integrate(), so plain objects don't need this.
 	 *
 	 * @param touchPosition *touch
 	 *  A pointer to a data structure containing information about where the touch screen was last touched (if it was)
-	 * @return bool
-	 *  Whether or not this object has moved because of this update (and should thus have collision detection run).
 	 * @see touchPosition
+	 * @see bodystore.h
 	 * @author Joe Balough
 	 */
-	virtual bool update(touchPosition *touch);
+	virtual void update(touchPosition * /*touch*/)
+	{}
 
 	/**
 	 * Object draw function
@@ -143,8 +184,12 @@ public:
 	 * objects are where they need to be. Virtual in case any classes inheriting this one
 	 * need to do something weird.
 	 *
+	 * Writes into the OamState's shadow copy of the OAM. If the sprite id is the one this
+	 * object was drawn with last frame, only the attribute words that changed are rewritten,
+	 * and nothing at all is if it hasn't moved on screen, flipped or changed frames.
+	 *
 	 * libnds API calls:
-	 *   oamSet -- Sets a sprite in the OAM
+	 *   oamSet -- Sets a sprite in the OAM, only when it has to be rewritten completely
 	 *
 	 * @param int spriteId
 	 *  The sprite index to use in the oam
@@ -152,18 +197,157 @@ public:
 	 */
 	virtual void draw(int spriteId);
 
+	/**
+	 * Object animate function
+	 *
+	 * Called every frame by the level after the objects are moved and before collisions are
+	 * checked. Turns the sprite to face the way the object is moving, then steps the animation
+	 * and, if that changed the frame, points frame and animFrame at the new one. Doing both here
+	 * means the collision code sees the sprite the same way it's drawn.
+	 *
+	 * @return bool
+	 *  Whether or not the object turned around or changed frames, in which case its hitboxes might have moved
+	 * @see animationcontroller.h
+	 * @author Joe Balough
+	 */
+	inline bool animate()
+	{
+		bool changed = false;
+
+		// Flip horizontally?
+		bool flip = velocity.x < 0;
+		if (flip != hflip)
+		{
+			hflip = flip;
+			changed = true;
+		}
+
+		// draw() only has to patch the flip bit for a turn, but a new frame needs all of the entry
+		if (animation.step())
+		{
+			animFrame = animation.getFrame();
+			frame = animFrame->gfx;
+			changed = true;
+			oamDirty = true;
+		}
+
+		return changed;
+	}
+
+	/**
+	 * Object isFlipped function
+	 *
+	 * @return bool
+	 *  Whether or not the sprite is drawn flipped horizontally. Affine sprites never are.
+	 * @author Joe Balough
+	 */
+	inline bool isFlipped() const
+	{
+		return hflip && !isRotateScale;
+	}
+
+	/**
+	 * Object boxLeft function
+	 *
+	 * Gets where the left edge of a box on the sprite is, like the gfx's box or a hitbox, the way
+	 * it's drawn. Flipping mirrors boxes across the whole sprite.
+	 *
+	 * @param int left
+	 *  The box's left edge from the left of the sprite, unflipped
+	 * @param int width
+	 *  The box's width
+	 * @return int
+	 *  The box's left edge from the left of the sprite, as drawn
+	 * @author Joe Balough
+	 */
+	inline int boxLeft(int left, int width) const
+	{
+		if (!isFlipped() || !frame)
+			return left;
+		return frame->spriteWidth() - left - width;
+	}
+
+	/**
+	 * Object forgetSprite function
+	 *
+	 * Called by the level when the object isn't drawn this frame. Someone else might get its
+	 * sprite id, so the next draw() has to write the whole sprite.
+	 *
+	 * @author Joe Balough
+	 */
+	inline void forgetSprite()
+	{
+		oamSlot = -1;
+	}
+
 
 	/**
 	 * Object moved function
 	 *
 	 * Called whenever the object is moved by an outside force like collision resolution or
-	 * a cinematic event. Is not called when an object's update function causes it to move.
+	 * a cinematic event. Is only called when the object moves on its own if it has ZBE_HOOK_MOVED
+	 * in its hooks.
 	 *
 	 * @author Joe Balough
 	 */
 	virtual void moved()
 	{}
 
+	/**
+	 * Object canSleep function
+	 *
+	 * Whether or not this object is allowed to fall asleep once it has come to rest. A sleeping
+	 * object isn't updated or tested for collisions until something touches it.
+	 * Anything that has to keep updating when it isn't moving (like something the player
+	 * controls) should return false.
+	 *
+	 * @return bool
+	 *  Whether or not this object may sleep
+	 * @author Joe Balough
+	 */
+	virtual bool canSleep()
+	{
+		return true;
+	}
+
+	/**
+	 * Object sensorEnter function
+	 *
+	 * Only called on sensors. Called the frame another object starts overlapping this one.
+	 *
+	 * @param object *other
+	 *  The object that's now overlapping this one
+	 * @see sensortracker.h
+	 * @author Joe Balough
+	 */
+	virtual void sensorEnter(object * /*other*/)
+	{}
+
+	/**
+	 * Object sensorStay function
+	 *
+	 * Only called on sensors. Called every frame after the first that another object is
+	 * still overlapping this one.
+	 *
+	 * @param object *other
+	 *  The object that's still overlapping this one
+	 * @author Joe Balough
+	 */
+	virtual void sensorStay(object * /*other*/)
+	{}
+
+	/**
+	 * Object sensorExit function
+	 *
+	 * Only called on sensors. Called the frame another object stops overlapping this one.
+	 *
+	 * @param object *other
+	 *  The object that was overlapping this one
+	 * @author Joe Balough
+	 */
+	virtual void sensorExit(object * /*other*/)
+	{}
+
 
 	/**
 	 * Just a quick getter to get the object's id
@@ -174,6 +358,33 @@ public:
 		return objectId;
 	}
 
+	/**
+	 * layersCollide function
+	 *
+	 * Whether or not this object's collision layers let it collide with another one.
+	 * Broadphase engines check this before anything else so pairs that can never
+	 * collide don't cost any more than this.
+	 *
+	 * @param object *other
+	 *  The other object
+	 * @return bool
+	 *  Whether each object's category is in the other's mask
+	 * @author Joe Balough
+	 */
+	inline bool layersCollide(object *other)
+	{
+		return (category & other->mask) && (other->category & mask);
+	}
+
+	/**
+	 * Whether or not this object can't collide with anything at all, like decorations
+	 * @author Joe Balough
+	 */
+	inline bool collidesWithNothing()
+	{
+		return !category || !mask;
+	}
+
 	/**
 	 * makeRotateScale function
 	 *
@@ -294,7 +505,8 @@ public:
 	 */
 	inline void setPriority(int priority)
 	{
-		priority = priority;
+		this->priority = priority;
+		oamDirty = true;
 	}
 
 
@@ -310,6 +522,7 @@ public:
 	void isHidden(bool visibility)
 	{
 		hidden = visibility;
+		oamDirty = true;
 	}
 
 
@@ -340,19 +553,72 @@ public:
 		return weight;
 	}
 
-	// Indicates whether or not the object is falling. If the object is falling, it will be
-	// moved by gravity in the update funciton. If not, gravity won't move it at all.
-	bool falling;
+#ifdef ZBE_TESTING
+private:
+	// Where an object made with the testing constructor keeps its physics state. Declared ahead
+	// of the references below so they can be bound to it.
+	bodyStore::body own;
 
-	// The width and height to which the sprite should be scaled using an affine transformation
-	vector2D<int> scale;
+public:
+#endif
+	// These are references to this object's slot in its bodyStore. See bodystore.h.
 
 	// obvious variables
 	// note: gravity is added to the y acceleration.
-	vector2D<float> position, velocity, acceleration, gravity;
+	// These are all 20.12 fixed point, the ARM9 has no FPU.
+	vector2D<fixed32> &position, &velocity, &acceleration, &gravity;
+
+	// Indicates whether or not the object is falling. If the object is falling, it will be
+	// moved by gravity when it's integrated. If not, gravity won't move it at all.
+	uint8 &falling;
 
 	// The gfxStatus of the gfx currently being viewed
-	gfxAsset *frame;
+	gfxAsset *&frame;
+
+	// The width and height to which the sprite should be scaled using an affine transformation
+	vector2D<int> scale;
+
+	// Which of the per-type hooks every object of this type has, some of the ZBE_HOOK_ values.
+	// The level's objectBuckets only call update() on types with ZBE_HOOK_UPDATE and the level
+	// only calls moved() after an object moves on its own if it has ZBE_HOOK_MOVED. Every type
+	// that has hooks hides this with its own.
+	static const uint8 typeHooks = 0;
+
+	// This object's type's typeHooks, for when all there is to go on is an object pointer.
+	// Set by the constructors of the types that have them.
+	uint8 hooks;
+
+	// The animation frame currently being viewed, for its hitboxes and hurtboxes. NULL if there isn't one.
+	frameAsset *animFrame;
+
+	// Plays this object's animations. Call play() or playAfter() on it to change animations.
+	animationController animation;
+
+	// Intrusive links for the collisionMatrix. group is the objGroup this object is in (NULL if none) and
+	// groupPrev / groupNext are its neighbours in that objGroup's list. Only objGroup should change these.
+	objGroup *group;
+	object *groupPrev, *groupNext;
+
+	// Sleeping state, managed by the level. asleep objects aren't updated, restFrames is how many
+	// frames in a row this object has barely moved and island is the id of the island of touching
+	// objects it fell asleep with.
+	bool asleep;
+	uint8 restFrames;
+	int island;
+
+	// Whether or not this object is static level geometry. Static objects are set up by the level,
+	// are never updated or moved, and are always treated as heavier than anything they touch.
+	bool isStatic;
+
+	// Whether or not this object is a sensor. Sensors are found by the broadphase like anything
+	// else but are never pushed and never push anything; they just get the sensor functions
+	// called when other objects start and stop overlapping them. Set by the level from the objectAsset.
+	bool isSensor;
+
+	// Collision layers. category has a bit set for each layer this object is on and mask for each
+	// layer it collides with. Two objects only collide if each one's category is in the other's mask.
+	// Set by the level from the objectAsset.
+	uint16 category, mask;
 
 protected:
 	// Pointer to the OamState in which this sprite should be updated
@@ -388,8 +654,18 @@ protected:
 	// Whether or not this object is flipped horizontally, vertically, mosaic'd, or hidden
 	bool hflip, vflip, mosaic, hidden;
 
-	int colWidth; // will be 20% of the real width for use by Physics Engine - DT
-	int colHeight; // will be 20% of the real height for use by Physics Engine - DT
+	// The sprite id this object was drawn with last frame (-1 if it wasn't drawn), where on the
+	// screen and whether it was flipped. oamDirty is set when anything else about the sprite changes,
+	// like its frame or priority, so the next draw() writes all of it.
+	int oamSlot;
+	vector2D<int> oamPosition;
+	bool oamFlipped;
+	bool oamDirty;
+
+private:
+	// Objects are bound to their bodyStore slot, so they can't be copied
+	object(const object &other);
+	object &operator=(const object &other);
 };
 
 #endif // OBJECT_H_INCLUDED
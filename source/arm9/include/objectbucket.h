@@ -0,0 +1,320 @@
+/**
+ * @file objectbucket.h
+ *
+ * @brief The objectBucket template class that keeps all of a level's objects of one type together
+ *
+ * This file contains the objectBucket template class. The level used to keep every object
+ * in one list, heroes and plain objects mixed together, and called update() and draw()
+ * on each one through its vtable. Every call was an indirect branch the compiler couldn't
+ * see through, and each one could go to a different function than the last.
+ *
+ * Now each type the level can make has its own bucket: one block of memory, allocated
+ * when the level is made, with every object of that type in it one after another. A
+ * bucket calls T::update() and T::draw() by name so the calls are direct and can be
+ * inlined, and it skips the update loop completely when T doesn't have ZBE_HOOK_UPDATE
+ * in its typeHooks. That's all worked out when the bucket is compiled.
+ *
+ * A bucket is also a pool: it never holds more than it was reserved for, and when an
+ * object is removed its slot goes on a free list for the next one added. Objects can be
+ * made and destroyed every frame without touching the heap.
+ *
+ * The types a level can make are the buckets in the level class. To add a new one, give
+ * it a constructor like object's and a typeHooks, then add a bucket for it there.
+ *
+ * @see object.h
+ * @see level.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECTBUCKET_H_INCLUDED
+#define OBJECTBUCKET_H_INCLUDED
+
+#include <nds.h>
+#include <new>
+#include <vector>
+#include "object.h"
+#include "bodystore.h"
+#include "assettypes.h"
+#include "vars.h"
+
+
+/**
+ * isOnScreen function
+ *
+ * Whether or not any of an object is on the screen, going by its slot in a bodyStore.
+ * Goes across the whole width of the sprite so it doesn't matter which way it's flipped.
+ *
+ * @param const bodyStore &bodies
+ *   The store the object is in
+ * @param int id
+ *   The object's id
+ * @return bool
+ *   Whether or not it should be drawn
+ * @author Joe Balough
+ */
+inline bool isOnScreen(const bodyStore &bodies, int id)
+{
+	const gfxAsset *frame = bodies.frame[id];
+	int x = (bodies.position[id].x - screenOffset.x).toInt();
+	int y = (bodies.position[id].y - screenOffset.y).toInt() + frame->topleft.y;
+	return x >= -frame->spriteWidth() && x <= SCREEN_WIDTH &&
+	       y >= -int(frame->dimensions.y) && y <= SCREEN_HEIGHT;
+}
+
+
+/**
+ * objectBucket template class
+ *
+ * Every object of type T in a level, kept together. See the top of this file for how it works.
+ *
+ * @author Joe Balough
+ */
+template <class T> class objectBucket
+{
+public:
+	/**
+	 * objectBucket constructor
+	 *
+	 * Makes an empty bucket. Call reserve() before adding anything.
+	 *
+	 * @author Joe Balough
+	 */
+	objectBucket()
+	{
+		items = NULL;
+		count = capacity = numAlive = 0;
+	}
+
+	/**
+	 * objectBucket destructor
+	 *
+	 * Destroys all of the objects in the bucket and frees their memory.
+	 *
+	 * @author Joe Balough
+	 */
+	~objectBucket()
+	{
+		for (unsigned int i = 0; i < count; i++)
+			if (alive[i])
+				items[i].~T();
+		::operator delete(items);
+	}
+
+	/**
+	 * reserve function
+	 *
+	 * Allocates room for the most objects that will ever be in the bucket at once. Can
+	 * only be done once since the objects can't be moved once they're made.
+	 *
+	 * @param unsigned int numObjects
+	 *   How many objects there will be
+	 * @author Joe Balough
+	 */
+	void reserve(unsigned int numObjects)
+	{
+		if (items)
+			return;
+		capacity = numObjects;
+		if (capacity)
+			items = static_cast<T*>(::operator new(capacity * sizeof(T)));
+		alive.resize(capacity, false);
+		freeSlots.reserve(capacity);
+	}
+
+	/**
+	 * add function
+	 *
+	 * Makes a new object in the bucket from a levelObjectAsset, in the slot the last
+	 * removed object was in if there is one.
+	 *
+	 * @param OamState *oam
+	 *   The oam its sprite goes in
+	 * @param int id
+	 *   Its object id
+	 * @param bodyStore *bodies
+	 *   The store with its slot in it
+	 * @param levelObjectAsset *asset
+	 *   Where it is in the level and what it looks like
+	 * @return T*
+	 *   The new object or NULL if the bucket is full
+	 * @author Joe Balough
+	 */
+	T *add(OamState *oam, int id, bodyStore *bodies, levelObjectAsset *asset)
+	{
+		unsigned int slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else if (count < capacity)
+			slot = count++;
+		else
+			return NULL;
+
+		objectAsset *obj = asset->obj;
+		T *newObj = new (&items[slot]) T(oam, id, bodies, obj->animations, asset->position, asset->gravity, obj->weight);
+		alive[slot] = true;
+		++numAlive;
+		newObj->category = obj->category;
+		newObj->mask = obj->mask;
+		newObj->isSensor = obj->isSensor;
+		return newObj;
+	}
+
+	/**
+	 * remove function
+	 *
+	 * Destroys an object in the bucket and frees up its slot.
+	 *
+	 * @param T *obj
+	 *   The object, which has to be one add() returned
+	 * @author Joe Balough
+	 */
+	void remove(T *obj)
+	{
+		unsigned int slot = obj - items;
+		if (slot >= count || !alive[slot])
+			return;
+
+		obj->~T();
+		alive[slot] = false;
+		--numAlive;
+		freeSlots.push_back(slot);
+	}
+
+	/**
+	 * update function
+	 *
+	 * Runs T::update() on every awake object in the bucket. Does nothing at all if T
+	 * doesn't have ZBE_HOOK_UPDATE in its typeHooks.
+	 *
+	 * @param touchPosition *touch
+	 *   The touch screen information to pass on
+	 * @param const bodyStore &bodies
+	 *   The store the objects are in, for whether they're awake
+	 * @author Joe Balough
+	 */
+	inline void update(touchPosition *touch, const bodyStore &bodies)
+	{
+		if (!(T::typeHooks & ZBE_HOOK_UPDATE))
+			return;
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			T &obj = items[i];
+			if (alive[i] && bodies.isActive(obj.getObjectId()))
+				obj.T::update(touch);
+		}
+	}
+
+	/**
+	 * animate function
+	 *
+	 * Runs T::animate() on every object. Sleeping objects keep animating so they don't look frozen.
+	 * An awake object that isn't moving but turned around or changed frames has its id pushed onto
+	 * moved so its new hitboxes get checked; moving ones are already on it.
+	 *
+	 * @param const bodyStore &bodies
+	 *   The store the objects are in, for whether they're awake and moving
+	 * @param vector<int> &moved
+	 *   The ids of the objects that moved this frame
+	 * @author Joe Balough
+	 */
+	inline void animate(const bodyStore &bodies, vector<int> &moved)
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			T &obj = items[i];
+			if (!alive[i] || !obj.animate())
+				continue;
+
+			int id = obj.getObjectId();
+			if (bodies.isActive(id) && bodies.velocity[id].x == 0 && bodies.velocity[id].y == 0)
+				moved.push_back(id);
+		}
+	}
+
+	/**
+	 * draw function
+	 *
+	 * Runs T::draw() on every object in the bucket that's on the screen, giving each one
+	 * the next sprite id. The ones that aren't drawn forget the sprite they had.
+	 *
+	 * @param const bodyStore &bodies
+	 *   The store the objects are in, for where they are
+	 * @param int &spriteId
+	 *   The next sprite id to use. Left at the one after the last one used.
+	 * @param int maxSprites
+	 *   How many sprites there are. Stops once spriteId gets there.
+	 * @author Joe Balough
+	 */
+	inline void draw(const bodyStore &bodies, int &spriteId, int maxSprites)
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (!alive[i])
+				continue;
+
+			T &obj = items[i];
+			if (spriteId < maxSprites && isOnScreen(bodies, obj.getObjectId()))
+			{
+				obj.T::draw(spriteId);
+				++spriteId;
+			}
+			else
+				obj.forgetSprite();
+		}
+	}
+
+	/**
+	 * size function
+	 *
+	 * @return unsigned int
+	 *   How many objects are in the bucket
+	 * @author Joe Balough
+	 */
+	inline unsigned int size() const
+	{
+		return numAlive;
+	}
+
+private:
+	// The objects, one after another
+	T *items;
+
+	// How many slots have ever been used, how many there's room for and how many have an object in them
+	unsigned int count, capacity, numAlive;
+
+	// Indexed by slot, whether or not there's an object in it
+	vector<uint8> alive;
+
+	// The slots below count that objects were removed from
+	vector<unsigned int> freeSlots;
+
+	// Objects can't be moved, so neither can the bucket
+	objectBucket(const objectBucket &other);
+	objectBucket &operator=(const objectBucket &other);
+};
+
+
+#endif
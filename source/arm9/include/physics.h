@@ -45,6 +45,35 @@
 
 namespace decapod
 {
+	/**
+	 * contact struct
+	 * Two objects that are touching, found by findContact and resolved by the contactSolver.
+	 * The normal is always along the x or y axis.
+	 *
+	 * @author Robert Byers
+	 */
+	struct contact
+	{
+		// The two objects. b gets pushed along the normal, a the other way.
+		object *a, *b;
+
+		// Which axis the normal is on and which way along it b gets pushed (1 or -1)
+		bool xAxis;
+		int sign;
+
+		// How far the hitboxes overlapped along the normal when it was found
+		fixed32 depth;
+
+		// Where the objects were when it was found, to see how far they've been pushed apart since
+		vector2D<fixed32> startA, startB;
+
+		// How much of a push each object takes. Adds up to 1.
+		fixed32 shareA, shareB;
+
+		// The velocity change the solver has put into this contact so far this frame
+		fixed32 impulse;
+	};
+
 
 	//bool intersection(object sprite1, object sprite2);
 
@@ -71,6 +100,8 @@ namespace decapod
 
 	/**
 	 * Checks for collision between two objects
+	 * Objects whose animation frame has hitboxes are tested with those, any others
+	 * with the box of their gfx.
 	 *
 	 * @param object *object1, object *object2
 	 *  The two objects to test for collisions
@@ -81,11 +112,46 @@ namespace decapod
 	bool collisionDetect(object *object1, object *object2);
 
 
+	/**
+	 * Checks if one object is hitting another where it can be hurt
+	 * The attacker's hitboxes (or gfx's box) are tested against the hurtboxes of the
+	 * victim's animation frame. The engine never calls this, it's for game code.
+	 *
+	 * @param object *attacker
+	 *  The object doing the hurting
+	 * @param object *victim
+	 *  The object that might get hurt
+	 * @return bool
+	 *  true if the attacker is touching one of the victim's hurtboxes, false o.w.
+	 * @author Robert Byers
+	 */
+	bool hurtDetect(object *attacker, object *victim);
+
+
+	/**
+	 * Checks for collision between two objects' pixels
+	 * Run this on objects collisionDetect says are colliding to see if any of their
+	 * non-transparent pixels are actually touching, using the masks cliCreator made
+	 * for their frames. Masks are compared 32 pixels at a time. Like collisionDetect,
+	 * pixels that are right next to each other count as touching.
+	 *
+	 * @param object *object1, object *object2
+	 *  The two objects to test for collisions
+	 * @return bool
+	 *  true if their pixels are touching, if either frame has no mask or if either
+	 *  has hitboxes, false o.w.
+	 * @author Robert Byers
+	 */
+	bool pixelCollisionDetect(object *object1, object *object2);
+
+
 	/**
 	 * Default collision resolution
 	 * This function is run on two objects are known to be colliding. It will look at
 	 * the weight of both objects and move them so that the heavier object is pushing
 	 * the lighter object. If they are the same weight, neither object will be moved.
+	 * Static objects are always the heavier object. Objects are pushed apart by the
+	 * first pair of hitboxes that are touching.
 	 *
 	 * @param object *object1, object *object2
 	 *  The two objects that are colliding
@@ -96,6 +162,62 @@ namespace decapod
 	object *collisionResolution(object *object1, object *object2);
 
 
+	/**
+	 * Finds the contact between two colliding objects
+	 * Fills in a contact for the contactSolver from the first pair of hitboxes that
+	 * are touching. The normal is the axis they overlap the least on. Static objects
+	 * and the heavier object don't get pushed, objects of the same weight share it.
+	 *
+	 * @param object *object1, object *object2
+	 *  The two objects that are colliding
+	 * @param contact &c
+	 *  The contact to fill in. Its impulse is set to 0.
+	 * @author Robert Byers
+	 */
+	void findContact(object *object1, object *object2, contact &c);
+
+
+	/**
+	 * Swept collision detection
+	 * collisionDetect only looks at where objects end up, so something that moves
+	 * further than its own size in one frame can go right through things. This finds
+	 * when, during the frame, a moving object's box first touched another box. It
+	 * divides, so only use it for objects that moved further than they are big.
+	 * The other object is treated as if it had been where it is now the whole frame.
+	 *
+	 * @param object *mover
+	 *  The object that moved, already at where it ended up
+	 * @param const vector2D<fixed32> &from
+	 *  Where mover was at the start of the frame
+	 * @param object *other
+	 *  The object to test against
+	 * @param fixed32 &toi
+	 *  Set to how far through the move, from 0 to 1, the boxes first touched
+	 * @param bool &hitX
+	 *  Set to true if they touched on a left or right side, false for top or bottom
+	 * @return bool
+	 *  true if the boxes started touching during the move, false o.w. Boxes that
+	 *  were already overlapping at the start are left to collisionDetect.
+	 * @author Robert Byers
+	 */
+	bool sweptCollisionDetect(object *mover, const vector2D<fixed32> &from, object *other, fixed32 &toi, bool &hitX);
+
+
+	/**
+	 * Swept collision resolution
+	 * Takes a hit found by sweptCollisionDetect and moves the mover back to where it
+	 * hit, flush against the side of the other object, and stops it moving into it.
+	 * Nothing else is moved.
+	 *
+	 * @param object *mover, const vector2D<fixed32> &from, object *other
+	 *  The same as what was passed to sweptCollisionDetect
+	 * @param fixed32 toi, bool hitX
+	 *  What sweptCollisionDetect found
+	 * @author Robert Byers
+	 */
+	void sweptCollisionResolution(object *mover, const vector2D<fixed32> &from, object *other, fixed32 toi, bool hitX);
+
+
 	//bool collisionHorrizontalLine(object *obj1, int yval);
 };
 
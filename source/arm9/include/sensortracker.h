@@ -0,0 +1,153 @@
+/**
+ * @file sensortracker.h
+ *
+ * @brief The sensorTracker class that tells sensors what's overlapping them
+ *
+ * This file contains the sensorTracker class. A sensor is an object that only finds
+ * out what's overlapping it (a checkpoint, a pickup or a hazard zone) without pushing
+ * or being pushed. Sensors go in the broadphase like anything else, but the narrowphase
+ * hands their pairs here instead of to the contactSolver, so they cost no solver time.
+ *
+ * The tracker keeps the overlaps from last frame sorted by the pair's object ids and
+ * merges this frame's into them:
+ *
+ *  - An overlap that wasn't there last frame calls the sensor's sensorEnter().
+ *  - One that's still there calls sensorStay().
+ *  - One from last frame that wasn't found this frame calls sensorExit(), but only if
+ *    one of the two moved. The broadphase only reports the pairs where something moved,
+ *    so the overlaps between objects that stayed put are just kept and get sensorStay().
+ *
+ * Object ids have to fit in 16 bits.
+ *
+ * @see object.h
+ * @see level.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SENSORTRACKER_H_INCLUDED
+#define SENSORTRACKER_H_INCLUDED
+
+#include <nds.h>
+#include <vector>
+#include "object.h"
+
+using namespace std;
+
+
+/**
+ * sensorTracker class
+ *
+ * Turns each frame's sensor overlaps into enter, stay and exit events. See the top of
+ * this file for how it works.
+ *
+ * @author Joe Balough
+ */
+class sensorTracker
+{
+public:
+	/**
+	 * addOverlap function
+	 *
+	 * Adds an overlap between a sensor and something else that the narrowphase found
+	 * this frame. Nothing is called until update(). If both objects are sensors, add
+	 * it once for each of them.
+	 *
+	 * @param object *sensor
+	 *   The sensor
+	 * @param object *other
+	 *   What's overlapping it
+	 * @author Joe Balough
+	 */
+	void addOverlap(object *sensor, object *other);
+
+	/**
+	 * update function
+	 *
+	 * Merges the overlaps added since the last update with last frame's and calls the
+	 * sensors' sensorEnter, sensorStay and sensorExit functions.
+	 *
+	 * @param vector<bool> &objMoved
+	 *   Indexed by object id, whether or not that object moved this frame
+	 * @author Joe Balough
+	 */
+	void update(vector<bool> &objMoved);
+
+	/**
+	 * removeObject function
+	 *
+	 * Forgets everything about an object that's going away. Any sensor it was
+	 * overlapping gets sensorExit called for it right away. Don't call this from
+	 * inside update().
+	 *
+	 * @param object *obj
+	 *   The object
+	 * @author Joe Balough
+	 */
+	void removeObject(object *obj);
+
+	/**
+	 * getNumOverlaps function
+	 *
+	 * @return unsigned int
+	 *   How many sensors and objects were overlapping as of the last update
+	 * @author Joe Balough
+	 */
+	inline unsigned int getNumOverlaps() const
+	{
+		return overlaps.size();
+	}
+
+private:
+	// A sensor and something overlapping it
+	struct overlap
+	{
+		uint32 key;
+		object *sensor, *other;
+
+		inline bool operator<(const overlap &o) const
+		{
+			return key < o.key;
+		}
+	};
+
+	/**
+	 * moved function
+	 *
+	 * @return bool
+	 *   Whether or not objMoved says an object moved this frame
+	 * @author Joe Balough
+	 */
+	static inline bool moved(vector<bool> &objMoved, object *obj)
+	{
+		unsigned int id = obj->getObjectId();
+		return id < objMoved.size() && objMoved[id];
+	}
+
+	// The overlaps as of the last update, sorted by key
+	vector<overlap> overlaps;
+
+	// The overlaps found this frame and where the merged ones are built
+	vector<overlap> found, merged;
+};
+
+
+#endif
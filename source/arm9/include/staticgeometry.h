@@ -0,0 +1,238 @@
+/**
+ * @file staticgeometry.h
+ *
+ * @brief The staticGeometry class that holds a level's static collision boxes
+ *
+ * This file contains the staticGeometry class. Level objects that are flagged as static
+ * in the zbe file (platforms, walls, floors) never move, so there's no reason for them
+ * to be rebinned or pair tested every frame like everything else. Instead, the level
+ * bakes all of them into a staticGeometry once when it is constructed and only ever
+ * queries it with the boxes of the objects that moved.
+ *
+ * The baked structure is a uniform grid of ZBE_STATIC_CELL_SIZE pixel cells stored as
+ * two flat arrays: cellStart, which gives where each cell's list begins, and cellBoxes,
+ * which holds every cell's list of box indices back to back. A box is listed in every
+ * cell it touches. Nothing is allocated or changed after construction.
+ *
+ * Static objects are never put into the level's broadphase engine, so a pair of static
+ * objects is never generated.
+ *
+ * @see level.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATICGEOMETRY_H_INCLUDED
+#define STATICGEOMETRY_H_INCLUDED
+
+// Width and height of a staticGeometry cell in pixels. Must be a power of 2.
+#define ZBE_STATIC_CELL_SHIFT 6
+#define ZBE_STATIC_CELL_SIZE (1 << ZBE_STATIC_CELL_SHIFT)
+
+#include <nds.h>
+#include <vector>
+#include "object.h"
+#include "vector.h"
+#include "fixed32.h"
+#include "broadphase.h"
+
+using namespace std;
+
+
+/**
+ * staticPairCollector struct
+ *
+ * A staticGeometry visitor that appends a pair of one moving object and every
+ * static object it overlaps to the level's pairs vector.
+ *
+ * @author Joe Balough
+ */
+struct staticPairCollector
+{
+	staticPairCollector(object *Mover, vector<objPair> &Pairs) : mover(Mover), pairs(Pairs)
+	{
+		count = 0;
+	}
+
+	inline bool operator()(object *found)
+	{
+		++count;
+		if (!mover->layersCollide(found))
+			return true;
+
+		objPair pair = {mover, found};
+		pairs.push_back(pair);
+		return true;
+	}
+
+	// The object that moved
+	object *mover;
+
+	// Where to put the pairs
+	vector<objPair> &pairs;
+
+	// How many pairs were found, whether or not their layers let them collide
+	unsigned int count;
+};
+
+
+/**
+ * staticGeometry class
+ *
+ * A read-only grid of static collision boxes. See the top of this file for how it works.
+ *
+ * @author Joe Balough
+ */
+class staticGeometry
+{
+public:
+	/**
+	 * staticGeometry constructor
+	 *
+	 * Bakes the bounding boxes of the static objects into the grid. The objects must
+	 * not move or change frames after this.
+	 *
+	 * @param const vector<object*> &statics
+	 *   Every static object in the level
+	 * @param int levelWidth, int levelHeight
+	 *   The width and height of the whole level in pixels
+	 * @author Joe Balough
+	 */
+	staticGeometry(const vector<object*> &statics, int levelWidth, int levelHeight);
+
+	/**
+	 * query function
+	 *
+	 * Calls visit(object*) once for every static object whose bounding box overlaps
+	 * the region. If visit returns false, the query stops.
+	 *
+	 * A box that is in more than one of the cells the region covers is only visited
+	 * from the top-left one of those cells, so there's nothing to mark and the
+	 * grid is never written to.
+	 *
+	 * @param vector2D<fixed32> min, vector2D<fixed32> max
+	 *   The top-left and bottom-right corners of the region
+	 * @param Visitor &visit
+	 *   Anything that can be called like bool visit(object *found)
+	 * @author Joe Balough
+	 */
+	template <typename Visitor>
+	void query(vector2D<fixed32> min, vector2D<fixed32> max, Visitor &visit) const
+	{
+		if (boxes.empty())
+			return;
+
+		int minX = cellX(min.x), minY = cellY(min.y);
+		int maxX = cellX(max.x), maxY = cellY(max.y);
+		for (int y = minY; y <= maxY; y++)
+		{
+			for (int x = minX; x <= maxX; x++)
+			{
+				int cell = y * cellsWide + x;
+				for (unsigned int i = cellStart[cell]; i < cellStart[cell + 1]; i++)
+				{
+					const staticBox &box = boxes[cellBoxes[i]];
+
+					// Only visit it from the first cell both it and the region are in
+					if (x != ((box.cellMin.x > minX) ? box.cellMin.x : minX) ||
+					    y != ((box.cellMin.y > minY) ? box.cellMin.y : minY))
+						continue;
+
+					if (box.max.x < min.x || max.x < box.min.x || box.max.y < min.y || max.y < box.min.y)
+						continue;
+
+					if (!visit(box.obj))
+						return;
+				}
+			}
+		}
+	}
+
+	/**
+	 * getNumBoxes function
+	 *
+	 * @return unsigned int
+	 *   How many static boxes were baked
+	 * @author Joe Balough
+	 */
+	inline unsigned int getNumBoxes() const
+	{
+		return boxes.size();
+	}
+
+	/**
+	 * getNumEntries function
+	 *
+	 * @return unsigned int
+	 *   How many cell entries there are. Boxes that touch more than one cell are counted once per cell.
+	 * @author Joe Balough
+	 */
+	inline unsigned int getNumEntries() const
+	{
+		return cellBoxes.size();
+	}
+
+private:
+	// A static object and its bounding box
+	struct staticBox
+	{
+		vector2D<fixed32> min, max;
+		object *obj;
+
+		// The top-left cell this box is in
+		vector2D<int> cellMin;
+	};
+
+	/**
+	 * cellX and cellY functions
+	 *
+	 * Gets the column or row a coordinate falls in. Anything off the edge of the level
+	 * is put in the nearest edge cell.
+	 *
+	 * @author Joe Balough
+	 */
+	inline int cellX(fixed32 x) const
+	{
+		int cell = x.toInt() >> ZBE_STATIC_CELL_SHIFT;
+		return (cell < 0) ? 0 : (cell >= cellsWide) ? cellsWide - 1 : cell;
+	}
+	inline int cellY(fixed32 y) const
+	{
+		int cell = y.toInt() >> ZBE_STATIC_CELL_SHIFT;
+		return (cell < 0) ? 0 : (cell >= cellsHigh) ? cellsHigh - 1 : cell;
+	}
+
+	// Every static box
+	vector<staticBox> boxes;
+
+	// Indexed by cell, where that cell's list starts in cellBoxes. Has one extra
+	// entry at the end so cell i's list is always cellStart[i] to cellStart[i + 1].
+	vector<unsigned int> cellStart;
+
+	// Every cell's list of indices into boxes, back to back
+	vector<uint16> cellBoxes;
+
+	// How many cells wide and high the grid is
+	int cellsWide, cellsHigh;
+};
+
+
+#endif
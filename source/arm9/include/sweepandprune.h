@@ -0,0 +1,144 @@
+/**
+ * @file sweepandprune.h
+ *
+ * @brief The sweepAndPrune broadphase engine
+ *
+ * This file contains the sweepAndPrune class, a sort-and-sweep broadphase. It keeps
+ * every object's bounding box in an array sorted by left edge. To find pairs it walks
+ * that array once and, for each box, only looks at the boxes after it whose left edge
+ * is left of its right edge.
+ *
+ * Objects don't move far from one frame to the next so the array is almost always
+ * still sorted. It is re-sorted with an insertion sort, which is about linear time on
+ * nearly sorted data. Unlike the collisionMatrix, the cost doesn't depend on the size
+ * of the level or on how many objects end up sharing a block.
+ *
+ * @see broadphase.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SWEEPANDPRUNE_H_INCLUDED
+#define SWEEPANDPRUNE_H_INCLUDED
+
+#include <nds.h>
+#include <vector>
+#include "object.h"
+#include "vector.h"
+#include "broadphase.h"
+
+using namespace std;
+
+
+/**
+ * sweepAndPrune class
+ *
+ * The ZBE_BROADPHASE_SAP broadphase engine. See the top of this file for how it works.
+ *
+ * @author Joe Balough
+ */
+class sweepAndPrune : public broadphase
+{
+public:
+	/**
+	 * insertObject function
+	 *
+	 * Adds an object to the end of the array. It is sorted into place the next
+	 * time pairs are found.
+	 *
+	 * @param object *add
+	 *   A pointer to the object to add
+	 * @author Joe Balough
+	 */
+	virtual void insertObject(object *add);
+
+	/**
+	 * updateObject function
+	 *
+	 * Does nothing. Every box is refreshed from its object when pairs are found.
+	 *
+	 * @param object *move
+	 *   A pointer to the object that moved
+	 * @author Joe Balough
+	 */
+	virtual void updateObject(object *)
+	{}
+
+	/**
+	 * removeObject function
+	 *
+	 * Takes an object out of the array. This has to search the array so
+	 * don't do it every frame.
+	 *
+	 * @param object *remove
+	 *   A pointer to the object to remove
+	 * @return bool
+	 *   Whether or not the object was in the array
+	 * @author Joe Balough
+	 */
+	virtual bool removeObject(object *remove);
+
+	/**
+	 * findPairs function
+	 *
+	 * Refreshes every box, insertion sorts the array, then sweeps it for
+	 * pairs whose boxes overlap on both axes. Pairs whose collision layers
+	 * don't collide are skipped before their y axis is checked.
+	 *
+	 * @param vector<bool> &objMoved
+	 *   Indexed by object id, whether or not that object moved this frame
+	 * @param vector<objPair> &pairs
+	 *   The vector to append the pairs to
+	 * @return unsigned int
+	 *   The number of overlapping pairs found whose layers collide, moved or not
+	 * @author Joe Balough
+	 */
+	virtual unsigned int findPairs(vector<bool> &objMoved, vector<objPair> &pairs);
+
+	/**
+	 * findCandidates function
+	 *
+	 * Checks every object's current bounding box against the region. The
+	 * array's boxes are only as new as the last findPairs so they aren't used.
+	 *
+	 * @param vector2D<fixed32> min, vector2D<fixed32> max
+	 *   The top-left and bottom-right corners of the region
+	 * @param vector<object*> &found
+	 *   The vector to append the objects to
+	 * @author Joe Balough
+	 */
+	virtual void findCandidates(vector2D<fixed32> min, vector2D<fixed32> max, vector<object*> &found);
+
+private:
+	// An object and its bounding box and collision layers as of the last findPairs
+	struct sapEntry
+	{
+		object *obj;
+		vector2D<fixed32> min, max;
+		uint16 category, mask;
+	};
+
+	// Every object's entry, sorted by min.x
+	vector<sapEntry> entries;
+};
+
+
+#endif
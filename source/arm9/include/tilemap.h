@@ -0,0 +1,186 @@
+/**
+ * @file tilemap.h
+ *
+ * @brief The tileMap class that collides objects with a background's collision layer
+ *
+ * This file contains the tileMap class. cliCreator can write a collision layer next to a
+ * background's map with one byte per tile saying what kind of ground that tile is. A level
+ * picks one of its backgrounds to collide with and the tileMap pushes moving objects out of
+ * its solid tiles. Looking up a tile is just an index into that array, so terrain doesn't
+ * need any sprites or broadphase work.
+ *
+ * Tiles outside of the level are solid, which keeps everything inside the level whether
+ * or not it has a collision layer. Tiles inside the level but past the edge of the
+ * collision layer are empty.
+ *
+ * There are three kinds of tiles that can be collided with:
+ *   - solid tiles block movement from every side.
+ *   - one-way tiles only block things falling onto them from above. They can be
+ *     jumped through from below and walked through from the sides.
+ *   - slope tiles have a floor that goes diagonally across the tile. Objects stand
+ *     on the floor at their bottom-center, so they walk up and down slopes smoothly.
+ *
+ * @see level.h
+ * @author Joe Balough
+ */
+
+/*
+ *  Copyright (c) 2010 zoidberg engine
+ *
+ *  This file is part of the zoidberg engine.
+ *
+ *  The zoidberg engine is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The zoidberg engine is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with the zoidberg engine.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILEMAP_H_INCLUDED
+#define TILEMAP_H_INCLUDED
+
+// Tile collision types. These values are stored in the zbe file so don't change them.
+#define ZBE_TILE_EMPTY 0
+#define ZBE_TILE_SOLID 1
+#define ZBE_TILE_ONEWAY 2
+// Floor goes from the bottom-left corner to the top-right corner, like a slash
+#define ZBE_TILE_SLOPE_UP 3
+// Floor goes from the top-left corner to the bottom-right corner, like a backslash
+#define ZBE_TILE_SLOPE_DOWN 4
+
+// Background tiles are 8 x 8 pixels
+#define ZBE_TILE_SHIFT 3
+#define ZBE_TILE_SIZE (1 << ZBE_TILE_SHIFT)
+
+#include <nds.h>
+#include "object.h"
+#include "vector.h"
+#include "fixed32.h"
+#include "assettypes.h"
+
+using namespace std;
+
+
+/**
+ * tileMap class
+ *
+ * Collides objects with the tiles in a background's collision layer. See the top of
+ * this file for how it works.
+ *
+ * @author Joe Balough
+ */
+class tileMap
+{
+public:
+	/**
+	 * tileMap constructor
+	 *
+	 * @param backgroundAsset *bg
+	 *   The background whose collision layer to use. Its map must already be loaded.
+	 *   Can be NULL or not have a collision layer, in which case only the edges of the
+	 *   level are solid.
+	 * @param int levelWidth, int levelHeight
+	 *   The width and height of the whole level in pixels
+	 * @author Joe Balough
+	 */
+	tileMap(backgroundAsset *bg, int levelWidth, int levelHeight);
+
+	/**
+	 * getTile function
+	 *
+	 * @param int x, int y
+	 *   The column and row of the tile
+	 * @return uint8
+	 *   The collision type of that tile. One of the ZBE_TILE_ values.
+	 * @author Joe Balough
+	 */
+	inline uint8 getTile(int x, int y) const
+	{
+		// Off the level is solid
+		if (x < 0 || y < 0 || x >= tilesWide || y >= tilesHigh)
+			return ZBE_TILE_SOLID;
+
+		// Off the collision layer is empty
+		if (x >= mapWidth || y >= mapHeight)
+			return ZBE_TILE_EMPTY;
+
+		return tiles[y * mapWidth + x];
+	}
+
+	/**
+	 * collide function
+	 *
+	 * Pushes an object that moved out of any tiles it ran into. The object is moved
+	 * horizontally first, then vertically, only checking the columns or rows of tiles
+	 * its leading edge moved into each time, so even fast objects stop at the first
+	 * solid one. Then, if its bottom-center is on a slope,
+	 * it's put on the slope's floor. Anything that runs into a tile has its velocity
+	 * in that direction zeroed.
+	 *
+	 * Doesn't run obj->moved(), that's up to the caller.
+	 *
+	 * @param object *obj
+	 *   The object that moved
+	 * @param const vector2D<fixed32> &from
+	 *   Where the object was before it moved
+	 * @return bool
+	 *   Whether or not the object was pushed
+	 * @author Joe Balough
+	 */
+	bool collide(object *obj, const vector2D<fixed32> &from) const;
+
+private:
+	/**
+	 * tileOf function
+	 *
+	 * @return int
+	 *   The column or row of tiles a coordinate is in
+	 * @author Joe Balough
+	 */
+	static inline int tileOf(fixed32 coord)
+	{
+		return coord.toInt() >> ZBE_TILE_SHIFT;
+	}
+
+	/**
+	 * solidInColumn and solidInRow functions
+	 *
+	 * @return bool
+	 *   Whether or not any tile in a column between two rows (or a row between
+	 *   two columns) is solid
+	 * @author Joe Balough
+	 */
+	inline bool solidInColumn(int x, int top, int bottom) const
+	{
+		for (int y = top; y <= bottom; y++)
+			if (getTile(x, y) == ZBE_TILE_SOLID)
+				return true;
+		return false;
+	}
+	inline bool solidInRow(int y, int left, int right) const
+	{
+		for (int x = left; x <= right; x++)
+			if (getTile(x, y) == ZBE_TILE_SOLID)
+				return true;
+		return false;
+	}
+
+	// The collision layer or NULL if there isn't one
+	uint8 *tiles;
+
+	// Width and height of the collision layer in tiles
+	int mapWidth, mapHeight;
+
+	// Width and height of the level in tiles
+	int tilesWide, tilesHigh;
+};
+
+
+#endif
@@ -30,8 +30,11 @@
 
 #include <nds.h>
 #include "vector.h"
+#include "fixed32.h"
 #include "assets.h"
 
+class level;
+
 /**
  * Global Variable; screen offsset vector
  *
@@ -43,7 +46,7 @@
  *
  * @author Joe Balough
  */
-extern vector2D<float> screenOffset;
+extern vector2D<fixed32> screenOffset;
 
 /**
  * Global Variable; level size
@@ -52,7 +55,7 @@ extern vector2D<float> screenOffset;
  *
  * @author Joe Balough
  */
-extern vector2D<float> levelSize;
+extern vector2D<fixed32> levelSize;
 
 /**
  * Global Variable; assets
@@ -63,4 +66,14 @@ extern vector2D<float> levelSize;
  */
 extern assets *zbeAssets;
 
+/**
+ * Global Variable; level
+ *
+ * A pointer to the level that's running, or NULL if there isn't one. Objects can use it to
+ * spawn and despawn other objects.
+ *
+ * @author Joe Balough
+ */
+extern level *zbeLevel;
+
 #endif // VARS_H_INCLUDED
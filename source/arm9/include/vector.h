@@ -30,6 +30,7 @@
 
 // TODO: Is this include needed?
 #include <nds.h>
+#include "fixed32.h"
 
 // TODO: make the vector2D class better
 
@@ -61,6 +62,36 @@ template <class T> struct vector2D
 		x = y = 0;
 	}
 
+	// Arithmetic operators, work for any T that has them (int, fixed32, ...)
+	inline vector2D<T> operator+(const vector2D<T> &b) const
+	{
+		return vector2D<T>(x + b.x, y + b.y);
+	}
+	inline vector2D<T> operator-(const vector2D<T> &b) const
+	{
+		return vector2D<T>(x - b.x, y - b.y);
+	}
+	inline vector2D<T> &operator+=(const vector2D<T> &b)
+	{
+		x += b.x;
+		y += b.y;
+		return *this;
+	}
+	inline vector2D<T> &operator-=(const vector2D<T> &b)
+	{
+		x -= b.x;
+		y -= b.y;
+		return *this;
+	}
+	inline bool operator==(const vector2D<T> &b) const
+	{
+		return x == b.x && y == b.y;
+	}
+	inline bool operator!=(const vector2D<T> &b) const
+	{
+		return x != b.x || y != b.y;
+	}
+
 	// X and Y variables
 	T x;
 	T y;
@@ -0,0 +1,80 @@
+#include "aabbstore.h"
+
+#ifdef ZBE_AABB_SSE2
+#include <emmintrin.h>
+#endif
+
+// Make room for everyone's box
+void aabbStore::resize(unsigned int numObjects)
+{
+	minX.resize(numObjects, 0);
+	minY.resize(numObjects, 0);
+	maxX.resize(numObjects, -1);
+	maxY.resize(numObjects, -1);
+}
+
+// Test a batch of pairs one at a time
+ITCM_CODE unsigned int aabbStore::overlapBatchScalar(const int *idsA, const int *idsB, unsigned int count, uint8 *hits) const
+{
+	if (!count)
+		return 0;
+
+	const int32 *x0 = &minX[0], *y0 = &minY[0], *x1 = &maxX[0], *y1 = &maxY[0];
+	unsigned int numHits = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		int a = idsA[i], b = idsB[i];
+
+		// No branches, so nothing to mispredict
+		uint8 hit = (x0[a] <= x1[b]) & (x0[b] <= x1[a]) & (y0[a] <= y1[b]) & (y0[b] <= y1[a]);
+		hits[i] = hit;
+		numHits += hit;
+	}
+	return numHits;
+}
+
+#ifdef ZBE_AABB_SSE2
+// Test a batch of pairs four at a time
+unsigned int aabbStore::overlapBatch(const int *idsA, const int *idsB, unsigned int count, uint8 *hits) const
+{
+	if (!count)
+		return 0;
+
+	const int32 *x0 = &minX[0], *y0 = &minY[0], *x1 = &maxX[0], *y1 = &maxY[0];
+	unsigned int numHits = 0, i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const int *a = idsA + i, *b = idsB + i;
+
+		// There's no gather in SSE2 so the sides have to be loaded one by one
+		__m128i aMinX = _mm_set_epi32(x0[a[3]], x0[a[2]], x0[a[1]], x0[a[0]]);
+		__m128i aMaxX = _mm_set_epi32(x1[a[3]], x1[a[2]], x1[a[1]], x1[a[0]]);
+		__m128i aMinY = _mm_set_epi32(y0[a[3]], y0[a[2]], y0[a[1]], y0[a[0]]);
+		__m128i aMaxY = _mm_set_epi32(y1[a[3]], y1[a[2]], y1[a[1]], y1[a[0]]);
+		__m128i bMinX = _mm_set_epi32(x0[b[3]], x0[b[2]], x0[b[1]], x0[b[0]]);
+		__m128i bMaxX = _mm_set_epi32(x1[b[3]], x1[b[2]], x1[b[1]], x1[b[0]]);
+		__m128i bMinY = _mm_set_epi32(y0[b[3]], y0[b[2]], y0[b[1]], y0[b[0]]);
+		__m128i bMaxY = _mm_set_epi32(y1[b[3]], y1[b[2]], y1[b[1]], y1[b[0]]);
+
+		// A lane is set if its boxes are apart on either axis
+		__m128i apart = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(aMinX, bMaxX), _mm_cmpgt_epi32(bMinX, aMaxX)),
+		                             _mm_or_si128(_mm_cmpgt_epi32(aMinY, bMaxY), _mm_cmpgt_epi32(bMinY, aMaxY)));
+		int apartBits = _mm_movemask_ps(_mm_castsi128_ps(apart));
+		for (int lane = 0; lane < 4; lane++)
+		{
+			uint8 hit = !((apartBits >> lane) & 1);
+			hits[i + lane] = hit;
+			numHits += hit;
+		}
+	}
+
+	// The leftovers
+	return numHits + overlapBatchScalar(idsA + i, idsB + i, count - i, hits + i);
+}
+#else
+// Nothing to vectorize with
+unsigned int aabbStore::overlapBatch(const int *idsA, const int *idsB, unsigned int count, uint8 *hits) const
+{
+	return overlapBatchScalar(idsA, idsB, count, hits);
+}
+#endif
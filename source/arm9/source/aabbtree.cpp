@@ -0,0 +1,337 @@
+#include "aabbtree.h"
+
+// Utility: get the box around two boxes
+static inline void combine(const vector2D<fixed32> &min1, const vector2D<fixed32> &max1,
+                           const vector2D<fixed32> &min2, const vector2D<fixed32> &max2,
+                           vector2D<fixed32> &outMin, vector2D<fixed32> &outMax)
+{
+	outMin.x = (min1.x < min2.x) ? min1.x : min2.x;
+	outMin.y = (min1.y < min2.y) ? min1.y : min2.y;
+	outMax.x = (max1.x > max2.x) ? max1.x : max2.x;
+	outMax.y = (max1.y > max2.y) ? max1.y : max2.y;
+}
+
+// Utility: half the perimeter of a box. Used as the cost of a box when inserting.
+static inline fixed32 halfPerimeter(const vector2D<fixed32> &min, const vector2D<fixed32> &max)
+{
+	return (max.x - min.x) + (max.y - min.y);
+}
+
+// Constructor
+aabbTree::aabbTree()
+{
+	root = freeList = ZBE_TREE_NULL;
+}
+
+// Add an object
+void aabbTree::insertObject(object *add)
+{
+	int id = add->getObjectId();
+	if (id < 0)
+	{
+		iprintf("W: tree add bad obj id %d\n", id);
+		return;
+	}
+	if ((unsigned int) id >= leafOf.size())
+		leafOf.resize(id + 1, ZBE_TREE_NULL);
+	if (leafOf[id] != ZBE_TREE_NULL)
+		return;
+
+	// Make a leaf for it
+	int leaf = allocateNode();
+	nodes[leaf].obj = add;
+	setFatBox(leaf);
+	insertLeaf(leaf);
+	leafOf[id] = leaf;
+}
+
+// Re-insert an object if it left its fat box
+void aabbTree::updateObject(object *move)
+{
+	int id = move->getObjectId();
+	if (id < 0 || (unsigned int) id >= leafOf.size() || leafOf[id] == ZBE_TREE_NULL)
+		return;
+	int leaf = leafOf[id];
+
+	// Nothing to do if it's still inside its fat box
+	vector2D<fixed32> min, max;
+	getBounds(move, min, max);
+	treeNode &node = nodes[leaf];
+	if (node.min.x <= min.x && node.min.y <= min.y && max.x <= node.max.x && max.y <= node.max.y)
+		return;
+
+	// Otherwise give it a new fat box and put it back in
+	removeLeaf(leaf);
+	setFatBox(leaf);
+	insertLeaf(leaf);
+}
+
+// Remove an object
+bool aabbTree::removeObject(object *remove)
+{
+	int id = remove->getObjectId();
+	if (id < 0 || (unsigned int) id >= leafOf.size() || leafOf[id] == ZBE_TREE_NULL)
+		return false;
+
+	removeLeaf(leafOf[id]);
+	freeNode(leafOf[id]);
+	leafOf[id] = ZBE_TREE_NULL;
+	return true;
+}
+
+// Find the pairs for everything that moved
+unsigned int aabbTree::findPairs(vector<bool> &objMoved, vector<objPair> &pairs)
+{
+	movedPairCollector collect(objMoved, pairs);
+	unsigned int numPairs = 0;
+
+	for (unsigned int id = 0; id < leafOf.size() && id < objMoved.size(); id++)
+	{
+		int leaf = leafOf[id];
+		if (leaf == ZBE_TREE_NULL || !objMoved[id])
+			continue;
+		vector2D<fixed32> min = nodes[leaf].min, max = nodes[leaf].max;
+
+		// Find every leaf whose fat box overlaps this one
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+			treeNode &node = nodes[index];
+			if (index == leaf || !overlaps(node.min, node.max, min, max))
+				continue;
+
+			if (node.isLeaf())
+			{
+				// If both moved, only report it from the lower id
+				unsigned int otherId = node.obj->getObjectId();
+				if (otherId < id && otherId < objMoved.size() && objMoved[otherId])
+					continue;
+
+				collect(nodes[leaf].obj, node.obj);
+				numPairs++;
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	return numPairs;
+}
+
+// Find everything in a region
+void aabbTree::findCandidates(vector2D<fixed32> min, vector2D<fixed32> max, vector<object*> &found)
+{
+	regionCollector collect(found);
+	queryRegion(min, max, collect);
+}
+
+// Get a node to use
+int aabbTree::allocateNode()
+{
+	int index;
+	if (freeList == ZBE_TREE_NULL)
+	{
+		// Need a new one
+		nodes.push_back(treeNode());
+		index = nodes.size() - 1;
+	}
+	else
+	{
+		// Take it off the free list
+		index = freeList;
+		freeList = nodes[index].parent;
+	}
+
+	treeNode &node = nodes[index];
+	node.obj = NULL;
+	node.parent = node.child1 = node.child2 = ZBE_TREE_NULL;
+	node.height = 0;
+	return index;
+}
+
+// Put a node onto the free list
+void aabbTree::freeNode(int index)
+{
+	nodes[index].parent = freeList;
+	nodes[index].height = -1;
+	freeList = index;
+}
+
+// Insert a leaf into the tree
+void aabbTree::insertLeaf(int leaf)
+{
+	if (root == ZBE_TREE_NULL)
+	{
+		root = leaf;
+		nodes[root].parent = ZBE_TREE_NULL;
+		return;
+	}
+
+	// Walk down the tree looking for the cheapest sibling for this leaf
+	vector2D<fixed32> leafMin = nodes[leaf].min, leafMax = nodes[leaf].max;
+	int index = root;
+	while (!nodes[index].isLeaf())
+	{
+		treeNode &node = nodes[index];
+		vector2D<fixed32> cMin, cMax;
+		combine(node.min, node.max, leafMin, leafMax, cMin, cMax);
+		fixed32 combined = halfPerimeter(cMin, cMax);
+
+		// Cost of making a new parent for this node and the leaf
+		fixed32 cost = combined + combined;
+
+		// Cost every node below here pays for growing this one to fit the leaf
+		fixed32 inheritance = (combined - halfPerimeter(node.min, node.max)) * 2;
+
+		// Cost of going down each side
+		fixed32 childCost[2];
+		int children[2] = {node.child1, node.child2};
+		for (int c = 0; c < 2; c++)
+		{
+			treeNode &child = nodes[children[c]];
+			combine(child.min, child.max, leafMin, leafMax, cMin, cMax);
+			childCost[c] = halfPerimeter(cMin, cMax) + inheritance;
+			if (!child.isLeaf())
+				childCost[c] -= halfPerimeter(child.min, child.max);
+		}
+
+		// Stop here if that's cheapest
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		index = (childCost[0] < childCost[1]) ? children[0] : children[1];
+	}
+
+	// Make a new parent for the sibling and leaf. Don't keep references into nodes
+	// across allocateNode since it might have to grow the vector.
+	int sibling = index;
+	int oldParent = nodes[sibling].parent;
+	int newParent = allocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent == ZBE_TREE_NULL)
+		root = newParent;
+	else if (nodes[oldParent].child1 == sibling)
+		nodes[oldParent].child1 = newParent;
+	else
+		nodes[oldParent].child2 = newParent;
+
+	refitUp(newParent);
+}
+
+// Take a leaf out of the tree
+void aabbTree::removeLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = ZBE_TREE_NULL;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+	// The sibling takes the parent's place
+	nodes[sibling].parent = grandParent;
+	if (grandParent == ZBE_TREE_NULL)
+		root = sibling;
+	else if (nodes[grandParent].child1 == parent)
+		nodes[grandParent].child1 = sibling;
+	else
+		nodes[grandParent].child2 = sibling;
+	freeNode(parent);
+
+	refitUp(grandParent);
+}
+
+// Rebalance and refit from a node to the root
+void aabbTree::refitUp(int index)
+{
+	while (index != ZBE_TREE_NULL)
+	{
+		index = balance(index);
+
+		treeNode &node = nodes[index];
+		treeNode &child1 = nodes[node.child1];
+		treeNode &child2 = nodes[node.child2];
+		combine(child1.min, child1.max, child2.min, child2.max, node.min, node.max);
+		node.height = 1 + ((child1.height > child2.height) ? child1.height : child2.height);
+
+		index = node.parent;
+	}
+}
+
+// Rotate the taller child of a up if the tree is lopsided there
+int aabbTree::balance(int a)
+{
+	treeNode &A = nodes[a];
+	if (A.isLeaf() || A.height < 2)
+		return a;
+
+	int b = A.child1, c = A.child2;
+	treeNode &B = nodes[b];
+	treeNode &C = nodes[c];
+	int diff = C.height - B.height;
+	if (diff >= -1 && diff <= 1)
+		return a;
+
+	// up is the child being rotated up, down is the other
+	int up = (diff > 1) ? c : b;
+	treeNode &U = nodes[up];
+	int u1 = U.child1, u2 = U.child2;
+	treeNode &U1 = nodes[u1];
+	treeNode &U2 = nodes[u2];
+
+	// up takes a's place
+	U.child1 = a;
+	U.parent = A.parent;
+	A.parent = up;
+	if (U.parent == ZBE_TREE_NULL)
+		root = up;
+	else if (nodes[U.parent].child1 == a)
+		nodes[U.parent].child1 = up;
+	else
+		nodes[U.parent].child2 = up;
+
+	// up keeps its taller child and gives the shorter one to a in up's old spot
+	int keep = (U1.height > U2.height) ? u1 : u2;
+	int give = (keep == u1) ? u2 : u1;
+	U.child2 = keep;
+	if (up == c)
+		A.child2 = give;
+	else
+		A.child1 = give;
+	nodes[give].parent = a;
+
+	// Refit a then up
+	treeNode &A1 = nodes[A.child1];
+	treeNode &A2 = nodes[A.child2];
+	combine(A1.min, A1.max, A2.min, A2.max, A.min, A.max);
+	A.height = 1 + ((A1.height > A2.height) ? A1.height : A2.height);
+	treeNode &K = nodes[keep];
+	combine(A.min, A.max, K.min, K.max, U.min, U.max);
+	U.height = 1 + ((A.height > K.height) ? A.height : K.height);
+
+	return up;
+}
+
+// Set a leaf's fat box
+void aabbTree::setFatBox(int leaf)
+{
+	treeNode &node = nodes[leaf];
+	getBounds(node.obj, node.min, node.max);
+	node.min -= vector2D<fixed32>(ZBE_TREE_MARGIN, ZBE_TREE_MARGIN);
+	node.max += vector2D<fixed32>(ZBE_TREE_MARGIN, ZBE_TREE_MARGIN);
+}
@@ -0,0 +1,113 @@
+#include "animationcontroller.h"
+#include "vars.h"
+
+// animationController constructor
+animationController::animationController()
+{
+	animations = NULL;
+	numAnimations = 0;
+	animation = frameIndex = 0;
+	current = NULL;
+	timer = 0;
+	requested = queued = ZBE_NO_ANIMATION;
+	gfxMem = NULL;
+	paletteId = 0;
+	stale = false;
+}
+
+// Give it some animations
+void animationController::setAnimations(frameAsset ***anims)
+{
+	animations = anims;
+	numAnimations = 0;
+	while (animations[numAnimations] != NULL)
+		++numAnimations;
+	requested = queued = ZBE_NO_ANIMATION;
+
+	// Nothing to play without a first frame
+	if (!numAnimations || !animations[0][0])
+	{
+		animations = NULL;
+		current = NULL;
+		return;
+	}
+	show(0, 0);
+}
+
+// Switch animations on the next step
+void animationController::play(int animationId)
+{
+	if (animationId < 0 || animationId >= numAnimations || !animations[animationId][0])
+		return;
+	requested = (animationId != animation) ? animationId : ZBE_NO_ANIMATION;
+	queued = ZBE_NO_ANIMATION;
+}
+
+// Switch animations after this one is done
+void animationController::playAfter(int animationId)
+{
+	if (animationId < 0 || animationId >= numAnimations || !animations[animationId][0])
+		return;
+	queued = animationId;
+}
+
+// Move along by a blank
+bool animationController::step()
+{
+	if (!animations)
+		return false;
+	frameAsset *last = current;
+
+	// Switch right away if something asked to
+	if (requested != ZBE_NO_ANIMATION)
+	{
+		show(requested, 0);
+		requested = ZBE_NO_ANIMATION;
+		return current != last;
+	}
+
+	// Frames with no time stay until something else is asked for, which playAfter() counts
+	if (!timer)
+	{
+		if (queued == ZBE_NO_ANIMATION)
+			return false;
+		show(queued, 0);
+		queued = ZBE_NO_ANIMATION;
+		return current != last;
+	}
+	if (--timer)
+		return false;
+
+	// On to the next frame, or the start of this animation or the next one after the last frame
+	if (animations[animation][frameIndex + 1] != NULL)
+		show(animation, frameIndex + 1);
+	else if (queued != ZBE_NO_ANIMATION)
+	{
+		show(queued, 0);
+		queued = ZBE_NO_ANIMATION;
+	}
+	else
+		show(animation, 0);
+
+	return current != last;
+}
+
+// Start showing a frame
+void animationController::show(int animationId, int frameId)
+{
+	animation = animationId;
+	frameIndex = frameId;
+	frameAsset *next = animations[animation][frameIndex];
+	if (next != current)
+		stale = true;
+	current = next;
+	timer = current->time;
+}
+
+// Look up the frame's gfx and palette
+void animationController::resolve()
+{
+	gfxMem = zbeAssets->getGfx(current->gfx);
+	paletteId = zbeAssets->getPalette(current->pal);
+	stale = false;
+}
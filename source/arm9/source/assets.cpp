@@ -95,6 +95,23 @@ void assets::parseZbe()
 
 		// Seek past this object
 		fseek(zbeData, newAsset->length, SEEK_CUR);
+
+		// The collision mask is small and needed every frame so it stays loaded
+		uint16 maskLength = load<uint16>(zbeData);
+		uint8 maskWords = (width + 31) >> 5;
+		if (maskLength && maskLength == height * maskWords * sizeof(uint32))
+		{
+			newAsset->mask = new uint32[height * maskWords];
+			newAsset->maskWords = maskWords;
+			if (fread(newAsset->mask, 1, maskLength, zbeData) < maskLength)
+				iprintf("W: gfx %d mask read failed\n", (int) i);
+		}
+		else
+		{
+			if (maskLength)
+				iprintf("W: gfx %d bad mask length\n", (int) i);
+			fseek(zbeData, maskLength, SEEK_CUR);
+		}
 	}
 
 
@@ -214,6 +231,12 @@ void assets::parseZbe()
 		// Seek past all the map data
 		fseek(zbeData, newAsset->length, SEEK_CUR);
 
+		// And the collision layer
+		newAsset->colLength = load<uint32>(zbeData);
+		fseek(zbeData, newAsset->colLength, SEEK_CUR);
+		if (newAsset->colLength > 0)
+			iprintf(" %dB collision layer\n", newAsset->colLength);
+
 		// Put this backgroundAsset on the vector
 		backgroundAssets.push_back(newAsset);
 	}
@@ -239,12 +262,19 @@ void assets::parseZbe()
 		// Weight of this object
 		uint8 weight = load<uint8>(zbeData);
 
+		// Its collision layers
+		uint16 category = load<uint16>(zbeData);
+		uint16 mask = load<uint16>(zbeData);
+
+		// Whether it's a sensor
+		bool isSensor = load<uint8>(zbeData);
+
 		// Number of animations
 		uint32 numAnimations = load<uint32>(zbeData);
 		iprintf(" %d: %d animations\n", i, numAnimations);
 
 		// Make the objectAsset and allocate for enough animations
-		objectAsset *newAsset = new objectAsset(weight);
+		objectAsset *newAsset = new objectAsset(weight, category, mask, isSensor);
 		newAsset->animations = new frameAsset**[numAnimations + 1];
 		// null terminate that dimension
 		newAsset->animations[numAnimations] = NULL;
@@ -278,6 +308,23 @@ void assets::parseZbe()
 				// The time to display this frame
 				thisFrame->time = load<uint8>(zbeData);
 
+				// Then its hitboxes and hurtboxes. Their counts share a byte, hitboxes in the low nibble.
+				uint8 numBoxes = load<uint8>(zbeData);
+				thisFrame->numHitboxes = numBoxes & 0xF;
+				thisFrame->numHurtboxes = numBoxes >> 4;
+				if (thisFrame->numHitboxes)
+				{
+					thisFrame->hitboxes = new frameBox[thisFrame->numHitboxes];
+					for (uint8 b = 0; b < thisFrame->numHitboxes; b++)
+						loadFrameBox(thisFrame->hitboxes[b]);
+				}
+				if (thisFrame->numHurtboxes)
+				{
+					thisFrame->hurtboxes = new frameBox[thisFrame->numHurtboxes];
+					for (uint8 b = 0; b < thisFrame->numHurtboxes; b++)
+						loadFrameBox(thisFrame->hurtboxes[b]);
+				}
+
 				// Set it up on the array
 				newAsset->animations[j][k] = thisFrame;
 
@@ -333,9 +380,10 @@ void assets::parseZbe()
 		// Push this asset onto the levelAssets vector
 		levelAssets.push_back(newAsset);
 
-		// Skip over the level's dimensions
+		// Skip over the level's dimensions and broadphase
 		load<uint32>(zbeData);
 		load<uint32>(zbeData);
+		load<uint8>(zbeData);
 
 #ifdef ZBE_TESTING
 		// Skip over the test explanation message
@@ -354,22 +402,24 @@ void assets::parseZbe()
 
 		// Skip over the backgrounds
 		// NOTE: keep this up to date!
-		//                        bg0     bg1     bg2     bg3     tileset
-		const static int bgSize = 4 + 1 + 4 + 1 + 4 + 1 + 4 + 1 + 4;
+		//                        bg0     bg1     bg2     bg3     tileset collision
+		const static int bgSize = 4 + 1 + 4 + 1 + 4 + 1 + 4 + 1 + 4 +    1;
 		fseek(zbeData, bgSize, SEEK_CUR);
 		iprintf(" bgs\n");
 
-		// The total number of bytes it takes to represent one level object in the
-		// assets file.
+		// The total number of bytes it takes to represent one level hero and one
+		// level object in the assets file.
 		// NOTE: Keep this up to date!
-		//                            object Id  X   Y   hgrav vgrav
-		const static int lvlObjSize = 4 +        2 + 2 + 4 +   4;
+		//                             object Id  X   Y   hgrav vgrav
+		const static int lvlHeroSize = 4 +        2 + 2 + 4 +   4;
+		//                                          static
+		const static int lvlObjSize = lvlHeroSize + 1;
 
 		// number of level heroes
 		uint32 numLvlHeroes = load<uint32>(zbeData);
 
 		// Seek past those heroes
-		fseek(zbeData, lvlObjSize * numLvlHeroes, SEEK_CUR);
+		fseek(zbeData, lvlHeroSize * numLvlHeroes, SEEK_CUR);
 		iprintf(" %d heroes", numLvlHeroes);
 
 		// number of level objects
@@ -442,6 +492,10 @@ levelAsset *assets::loadLevel(uint32 id)
 	lvl->dimensions.x = load<uint32>(zbeData);
 	lvl->dimensions.y = load<uint32>(zbeData);
 
+	// And which broadphase it uses
+	lvl->broadphase = load<uint8>(zbeData);
+	iprintf(" broadphase %d\n", (int) lvl->broadphase);
+
 #ifdef ZBE_TESTING
 	// Test explanation message
 	uint32 expLen = load<uint32>(zbeData);
@@ -487,6 +541,11 @@ levelAsset *assets::loadLevel(uint32 id)
 	lvl->tileset = tilesetAssets[tilesetId];
 	iprintf(" using tileset %d for bgs\n", tilesetId);
 
+	// And which one to collide with
+	lvl->collisionLayer = load<uint8>(zbeData);
+	if (lvl->collisionLayer != ZBE_NO_COLLISION_LAYER)
+		iprintf(" colliding with bg%d\n", (int) lvl->collisionLayer);
+
 	// number of level heroes
 	uint32 numLvlHeroes = load<uint32>(zbeData);
 	iprintf(" #heroes %d\n", numLvlHeroes);
@@ -502,17 +561,15 @@ levelAsset *assets::loadLevel(uint32 id)
 		uint32 objId = load<uint32>(zbeData);
 		uint16 x = load<uint16>(zbeData);
 		uint16 y = load<uint16>(zbeData);
-		int32 ihgrav = load<int32>(zbeData);
-		int32 ivgrav = load<int32>(zbeData);
-		// Convert 12.20 ints into floats by dividing by 2^12 = 4096
-		float fhgrav = float(ihgrav) / 4096.0;
-		float fvgrav = float(ivgrav) / 4096.0;
+		// Gravity is stored as 20.12 fixed point, which is exactly what fixed32 uses
+		fixed32 hgrav = fixed32::fromRaw(load<int32>(zbeData));
+		fixed32 vgrav = fixed32::fromRaw(load<int32>(zbeData));
 
 		iprintf("  #%d: obj%d at (%d, %d)\n", (int) i, (int) objId, (int) x, (int) y);
-		printf("       grav (%f, %f)\n", fhgrav, fvgrav);
+		iprintf("       grav (%ld, %ld) 20.12\n", (long int) hgrav.getRaw(), (long int) vgrav.getRaw());
 
 		// make a new levelObjectAsset and add it to the vector
-		levelObjectAsset *lvlObj = new levelObjectAsset(vector2D<float>(float(x), float(y)), vector2D<float>(fhgrav, fvgrav), objectAssets[objId]);
+		levelObjectAsset *lvlObj = new levelObjectAsset(vector2D<fixed32>(x, y), vector2D<fixed32>(hgrav, vgrav), objectAssets[objId]);
 		lvl->heroes[i] = lvlObj;
 	}
 
@@ -531,17 +588,16 @@ levelAsset *assets::loadLevel(uint32 id)
 		uint32 objId = load<uint32>(zbeData);
 		uint16 x = load<uint16>(zbeData);
 		uint16 y = load<uint16>(zbeData);
-		int32 ihgrav = load<int32>(zbeData);
-		int32 ivgrav = load<int32>(zbeData);
-		// Convert 12.20 ints into floats by dividing by 2^12 = 4096
-		float fhgrav = float(ihgrav) / 4096.0;
-		float fvgrav = float(ivgrav) / 4096.0;
+		// Gravity is stored as 20.12 fixed point, which is exactly what fixed32 uses
+		fixed32 hgrav = fixed32::fromRaw(load<int32>(zbeData));
+		fixed32 vgrav = fixed32::fromRaw(load<int32>(zbeData));
+		bool isStatic = load<uint8>(zbeData);
 
-		iprintf("  #%d: obj%d at (%d, %d)\n", (int) i, (int) objId, (int) x, (int) y);
-		printf("       grav (%f, %f)\n", fhgrav, fvgrav);
+		iprintf("  #%d: obj%d at (%d, %d)%s\n", (int) i, (int) objId, (int) x, (int) y, isStatic ? " static" : "");
+		iprintf("       grav (%ld, %ld) 20.12\n", (long int) hgrav.getRaw(), (long int) vgrav.getRaw());
 
 		// Make a new levelObjectAsset and add it to the vector
-		levelObjectAsset *lvlObj = new levelObjectAsset(vector2D<float>(float(x), float(y)), vector2D<float>(fhgrav, fvgrav), objectAssets[objId]);
+		levelObjectAsset *lvlObj = new levelObjectAsset(vector2D<fixed32>(x, y), vector2D<fixed32>(hgrav, vgrav), objectAssets[objId], isStatic);
 		lvl->objects[i] = lvlObj;
 	}
 
@@ -602,6 +658,19 @@ void assets::loadBackground(levelBackgroundAsset *lvlBackground)
 			die();
 		}
 
+		// Load up the collision layer if there is one
+		background->colLength = load<uint32>(zbeData);
+		if (background->colLength > 0)
+		{
+			iprintf(" Loading %dB collision\n", background->colLength);
+			background->collision = new uint8[background->colLength];
+			if (fread(background->collision, sizeof(uint8), background->colLength, zbeData) < background->colLength)
+			{
+				iprintf("Error reading collision layer from file: %s\n", strerror(errno));
+				die();
+			}
+		}
+
 		// Indicate that the background is mmLoaded
 		background->mmLoaded = true;
 	}
@@ -786,6 +855,15 @@ template <class T> T assets::load(FILE *input)
 }
 
 
+// Reads a frame's hitbox or hurtbox from the zbe file
+void assets::loadFrameBox(frameBox &box)
+{
+	box.topleft.x = load<uint8>(zbeData);
+	box.topleft.y = load<uint8>(zbeData);
+	box.dimensions.x = load<uint8>(zbeData);
+	box.dimensions.y = load<uint8>(zbeData);
+}
+
 // Given a width and a height returns an appropriate SpriteSize
 SpriteSize assets::getSpriteSize(uint8 width, uint8 height)
 {
@@ -8,7 +8,7 @@ background::background(levelBackgroundAsset *metadata, gfxAsset *tileset, uint8
 	lastScreenOffset = screenOffset;
 
 	// Adjust the screen offset for distance
-	vector2D<float> useScreenOffset = screenOffset;
+	vector2D<fixed32> useScreenOffset = screenOffset;
 	if (layer < 3)
 	{
 		useScreenOffset.x /= distance;
@@ -19,8 +19,8 @@ background::background(levelBackgroundAsset *metadata, gfxAsset *tileset, uint8
 		useScreenOffset.x *= distance;
 		useScreenOffset.y *= distance;
 	}
-	lastBgMapRepTL = vector2D<int>(int(useScreenOffset.x - 128) / 8 - 1, int(useScreenOffset.y - 32) / 8 - 1);
-	lastBgMapRepBR = vector2D<int>(int(useScreenOffset.x + SCREEN_WIDTH + 128) / 8, int(useScreenOffset.y + SCREEN_HEIGHT + 32) / 8);
+	lastBgMapRepTL = vector2D<int>((useScreenOffset.x - 128).toInt() / 8 - 1, (useScreenOffset.y - 32).toInt() / 8 - 1);
+	lastBgMapRepBR = vector2D<int>((useScreenOffset.x + SCREEN_WIDTH + 128).toInt() / 8, (useScreenOffset.y + SCREEN_HEIGHT + 32).toInt() / 8);
 
 
 	// Load up the backgroundAsset to get the map data
@@ -89,7 +89,7 @@ background::background(levelBackgroundAsset *metadata, gfxAsset *tileset, uint8
 void background::redraw()
 {
 	// Adjust the screen offset for distance
-	vector2D<float> useScreenOffset = screenOffset;
+	vector2D<fixed32> useScreenOffset = screenOffset;
 	if (layer < 3)
 	{
 		useScreenOffset.x /= distance;
@@ -107,7 +107,7 @@ void background::redraw()
 		for (uint8 x = 0; x < ZBE_BACKGROUND_TILE_WIDTH; x++)
 		{
 			// Copy the tile
-			copyTile(int(useScreenOffset.x - 128) / 8 + x, int(useScreenOffset.y - 32) / 8  + y);
+			copyTile((useScreenOffset.x - 128).toInt() / 8 + x, (useScreenOffset.y - 32).toInt() / 8  + y);
 		}
 	}
 }
@@ -117,8 +117,8 @@ void background::redraw()
 void background::update()
 {
 	// Find out how much things have moved
-	vector2D<float> displacement = vector2D<float>(screenOffset.x - lastScreenOffset.x , screenOffset.y - lastScreenOffset.y);
-	vector2D<float> useScreenOffset = screenOffset;
+	vector2D<fixed32> displacement = vector2D<fixed32>(screenOffset.x - lastScreenOffset.x , screenOffset.y - lastScreenOffset.y);
+	vector2D<fixed32> useScreenOffset = screenOffset;
 
 	// Adjust the screen offset for distance
 	if (layer < 3)
@@ -134,14 +134,14 @@ void background::update()
 
 	// scroll the background (mod by bg dimensions because hardware will crash if the value gets too big)
 	// Behind layers
-	bgSetScroll(backgroundId, int(useScreenOffset.x) % (ZBE_BACKGROUND_TILE_WIDTH * 8), int(useScreenOffset.y) % (ZBE_BACKGROUND_TILE_HEIGHT * 8));
+	bgSetScroll(backgroundId, useScreenOffset.x.toInt() % (ZBE_BACKGROUND_TILE_WIDTH * 8), useScreenOffset.y.toInt() % (ZBE_BACKGROUND_TILE_HEIGHT * 8));
 
 	// where to copy the replacement tiles from in background map
-	vector2D<int> bgMapRepTL(int(useScreenOffset.x - 128) / 8 - 1, int(useScreenOffset.y - 32) / 8 - 1);
-	vector2D<int> bgMapRepBR(int(useScreenOffset.x + SCREEN_WIDTH + 128) / 8, int(useScreenOffset.y + SCREEN_HEIGHT + 32) / 8);
+	vector2D<int> bgMapRepTL((useScreenOffset.x - 128).toInt() / 8 - 1, (useScreenOffset.y - 32).toInt() / 8 - 1);
+	vector2D<int> bgMapRepBR((useScreenOffset.x + SCREEN_WIDTH + 128).toInt() / 8, (useScreenOffset.y + SCREEN_HEIGHT + 32).toInt() / 8);
 
 	// If there are more tiles to replace than there are in the screen, just replace the whole thing and be done with it
-	if (((int) displacement.x % SCREEN_WIDTH) * ((int) displacement.y % SCREEN_HEIGHT) > SCREEN_HEIGHT * SCREEN_WIDTH)
+	if ((displacement.x.toInt() % SCREEN_WIDTH) * (displacement.y.toInt() % SCREEN_HEIGHT) > SCREEN_HEIGHT * SCREEN_WIDTH)
 	{
 		// Redraw the whole screen
 		redraw();
@@ -0,0 +1,45 @@
+#include "bodystore.h"
+
+// Make a slot for everyone
+void bodyStore::resize(unsigned int numObjects)
+{
+	position.resize(numObjects, vector2D<fixed32>(0, 0));
+	velocity.resize(numObjects, vector2D<fixed32>(0, 0));
+	acceleration.resize(numObjects, vector2D<fixed32>(0, 0));
+	gravity.resize(numObjects, vector2D<fixed32>(0, 0));
+	falling.resize(numObjects, true);
+	frame.resize(numObjects, NULL);
+	start.resize(numObjects, vector2D<fixed32>(0, 0));
+	active.resize(numObjects, false);
+}
+
+// Move everything that's awake
+ITCM_CODE void bodyStore::integrate(vector<int> &moved)
+{
+	unsigned int count = position.size();
+	if (!count)
+		return;
+
+	vector2D<fixed32> *pos = &position[0], *vel = &velocity[0], *acc = &acceleration[0], *grav = &gravity[0], *from = &start[0];
+	const uint8 *fall = &falling[0], *act = &active[0];
+	for (unsigned int id = 0; id < count; id++)
+	{
+		if (!act[id])
+			continue;
+		from[id] = pos[id];
+
+		if (fall[id])
+		{
+			vel[id].x += grav[id].x;
+			vel[id].y += grav[id].y;
+		}
+		vel[id].x += acc[id].x;
+		vel[id].y += acc[id].y;
+
+		pos[id].x += vel[id].x;
+		pos[id].y += vel[id].y;
+
+		if (vel[id].x != 0 || vel[id].y != 0)
+			moved.push_back(id);
+	}
+}
@@ -0,0 +1,88 @@
+#include "broadphase.h"
+#include "collisionmatrix.h"
+#include "sweepandprune.h"
+#include "aabbtree.h"
+
+// Utility: the time along a segment at which it crosses a slab edge.
+// t is only ever compared against 0 and 1, so clamp it to +-2 before dividing so it can't overflow.
+static inline fixed32 slabTime(fixed32 num, fixed32 den)
+{
+	if (abs(num) >= abs(den) + abs(den))
+		return ((num < 0) != (den < 0)) ? fixed32(-2) : fixed32(2);
+	return num / den;
+}
+
+// Make a new broadphase engine
+broadphase *newBroadphase(int type, int levelWidth, int levelHeight, vector<int> *objectExtents)
+{
+	switch (type)
+	{
+		case ZBE_BROADPHASE_SAP:
+			return new sweepAndPrune;
+
+		case ZBE_BROADPHASE_TREE:
+			return new aabbTree;
+
+		default:
+			iprintf("W: unknown broadphase %d\n", type);
+			// Fall through to the grid
+
+		case ZBE_BROADPHASE_GRID:
+		{
+			int blockSize = objectExtents ? collisionMatrix::chooseBlockSize(*objectExtents) : ZBE_GRID_DEFAULT_BLOCK;
+			return new collisionMatrix(levelWidth, levelHeight, blockSize);
+		}
+	}
+}
+
+// Slab test a segment against a box
+bool segmentHits(const vector2D<fixed32> &start, const vector2D<fixed32> &delta, const vector2D<fixed32> &min, const vector2D<fixed32> &max)
+{
+	fixed32 tMin = 0, tMax = 1;
+
+	// X slab
+	if (delta.x == 0)
+	{
+		if (start.x < min.x || start.x > max.x)
+			return false;
+	}
+	else
+	{
+		fixed32 t1 = slabTime(min.x - start.x, delta.x);
+		fixed32 t2 = slabTime(max.x - start.x, delta.x);
+		if (t1 > t2)
+		{
+			fixed32 t = t1;
+			t1 = t2;
+			t2 = t;
+		}
+		if (t1 > tMin) tMin = t1;
+		if (t2 < tMax) tMax = t2;
+		if (tMin > tMax)
+			return false;
+	}
+
+	// Y slab
+	if (delta.y == 0)
+	{
+		if (start.y < min.y || start.y > max.y)
+			return false;
+	}
+	else
+	{
+		fixed32 t1 = slabTime(min.y - start.y, delta.y);
+		fixed32 t2 = slabTime(max.y - start.y, delta.y);
+		if (t1 > t2)
+		{
+			fixed32 t = t1;
+			t1 = t2;
+			t2 = t;
+		}
+		if (t1 > tMin) tMin = t1;
+		if (t2 < tMax) tMax = t2;
+		if (tMin > tMax)
+			return false;
+	}
+
+	return true;
+}
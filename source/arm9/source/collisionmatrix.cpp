@@ -1,26 +1,45 @@
 #include "collisionmatrix.h"
+#include <algorithm>
 
 /**
  *  objGroup functions
  */
 
+// Add an object to the front of the group
+void objGroup::add(object *add)
+{
+	// Link it in before the current first object
+	add->group = this;
+	add->groupPrev = NULL;
+	add->groupNext = first;
+	if (first)
+		first->groupPrev = add;
+	first = add;
+
+	numObjects++;
+}
+
 // Remove an object from the group
 bool objGroup::remove(object *remove)
 {
-	// Go through that vector looking for the object
-	for(std::vector<object*>::iterator c = objects.begin(); c != objects.end(); ++c)
-	{
-		if (*c == remove)
-		{
-			// found it, now erase it
-			objects.erase(c);
+	// The object knows which group it's in, so no searching is needed
+	if (remove->group != this)
+		return false;
 
-			// Done here
-			return true;
-		}
-	}
+	// Unlink it from its neighbours
+	if (remove->groupPrev)
+		remove->groupPrev->groupNext = remove->groupNext;
+	else
+		first = remove->groupNext;
+	if (remove->groupNext)
+		remove->groupNext->groupPrev = remove->groupPrev;
 
-	return false;
+	// Clear its links
+	remove->group = NULL;
+	remove->groupPrev = remove->groupNext = NULL;
+
+	numObjects--;
+	return true;
 }
 
 
@@ -30,167 +49,415 @@ bool objGroup::remove(object *remove)
  *  collisionMatrix functions
  */
 
+// Utility: a forEachCandidate visitor that pushes every candidate onto a vector
+struct candidateCollector
+{
+	vector<object*> candidates;
+
+	inline void operator()(object *candidate)
+	{
+		candidates.push_back(candidate);
+	}
+};
+
 // Constructor
 collisionMatrix::collisionMatrix(int levelWidth, int levelHeight, int blockSqSz)
 {
-	// Figure out the groupsWidth and groupsHeight by dividing level width and
-	// height by the blockSqSize. Add one to these to make sure the whole level
-	// is represented (remember int division rounds down).
 	blockSqSize = blockSqSz;
-	groupsWidth = levelWidth / blockSqSize + 1;
-	groupsHeight = levelHeight / blockSqSize + 1;
-
-	// Allocate data for the groups array
-	groups = new objGroup**[groupsWidth];
-	for (int i = 0; i < groupsWidth; i++)
-	{
-		groups[i] = new objGroup*[groupsHeight];
 
-		for (int j = 0; j < groupsHeight; j++)
-			groups[i][j] = new objGroup;
-	}
+	// Start with a bucket per block for small levels. Bigger ones start at
+	// ZBE_GRID_START_BUCKETS and grow as blocks fill up.
+	int levelBlocks = (levelWidth / blockSqSize + 1) * (levelHeight / blockSqSize + 1);
+	unsigned int numBuckets = 4;
+	while ((int) numBuckets < levelBlocks && numBuckets < ZBE_GRID_START_BUCKETS)
+		numBuckets <<= 1;
+	buckets.resize(numBuckets, NULL);
 }
 
 // Deconstructor
 collisionMatrix::~collisionMatrix()
 {
+	// Delete the big objects' records
+	for (unsigned int i = 0; i < bigObjects.size(); i++)
+		delete bigObjects[i];
+
 	// Delete all the objGroups
-	for(int i = 0; i < groupsWidth; i++)
-	{
-		for (int j = 0; j < groupsHeight; j++)
-			delete groups[i][j];
-		delete groups[i];
-	}
-	delete groups;
+	for (unsigned int i = 0; i < occupied.size(); i++)
+		delete occupied[i];
+	for (unsigned int i = 0; i < spare.size(); i++)
+		delete spare[i];
 }
 
-// Utility: convertCoords from world to group coordinates
-vector2D<int> collisionMatrix::convertCoords(vector2D<float> position)
+// Pick a block size from the objects' sizes
+int collisionMatrix::chooseBlockSize(vector<int> &extents)
 {
-	// Find its corresponding blocks position
-	int x = position.x / blockSqSize;
-	int y = position.y / blockSqSize;
+	if (extents.empty())
+		return ZBE_GRID_DEFAULT_BLOCK;
 
-	// Check bounds
-	if (x < 0 || x > groupsWidth || y < 0 || y > groupsHeight)
-		return vector2D<int>(-1, -1);
-	else
-		return vector2D<int>(x, y);
+	// Find the extent that ZBE_GRID_FIT_PERCENT of the objects are no bigger than
+	unsigned int fit = (extents.size() - 1) * ZBE_GRID_FIT_PERCENT / 100;
+	nth_element(extents.begin(), extents.begin() + fit, extents.end());
+
+	// Round it up to a power of two
+	int size = ZBE_GRID_MIN_BLOCK;
+	while (size < extents[fit] && size < ZBE_GRID_MAX_BLOCK)
+		size <<= 1;
+
+	return size;
 }
 
-// Get an objGroup
-objGroup *collisionMatrix::getObjGroup(vector2D<float> position)
+// Get the group for a block, making one if needed
+objGroup *collisionMatrix::makeGroup(int x, int y)
 {
-	// Convert coordinates
-	vector2D<int> coords = convertCoords(position);
+	objGroup *group = findGroup(x, y);
+	if (group)
+		return group;
+
+	// Grow the hash table once there are more groups than buckets
+	if (occupied.size() >= buckets.size())
+	{
+		buckets.assign(buckets.size() * 2, NULL);
+		for (unsigned int i = 0; i < occupied.size(); i++)
+		{
+			unsigned int bucket = hashBlock(occupied[i]->x, occupied[i]->y);
+			occupied[i]->hashNext = buckets[bucket];
+			buckets[bucket] = occupied[i];
+		}
+	}
 
-	// Check bounds
-	if (coords.x < 0 || coords.y < 0)
+	// Reuse an old group if there is one
+	if (spare.empty())
+		group = new objGroup;
+	else
 	{
-		iprintf("W: colM get pos out of bounds\n");
-		return NULL;
+		group = spare.back();
+		spare.pop_back();
 	}
 
-	// Return group
-	return groups[coords.x][coords.y];
+	// Link it into its bucket and the occupied list
+	group->x = x;
+	group->y = y;
+	unsigned int bucket = hashBlock(x, y);
+	group->hashNext = buckets[bucket];
+	buckets[bucket] = group;
+	group->slot = occupied.size();
+	occupied.push_back(group);
+
+	return group;
+}
+
+// Put a group aside if it's empty
+void collisionMatrix::releaseGroup(objGroup *group)
+{
+	if (group->first || !group->big.empty())
+		return;
+
+	// Unlink it from its bucket
+	objGroup **link = &buckets[hashBlock(group->x, group->y)];
+	while (*link != group)
+		link = &(*link)->hashNext;
+	*link = group->hashNext;
+	group->hashNext = NULL;
+
+	// Swap the last occupied group into its slot
+	objGroup *last = occupied.back();
+	occupied[group->slot] = last;
+	last->slot = group->slot;
+	occupied.pop_back();
+
+	spare.push_back(group);
+}
+
+// Get an objGroup
+objGroup *collisionMatrix::getObjGroup(vector2D<fixed32> position)
+{
+	vector2D<int> coords = convertCoords(position);
+	return findGroup(coords.x, coords.y);
 }
 
 // Add an object to its objGroup
 objGroup *collisionMatrix::addObject(object *add)
 {
-	// Convert the object's position from world to group coords
+	// Objects that don't fit in a block go in every block they overlap
+	if (!fitsInBlock(add))
+		return placeBig(add, NULL);
+
+	// Convert the object's position from world to group coords and add it there
 	vector2D<int> coords = convertCoords(add->position);
+	objGroup *group = makeGroup(coords.x, coords.y);
+	group->add(add);
+	cachePairs(add);
 
-	// Check bounds
-	if (coords.x < 0 || coords.y < 0)
+	return group;
+}
+
+// Move an object to the objGroup for its current position
+objGroup *collisionMatrix::moveObject(object *move)
+{
+	// Objects in a group can't be big so only look for the others' records
+	bigObject *big = move->group ? NULL : findBig(move);
+	if (!fitsInBlock(move))
 	{
-		iprintf("W: colM add obj out of bounds\n");
-		return NULL;
+		if (move->group)
+			removeObject(move);
+		return placeBig(move, big);
 	}
 
-	// Add to the group
-	groups[coords.x][coords.y]->objects.push_back(add);
+	// It shrank back down to fit in a block
+	if (big)
+		dropBig(big);
+
+	// Nothing to do if it's still in the same block
+	vector2D<int> coords = convertCoords(move->position);
+	objGroup *from = move->group;
+	if (from && from->x == coords.x && from->y == coords.y)
+		return from;
 
-	// Return that group
-	return groups[coords.x][coords.y];
+	// Otherwise, relink it and find what's near it now
+	objGroup *dest = makeGroup(coords.x, coords.y);
+	if (from)
+	{
+		from->remove(move);
+		releaseGroup(from);
+		uncachePairs(move);
+	}
+	dest->add(move);
+	cachePairs(move);
+
+	return dest;
 }
 
-// Return an array of object pointers that may be colliding with object at x, y
-vector <object*> collisionMatrix::getCollisionCandidates(vector2D<float> position)
+// Remove an object from the matrix
+bool collisionMatrix::removeObject(object *remove)
 {
-	// First, convert the coordinates and return an empty array if invalid
-	vector2D<int> coords = convertCoords(position);
-	if(coords.x < 0 || coords.y < 0)
+	// The next findPairs can't look at it anymore
+	unsigned int id = remove->getObjectId();
+	if (id < isChanged.size() && isChanged[id])
 	{
-		iprintf("W: colM getCC pos out of bounds\n");
-		return vector<object*>();
+		isChanged[id] = false;
+		changed.erase(find(changed.begin(), changed.end(), remove));
 	}
 
-	// Now, we want to return the objects in the objGroup for these coordinates
-	// plus the objGroup above, to the left, and to the upperleft. These groups
-	// contain the only objects that could possibly be colliding with this object
-	// This group
-	vector<object*> toReturn = groups[coords.x][coords.y]->objects;
+	if (!remove->group)
+	{
+		bigObject *big = findBig(remove);
+		if (!big)
+			return false;
 
-	// The others -- Make sure that they are valid first
-	// Left
-	if (coords.x > 0)
+		dropBig(big);
+		return true;
+	}
+
+	objGroup *group = remove->group;
+	if (!group->remove(remove))
+		return false;
+
+	releaseGroup(group);
+	uncachePairs(remove);
+	return true;
+}
+
+// Find everything in a region
+void collisionMatrix::findCandidates(vector2D<fixed32> min, vector2D<fixed32> max, vector<object*> &found)
+{
+	regionCollector collect(found);
+	queryRegion(min, max, collect);
+}
+
+// Return an array of object pointers that may be colliding with object at x, y
+vector <object*> collisionMatrix::getCollisionCandidates(vector2D<fixed32> position)
+{
+	// Just collect everything forEachCandidate finds
+	candidateCollector collect;
+	forEachCandidate(position, collect);
+	return collect.candidates;
+}
+
+// Find an object's bigObject
+bigObject *collisionMatrix::findBig(object *obj)
+{
+	// There are only ever a handful of these
+	for (unsigned int i = 0; i < bigObjects.size(); i++)
+		if (bigObjects[i]->obj == obj)
+			return bigObjects[i];
+	return NULL;
+}
+
+// List a big object in every block it overlaps
+objGroup *collisionMatrix::placeBig(object *obj, bigObject *big)
+{
+	if (!big)
 	{
-		// Add it to the return vector
-		vector<object*> add = groups[coords.x - 1][coords.y]->objects;
-		toReturn.insert(toReturn.end(), add.begin(), add.end());
+		big = new bigObject;
+		big->obj = obj;
+		big->minX = big->minY = 0;
+		big->maxX = big->maxY = -1;
+		bigObjects.push_back(big);
 	}
-	// Up-Left
-	if (coords.x > 0 && coords.y > 0)
+
+	// Find the blocks under its bounding box
+	vector2D<fixed32> topleft, bottomright;
+	getBounds(obj, topleft, bottomright);
+	int minX = blockOf(topleft.x), minY = blockOf(topleft.y);
+	int maxX = blockOf(bottomright.x), maxY = blockOf(bottomright.y);
+
+	// Nothing to do if it's still over the same blocks
+	if (minX != big->minX || minY != big->minY || maxX != big->maxX || maxY != big->maxY)
 	{
-		// Add it to the return vector
-		vector<object*> add = groups[coords.x - 1][coords.y - 1]->objects;
-		toReturn.insert(toReturn.end(), add.begin(), add.end());
+		unlistBig(big);
+		big->minX = minX;
+		big->minY = minY;
+		big->maxX = maxX;
+		big->maxY = maxY;
+		for (int x = minX; x <= maxX; x++)
+			for (int y = minY; y <= maxY; y++)
+				makeGroup(x, y)->big.push_back(big);
+
+		// What's near it changed with its blocks
+		uncachePairs(obj);
+		cacheBigPairs(big);
 	}
-	// Up
-	if (coords.y > 0)
+
+	return findGroup(big->minX, big->minY);
+}
+
+// Take a big object out of every block it's listed in
+void collisionMatrix::unlistBig(bigObject *big)
+{
+	for (int x = big->minX; x <= big->maxX; x++)
 	{
-		// Add it to the return vector
-		vector<object*> add = groups[coords.x][coords.y - 1]->objects;
-		toReturn.insert(toReturn.end(), add.begin(), add.end());
+		for (int y = big->minY; y <= big->maxY; y++)
+		{
+			objGroup *group = findGroup(x, y);
+			group->big.erase(find(group->big.begin(), group->big.end(), big));
+			releaseGroup(group);
+		}
 	}
-	// Up-Right
-	if (coords.y > 0 && coords.x / blockSqSize < groupsWidth)
+}
+
+// Forget about a big object
+void collisionMatrix::dropBig(bigObject *big)
+{
+	unlistBig(big);
+	uncachePairs(big->obj);
+	bigObjects.erase(find(bigObjects.begin(), bigObjects.end(), big));
+	delete big;
+}
+
+// Find everything near an object that was just put in a group
+void collisionMatrix::cachePairs(object *obj)
+{
+	int x = obj->group->x, y = obj->group->y;
+
+	// The objects in the blocks around it
+	for (int nx = x - 1; nx <= x + 1; nx++)
 	{
-		// Add it to the return vector
-		vector<object*> add = groups[coords.x + 1][coords.y - 1]->objects;
-		toReturn.insert(toReturn.end(), add.begin(), add.end());
+		for (int ny = y - 1; ny <= y + 1; ny++)
+		{
+			objGroup *group = findGroup(nx, ny);
+			if (!group)
+				continue;
+			for (object *o = group->first; o; o = o->groupNext)
+				if (o != obj)
+					linkNear(obj, o);
+		}
 	}
-	// Right
-	if (coords.x / blockSqSize < groupsWidth)
+
+	// The big objects in the blocks it can reach. One can be in more than one of them.
+	vector<object*> &objNear = nearOf(obj);
+	for (int nx = x; nx <= x + 1; nx++)
 	{
-		// Add it to the return vector
-		vector<object*> add = groups[coords.x + 1][coords.y]->objects;
-		toReturn.insert(toReturn.end(), add.begin(), add.end());
+		for (int ny = y; ny <= y + 1; ny++)
+		{
+			objGroup *group = findGroup(nx, ny);
+			if (!group)
+				continue;
+			for (unsigned int b = 0; b < group->big.size(); b++)
+			{
+				object *bigObj = group->big[b]->obj;
+				if (find(objNear.begin(), objNear.end(), bigObj) == objNear.end())
+					linkNear(obj, bigObj);
+			}
+		}
 	}
-	// Down-Right
-	if (coords.y / blockSqSize < groupsHeight && coords.x / blockSqSize < groupsWidth)
+}
+
+// Find everything near a big object that was just listed in its blocks
+void collisionMatrix::cacheBigPairs(bigObject *big)
+{
+	// The objects that can reach into its blocks are in them or the blocks up and to the left
+	for (int x = big->minX - 1; x <= big->maxX; x++)
 	{
-		// Add it to the return vector
-		vector<object*> add = groups[coords.x + 1][coords.y + 1]->objects;
-		toReturn.insert(toReturn.end(), add.begin(), add.end());
+		for (int y = big->minY - 1; y <= big->maxY; y++)
+		{
+			objGroup *group = findGroup(x, y);
+			if (!group)
+				continue;
+			for (object *o = group->first; o; o = o->groupNext)
+				linkNear(big->obj, o);
+
+			// The other big objects listed in its blocks
+			if (x < big->minX || y < big->minY)
+				continue;
+			vector<object*> &bigNear = nearOf(big->obj);
+			for (unsigned int b = 0; b < group->big.size(); b++)
+			{
+				object *other = group->big[b]->obj;
+				if (other != big->obj && find(bigNear.begin(), bigNear.end(), other) == bigNear.end())
+					linkNear(big->obj, other);
+			}
+		}
 	}
-	// Down
-	if (coords.y / blockSqSize < groupsHeight)
+}
+
+// Forget everything near an object
+void collisionMatrix::uncachePairs(object *obj)
+{
+	vector<object*> &objNear = nearOf(obj);
+	for (unsigned int i = 0; i < objNear.size(); i++)
 	{
-		// Add it to the return vector
-		vector<object*> add = groups[coords.x][coords.y + 1]->objects;
-		toReturn.insert(toReturn.end(), add.begin(), add.end());
+		// Swap the last one into its place in the other's list
+		vector<object*> &otherNear = nearOf(objNear[i]);
+		vector<object*>::iterator it = find(otherNear.begin(), otherNear.end(), obj);
+		*it = otherNear.back();
+		otherNear.pop_back();
 	}
-	// Down-Left
-	if (coords.x > 0 && coords.y / blockSqSize < groupsHeight)
+	objNear.clear();
+}
+
+// Find the pairs the objects that moved are in
+unsigned int collisionMatrix::findPairs(vector<bool> &objMoved, vector<objPair> &pairs)
+{
+	unsigned int numPairs = 0;
+	for (unsigned int i = 0; i < changed.size(); i++)
 	{
-		// Add it to the return vector
-		vector<object*> add = groups[coords.x - 1][coords.y + 1]->objects;
-		toReturn.insert(toReturn.end(), add.begin(), add.end());
+		object *a = changed[i];
+		unsigned int idA = a->getObjectId();
+		if (idA >= objMoved.size() || !objMoved[idA])
+			continue;
+
+		vector<object*> &aNear = nearOf(a);
+		for (unsigned int n = 0; n < aNear.size(); n++)
+		{
+			// Pairs where both moved come up from the one with the lower id
+			object *b = aNear[n];
+			unsigned int idB = b->getObjectId();
+			if (idB < idA && idB < objMoved.size() && objMoved[idB] && idB < isChanged.size() && isChanged[idB])
+				continue;
+
+			numPairs++;
+			if (!a->layersCollide(b))
+				continue;
+
+			objPair pair = {a, b};
+			pairs.push_back(pair);
+		}
 	}
 
-	// all done, just need to return the vector
-	return toReturn;
-}
+	// Start over for next frame
+	for (unsigned int i = 0; i < changed.size(); i++)
+		isChanged[changed[i]->getObjectId()] = false;
+	changed.clear();
 
+	return numPairs;
+}
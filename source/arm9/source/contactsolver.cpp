@@ -0,0 +1,179 @@
+#include "contactsolver.h"
+#include <algorithm>
+
+using namespace decapod;
+
+// Add a contact to solve
+void contactSolver::addContact(object *a, object *b)
+{
+	contacts.push_back(contact());
+	findContact(a, b, contacts.back());
+}
+
+// Resolve all the contacts
+void contactSolver::solve(vector<object*> &pushed)
+{
+	pushed.clear();
+	unsigned int numContacts = contacts.size();
+
+	// Find how far down each object is from something static. Anything touching a static object
+	// is 1, anything touching one of those is 2, and so on.
+	for (unsigned int i = 0; i < numContacts; i++)
+	{
+		unsigned int idA = contacts[i].a->getObjectId(), idB = contacts[i].b->getObjectId();
+		unsigned int needed = ((idA > idB) ? idA : idB) + 1;
+		if (needed > depthOf.size())
+			depthOf.resize(needed, ZBE_SOLVER_FLOATING);
+		depthOf[idA] = contacts[i].a->isStatic ? 0 : ZBE_SOLVER_FLOATING;
+		depthOf[idB] = contacts[i].b->isStatic ? 0 : ZBE_SOLVER_FLOATING;
+	}
+	for (int pass = 0; pass < ZBE_SOLVER_MAX_DEPTH; pass++)
+	{
+		bool changed = false;
+		for (unsigned int i = 0; i < numContacts; i++)
+		{
+			uint16 &depthA = depthOf[contacts[i].a->getObjectId()], &depthB = depthOf[contacts[i].b->getObjectId()];
+			if (depthA + 1 < depthB)
+			{
+				depthB = depthA + 1;
+				changed = true;
+			}
+			else if (depthB + 1 < depthA)
+			{
+				depthA = depthB + 1;
+				changed = true;
+			}
+		}
+		if (!changed)
+			break;
+	}
+
+	// Whatever is holding something else up can't be pushed by it. Solving from the bottom up
+	// then settles a whole stack in one go.
+	for (unsigned int i = 0; i < numContacts; i++)
+	{
+		contact &c = contacts[i];
+		uint16 depthA = depthOf[c.a->getObjectId()], depthB = depthOf[c.b->getObjectId()];
+		if (depthA < depthB)
+		{
+			c.shareA = 0;
+			c.shareB = 1;
+		}
+		else if (depthB < depthA)
+		{
+			c.shareA = 1;
+			c.shareB = 0;
+		}
+	}
+	depthSorter byDepth(depthOf);
+	sort(contacts.begin(), contacts.end(), byDepth);
+
+	// Warm start: put back the impulse from last frame if they're touching the same way
+	nextCache.clear();
+	for (unsigned int i = 0; i < numContacts; i++)
+	{
+		contact &c = contacts[i];
+		cachedImpulse find;
+		find.key = pairKey(c.a, c.b);
+		vector<cachedImpulse>::iterator last = lower_bound(cache.begin(), cache.end(), find);
+		if (last == cache.end() || last->key != find.key || last->xAxis != c.xAxis)
+			continue;
+
+		// The cache doesn't know which object was a, so line its sign up with this one
+		int sign = (c.a->getObjectId() < c.b->getObjectId()) ? last->sign : -last->sign;
+		if (sign != c.sign)
+			continue;
+
+		c.impulse = last->impulse;
+		applyImpulse(c, c.impulse);
+	}
+
+	// Velocity: stop them moving into each other
+	for (int iteration = 0; iteration < ZBE_SOLVER_VELOCITY_ITERATIONS; iteration++)
+	{
+		for (unsigned int i = 0; i < numContacts; i++)
+		{
+			contact &c = contacts[i];
+			fixed32 closing = axis(c.a->velocity, c.xAxis) - axis(c.b->velocity, c.xAxis);
+			if (c.sign < 0)
+				closing = -closing;
+
+			// Never pull them together
+			fixed32 impulse = c.impulse + closing;
+			if (impulse < 0)
+				impulse = 0;
+			applyImpulse(c, impulse - c.impulse);
+			c.impulse = impulse;
+		}
+	}
+
+	// Position: push them apart by whatever they still overlap
+	for (int iteration = 0; iteration < ZBE_SOLVER_POSITION_ITERATIONS; iteration++)
+	{
+		for (unsigned int i = 0; i < numContacts; i++)
+		{
+			contact &c = contacts[i];
+			fixed32 apart = (axis(c.b->position, c.xAxis) - axis(c.startB, c.xAxis)) - (axis(c.a->position, c.xAxis) - axis(c.startA, c.xAxis));
+			if (c.sign < 0)
+				apart = -apart;
+
+			fixed32 overlap = c.depth - apart;
+			if (overlap <= 0)
+				continue;
+
+			fixed32 push = (c.sign > 0) ? overlap : -overlap;
+			axis(c.a->position, c.xAxis) -= push * c.shareA;
+			axis(c.b->position, c.xAxis) += push * c.shareB;
+		}
+	}
+
+	// Keep the impulses for next frame and let everything that was pushed know
+	for (unsigned int i = 0; i < numContacts; i++)
+	{
+		contact &c = contacts[i];
+		if (c.impulse > 0)
+		{
+			cachedImpulse keep;
+			keep.key = pairKey(c.a, c.b);
+			keep.xAxis = c.xAxis;
+			keep.sign = (c.a->getObjectId() < c.b->getObjectId()) ? c.sign : -c.sign;
+			keep.impulse = c.impulse;
+			nextCache.push_back(keep);
+		}
+
+		object *objs[2] = {c.a, c.b};
+		vector2D<fixed32> starts[2] = {c.startA, c.startB};
+		for (int o = 0; o < 2; o++)
+		{
+			unsigned int id = objs[o]->getObjectId();
+			if (id >= isPushed.size())
+				isPushed.resize(id + 1, false);
+			if (isPushed[id] || (objs[o]->position.x == starts[o].x && objs[o]->position.y == starts[o].y))
+				continue;
+
+			isPushed[id] = true;
+			pushed.push_back(objs[o]);
+		}
+	}
+	sort(nextCache.begin(), nextCache.end());
+	cache.swap(nextCache);
+	contacts.clear();
+
+	for (unsigned int i = 0; i < pushed.size(); i++)
+	{
+		isPushed[pushed[i]->getObjectId()] = false;
+		pushed[i]->moved();
+	}
+}
+
+// Forget an object's impulses
+void contactSolver::removeObject(object *obj)
+{
+	// Keep the rest in order
+	uint32 id = obj->getObjectId();
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < cache.size(); i++)
+		if ((cache[i].key >> 16) != id && (cache[i].key & 0xFFFF) != id)
+			cache[kept++] = cache[i];
+	cache.resize(kept);
+}
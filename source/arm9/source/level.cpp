@@ -1,12 +1,58 @@
 #include "level.h"
 
+// Utility: a staticGeometry visitor that pushes everything it finds onto a vector
+struct sweepCollector
+{
+	sweepCollector(vector<object*> &Found) : found(Found)
+	{}
+
+	inline bool operator()(object *obj)
+	{
+		found.push_back(obj);
+		return true;
+	}
+
+	vector<object*> &found;
+};
+
+// Utility: whether an object moved further than its own size on either axis
+static inline bool isFastMover(object *obj, const vector2D<fixed32> &from)
+{
+	if (!obj->frame)
+		return false;
+	return abs(obj->position.x - from.x) > fixed32(obj->frame->dimensions.x) ||
+	       abs(obj->position.y - from.y) > fixed32(obj->frame->dimensions.y);
+}
+
+// Utility: how far an object reaches from its position in any of its frames, the
+// bigger of its width and height
+static int objectExtent(objectAsset *obj)
+{
+	int extent = 0;
+	for (int i = 0; obj->animations[i] != NULL; i++)
+	{
+		for (int j = 0; obj->animations[i][j] != NULL; j++)
+		{
+			gfxAsset *gfx = obj->animations[i][j]->gfx;
+			int x = gfx->topleft.x + gfx->dimensions.x;
+			int y = gfx->topleft.y + gfx->dimensions.y;
+			if (x > extent)
+				extent = x;
+			if (y > extent)
+				extent = y;
+		}
+	}
+	return extent;
+}
+
 // level constructor
-level::level(levelAsset *m, OamState *o)
+level::level(levelAsset *m, OamState *o, int broadphaseType)
 {
 	// set the oam and metadata
 	oam = o;
 	metadata = m;
-	levelSize = vector2D<float>(metadata->dimensions.x, metadata->dimensions.y);
+	levelSize = vector2D<fixed32>(metadata->dimensions.x, metadata->dimensions.y);
+	zbeLevel = this;
 
 	// No palettes loaded
 	numBackgroundPalettes = 0;
@@ -17,44 +63,106 @@ level::level(levelAsset *m, OamState *o)
 		matrixAvail[i] = true;
 	}
 
-	// initialize the collisionMatrix
-	colMatrix = new collisionMatrix(metadata->dimensions.x, metadata->dimensions.y, 64);
+	// initialize the broadphase collision engine
+	if (broadphaseType == ZBE_BROADPHASE_FROM_LEVEL)
+		broadphaseType = metadata->broadphase;
+	// The grid sizes its blocks to fit the objects that will be in it
+	vector<int> extents;
+	for (unsigned int i = 0; metadata->heroes[i] != NULL; i++)
+		extents.push_back(objectExtent(metadata->heroes[i]->obj));
+	for (unsigned int i = 0; metadata->objects[i] != NULL; i++)
+		if (!metadata->objects[i]->isStatic)
+			extents.push_back(objectExtent(metadata->objects[i]->obj));
+	colEngine = newBroadphase(broadphaseType, metadata->dimensions.x, metadata->dimensions.y, &extents);
+	numBroadPairs = numNarrowPairs = 0;
+
+	// Every object needs its slot in the bodyStore and its bucket before it's made
+	unsigned int numHeroes = 0, numPlainObjects = 0;
+	while (metadata->heroes[numHeroes] != NULL)
+		++numHeroes;
+	while (metadata->objects[numPlainObjects] != NULL)
+		++numPlainObjects;
+	// Spawned objects are all plain objects and get the ids after the rest
+	firstSpawnId = numHeroes + numPlainObjects;
+	unsigned int numIds = firstSpawnId + ZBE_SPAWN_CAPACITY;
+	bodies.resize(numIds);
+	heroes.reserve(numHeroes);
+	plainObjects.reserve(numPlainObjects + ZBE_SPAWN_CAPACITY);
 
 	// Parse the levelAssets metadata
 	// Load up all the objects
 	int objId = 0;
 	for (unsigned int i = 0; metadata->heroes[i] != NULL; i++, objId++)
 	{
-		// This is the objectAsset for this levelObjectAsset
-		objectAsset *obj = metadata->heroes[i]->obj;
-
 		// Make the new hero
-		object *newObj = (object*) new hero(oam, objId, obj->animations, metadata->heroes[i]->position, metadata->heroes[i]->gravity, obj->weight);
+		object *newObj = heroes.add(oam, objId, &bodies, metadata->heroes[i]);
 
 		// Add the new object to the list of objects
 		objects.push_back(newObj);
 
-		// Add the object to the collisionMatrix and push its objGroup onto the objectsGroups vector
-		objectsGroups.push_back(colMatrix->addObject(newObj));
+		// Add the object to the broadphase unless it can't collide with anything
+		if (!newObj->collidesWithNothing())
+			colEngine->insertObject(newObj);
 	}
 
 	// Parse the levelAssets metadata
 	// Load up all the objects
+	vector<object*> statics;
 	for (unsigned int i = 0; metadata->objects[i] != NULL; i++, objId++)
 	{
-		// This is the objectAsset for this levelObjectAsset
-		objectAsset *obj = metadata->objects[i]->obj;
-
 		// Make the new object
-		object *newObj = new object(oam, objId, obj->animations, metadata->objects[i]->position, metadata->objects[i]->gravity, obj->weight);
+		object *newObj = plainObjects.add(oam, objId, &bodies, metadata->objects[i]);
 
 		// Add the new object to the list of objects
 		objects.push_back(newObj);
 
-		// Add the object to the collisionMatrix and push its objGroup onto the objectsGroups vector
-		objectsGroups.push_back(colMatrix->addObject(newObj));
+		// Objects that can't collide with anything, like decorations, don't need to be in either
+		if (newObj->collidesWithNothing())
+			continue;
+
+		// Static objects get baked into the static geometry below, everything else goes in the broadphase
+		if (metadata->objects[i]->isStatic)
+		{
+			newObj->isStatic = true;
+			statics.push_back(newObj);
+		}
+		else
+			colEngine->insertObject(newObj);
 	}
 
+	// Bake the static geometry
+	staticGeo = new staticGeometry(statics, metadata->dimensions.x, metadata->dimensions.y);
+
+	// Everything but the static objects gets moved
+	for (unsigned int i = 0; i < objects.size(); i++)
+		bodies.setActive(i, !objects[i]->isStatic);
+
+	// Nothing has been spawned yet
+	objects.resize(numIds, NULL);
+	generations.resize(numIds, 0);
+	for (int id = numIds - 1; id >= firstSpawnId; id--)
+		freeIds.push_back(id);
+	pendingSpawns.reserve(ZBE_SPAWN_CAPACITY);
+	pendingDespawns.reserve(ZBE_SPAWN_CAPACITY);
+
+	// Nothing has moved yet
+	objMoved.resize(objects.size(), false);
+
+	// Get everyone's box
+	boxes.resize(objects.size());
+	for (int i = 0; i < firstSpawnId; i++)
+		boxes.update(objects[i]);
+
+	// And nothing is asleep
+	islandParent.resize(objects.size());
+	islandRest.resize(objects.size());
+	sleeperHead.resize(objects.size(), -1);
+	sleeperNext.resize(objects.size(), -1);
+	numAsleep = 0;
+
+	// Nothing's been drawn yet, so clear every sprite the first time
+	spritesUsed = SPRITE_COUNT;
+
 
 	// Load up the backgrounds
 	// Level dimensions are determined by the biggest background in the back layers
@@ -79,17 +187,26 @@ level::level(levelAsset *m, OamState *o)
 		else
 			bgHide(i);
 	}
+
+	// Set up the tiles objects collide with. The background has to be loaded by now.
+	backgroundAsset *collisionBg = NULL;
+	if (metadata->collisionLayer < 4)
+	{
+		collisionBg = metadata->bgs[metadata->collisionLayer].background;
+		if (!collisionBg || !collisionBg->collision)
+			iprintf("W: bg%d has no collision layer\n", (int) metadata->collisionLayer);
+	}
+	else if (metadata->collisionLayer != ZBE_NO_COLLISION_LAYER)
+		iprintf("W: bad collision layer %d\n", (int) metadata->collisionLayer);
+	tiles = new tileMap(collisionBg, metadata->dimensions.x, metadata->dimensions.y);
 }
 
 // level destructor
 level::~level()
 {
-	for (unsigned int i = 0; i < objects.size(); i++)
-	{
-		delete objects[i];
-	}
-
-	delete colMatrix;
+	delete colEngine;
+	delete staticGeo;
+	delete tiles;
 
 	for (unsigned int i = 0; i < backgrounds.size(); i++)
 	{
@@ -97,10 +214,11 @@ level::~level()
 	}
 
 	// Reset the screenOffset
-	screenOffset.x = 0.0;
-	screenOffset.y = 0.0;
-	levelSize.x = 0.0;
-	levelSize.y = 0.0;
+	screenOffset.x = 0;
+	screenOffset.y = 0;
+	levelSize.x = 0;
+	levelSize.y = 0;
+	zbeLevel = NULL;
 
 	// Clear out the OAM
 	oamClear(oam, 0, 0);
@@ -156,6 +274,8 @@ void level::run()
 			// ansi escape sequence to set print co-ordinates
 			// /x1b[line;columnH
 			iprintf("\x1b[0;24HFPS: %ld\n", (long int) fps);
+			iprintf("\x1b[3;18HPairs: %ld/%ld\n", (long int) numNarrowPairs, (long int) numBroadPairs);
+			iprintf("\x1b[4;18HAsleep: %ld\n", (long int) numAsleep);
 		}
 
 		swiWaitForVBlank();
@@ -172,115 +292,411 @@ void level::update()
 	touchPosition *touch = NULL;
 	touchRead(touch);
 
-	// A vector of object ids that have moved because of their update function
+	// A vector of object ids that have moved on their own
 	vector<int> moved;
 
-	// Iterate through all the objects in the level
+	// Every object starts off in its own island
 	for (unsigned int i = 0; i < objects.size(); i++)
-	{
-		// Run the update function to move the objects. If they return true,
-		// Add to the moved vector
-		if (objects[i]->update(touch))
-			moved.push_back(i);
-	}
+		islandParent[i] = i;
+
+	// Let the objects that have an update function react to things, one type at a time.
+	// Sleeping and static objects don't get updated.
+	heroes.update(touch, bodies);
+	plainObjects.update(touch, bodies);
+
+	// Then move everything at once
+	bodies.integrate(moved);
 
-	// Now that all objects have moved, run collision detection on them.
+	// Turn everything the way it's going and on to the next animation frame. Anything whose hitboxes
+	// changed needs checking like it moved.
+	heroes.animate(bodies, moved);
+	plainObjects.animate(bodies, moved);
+
+	// Now that all objects have moved, keep them in the level and rebin them.
 	for (unsigned int m = 0; m < moved.size(); m++)
 	{
 		// The index of the object that moved
 		unsigned int i = moved[m];
+		objMoved[i] = true;
 
-		// Pull this object out of its old objGroup and reinsert it.
-		if (!objectsGroups[i]->remove(objects[i]))
-			iprintf("W: lvl upd: rm obj fail\n");
-		objectsGroups[i] = colMatrix->addObject(objects[i]);
-
-		/*
-		 *  BEGIN TEMPORARY STUFF
-		 */
-		// iprintf("object[%d] x: %d y: %d\n", i, (int)objects[i]->position.x, (int)objects[i]->position.y);
-		if(objects[i]->position.y + objects[i]->frame->topleft.y + objects[i]->frame->dimensions.y > metadata->dimensions.y)
-		{
-			objects[i]->falling =false;
-			objects[i]->velocity.y = 0.0;
-			objects[i]->position.y = metadata->dimensions.y - objects[i]->frame->topleft.y - objects[i]->frame->dimensions.y - 0.1;
-			objects[i]->moved();
-		}
-		if(objects[i]->position.x + objects[i]->frame->topleft.x + objects[i]->frame->dimensions.x > metadata->dimensions.x)
-		{
-			objects[i]->velocity.x = 0.0;
-			objects[i]->position.x = metadata->dimensions.x - objects[i]->frame->topleft.x - objects[i]->frame->dimensions.x - 0.1;
-			objects[i]->moved();
-		}
-		if(objects[i]->position.y < 0.0)
-		{
-			objects[i]->position.y = 0.1;
-			objects[i]->velocity.y = 0.0;
+		// Keep it out of the level's solid tiles. Let it know it moved if it got pushed or wants to know anyway.
+		if (tiles->collide(objects[i], bodies.start[i]) || (objects[i]->hooks & ZBE_HOOK_MOVED))
 			objects[i]->moved();
-		}
-		if(objects[i]->position.x < 0.0)
-		{
-			objects[i]->position.x = 0.1;
-			objects[i]->velocity.x = 0.0;
-			objects[i]->moved();
-		}
-		/*
-		 *   END TEMPORARY STUFF
-		 */
 
-		// Get the objects that MIGHT be colliding with it
-		vector<object*> candidates = colMatrix->getCollisionCandidates(objects[i]->position);
+		// Objects that can't collide with anything aren't in the broadphase
+		if (objects[i]->collidesWithNothing())
+			continue;
 
-		// Test for collision with them
-		for (unsigned int j = 0; j < candidates.size(); j++)
+		// Fast objects could have gone right through something, check what they passed.
+		// Sensors aren't stopped by anything.
+		if (!objects[i]->isSensor && isFastMover(objects[i], bodies.start[i]))
+			sweepObject(i);
+
+		// Let the broadphase know it moved.
+		colEngine->updateObject(objects[i]);
+	}
+
+	// Everything is done moving on its own, so refresh the boxes of whatever could have moved
+	for (unsigned int i = 0; i < objects.size(); i++)
+		if (bodies.isActive(i))
+			boxes.update(objects[i]);
+
+	// Broadphase: find every pair that might be colliding exactly once, keeping only the
+	// ones where something moved.
+	pairs.clear();
+	numBroadPairs = colEngine->findPairs(objMoved, pairs);
+
+	// Static geometry: only the objects that moved need to look for the static objects they touch
+	for (unsigned int m = 0; m < moved.size(); m++)
+	{
+		if (objects[moved[m]]->collidesWithNothing())
+			continue;
+
+		vector2D<fixed32> topleft, bottomright;
+		getBounds(objects[moved[m]], topleft, bottomright);
+		staticPairCollector collect(objects[moved[m]], pairs);
+		staticGeo->query(topleft, bottomright, collect);
+		numBroadPairs += collect.count;
+	}
+	numNarrowPairs = pairs.size();
+
+	// Narrowphase: test all of the pairs' boxes at once
+	pairIdsA.resize(numNarrowPairs);
+	pairIdsB.resize(numNarrowPairs);
+	pairHits.resize(numNarrowPairs);
+	for (unsigned int p = 0; p < numNarrowPairs; p++)
+	{
+		pairIdsA[p] = pairs[p].a->getObjectId();
+		pairIdsB[p] = pairs[p].b->getObjectId();
+	}
+	if (numNarrowPairs)
+		boxes.overlapBatch(&pairIdsA[0], &pairIdsB[0], numNarrowPairs, &pairHits[0]);
+
+	// Then run collision detection on the ones that are touching. Nothing moves until
+	// the solver has all of the contacts.
+	for (unsigned int p = 0; p < pairs.size(); p++)
+	{
+		if (!pairHits[p])
+			continue;
+
+		object *a = pairs[p].a, *b = pairs[p].b;
+		if (collisionDetect(a, b) && pixelCollisionDetect(a, b))
 		{
-			// Can't collide with itself
-			if (objects[i] != candidates[j])
+			// Sensors only need to know they're overlapping
+			if (a->isSensor || b->isSensor)
 			{
-				// check for collision
-				if (collisionDetect(objects[i], candidates[j]))
-				{
-					// Resolve that collision
-					object *resolvedObj = collisionResolution(objects[i], candidates[j]);
-
-					// Pull it out of the collision matrix and re-insert it
-					int objId = resolvedObj->getObjectId();
-					if (!objectsGroups[objId]->remove(resolvedObj))
-						iprintf("W: lvl upd: rm obj fail\n");
-					objectsGroups[objId] = colMatrix->addObject(objects[objId]);
-				}
+				if (a->isSensor)
+					sensors.addOverlap(a, b);
+				if (b->isSensor)
+					sensors.addOverlap(b, a);
+				continue;
 			}
+
+			// Something touched them, so they have to be awake
+			if (a->asleep)
+				wake(a);
+			if (b->asleep)
+				wake(b);
+
+			// Resolve it with the rest
+			solver.addContact(a, b);
+
+			// They're touching, so they're in the same island. Static objects hold up
+			// everything that rests on them so they aren't part of any island.
+			if (a->isStatic || b->isStatic)
+				continue;
+			int islandA = findIsland(a->getObjectId());
+			int islandB = findIsland(b->getObjectId());
+			if (islandA != islandB)
+				islandParent[islandA] = islandB;
 		}
 	}
 
+	// Resolve all the collisions together and let the broadphase and the boxes know what moved
+	solver.solve(pushed);
+	for (unsigned int m = 0; m < pushed.size(); m++)
+	{
+		colEngine->updateObject(pushed[m]);
+		boxes.update(pushed[m]);
+	}
+
+	// Let the sensors know what's overlapping them
+	sensors.update(objMoved);
+
+	// Everything's done looking at the objects, so make and destroy the ones that were asked for
+	applySpawns();
+
+	// Reset the moved flags for next frame
+	for (unsigned int m = 0; m < moved.size(); m++)
+		objMoved[moved[m]] = false;
+
+	// Put anything that's done moving to sleep
+	sleepObjects();
+
 	// Things should now be where they need to be. Draw them up.
+	// Each type draws the ones that are on screen, giving each a sprite id. We can only show
+	// so many sprites, for now just don't show the overflow.
 	int spriteId = 0;
-	for (unsigned int i = 0; i < objects.size(); i++)
+	heroes.draw(bodies, spriteId, SPRITE_COUNT);
+	plainObjects.draw(bodies, spriteId, SPRITE_COUNT);
+
+	// Clear out the sprite entries that were used last frame but aren't anymore. The rest are already clear.
+	// The objects only wrote what changed in oam's shadow copy, and oamUpdate() copies all of it over in one go.
+	if (spriteId < spritesUsed)
+		oamClear(oam, spriteId, spritesUsed - spriteId);
+	spritesUsed = spriteId;
+
+
+	// Update the backgrounds
+	for (unsigned int i = 0; i < backgrounds.size(); i++)
+	{
+		backgrounds[i]->update();
+	}
+}
+
+// Ask for a new object
+objectHandle level::spawn(uint32 objectAssetId, vector2D<fixed32> position, vector2D<fixed32> gravity)
+{
+	objectAsset *asset = zbeAssets->getObjectAsset(objectAssetId);
+	if (!asset || freeIds.empty())
+		return objectHandle();
+
+	// Give it the next free id now so it has a handle. It's made in applySpawns().
+	int id = freeIds.back();
+	freeIds.pop_back();
+	objectHandle handle(id, generations[id]);
+	pendingSpawns.push_back(spawnRequest(handle, levelObjectAsset(position, gravity, asset)));
+	return handle;
+}
+
+// Ask for a spawned object to be taken out of the level
+bool level::despawn(objectHandle handle)
+{
+	if (handle.id < firstSpawnId || handle.id >= (int) objects.size() || generations[handle.id] != handle.generation)
+		return false;
+
+	// Objects that haven't been made yet just don't get made
+	object *obj = objects[handle.id];
+	if (!obj)
+	{
+		bool pending = false;
+		for (unsigned int i = 0; i < pendingSpawns.size(); i++)
+			if (pendingSpawns[i].handle.id == handle.id)
+				pending = true;
+		if (!pending)
+			return false;
+	}
+	else
+		pendingDespawns.push_back(obj);
+
+	// Either way, the handle's done
+	++generations[handle.id];
+	return true;
+}
+
+// Find a spawned object
+object *level::getObject(objectHandle handle)
+{
+	if (handle.id < firstSpawnId || handle.id >= (int) objects.size() || generations[handle.id] != handle.generation)
+		return NULL;
+	return objects[handle.id];
+}
+
+// Make and destroy the objects spawn() and despawn() were asked for
+void level::applySpawns()
+{
+	// Destroy first. Sensors hearing about it can despawn more, so keep checking the size.
+	for (unsigned int d = 0; d < pendingDespawns.size(); d++)
 	{
-		// Get this object's position on screen
-		gfxAsset *animFrame = objects[i]->frame;
-		vector2D<float> screenPos = vector2D<float>(objects[i]->position.x - screenOffset.x + animFrame->topleft.x, objects[i]->position.y - screenOffset.y + animFrame->topleft.y);
+		object *obj = pendingDespawns[d];
+		int id = obj->getObjectId();
+
+		// Anything asleep on it would be left floating, so wake them up. Its own island goes too.
+		if (obj->asleep)
+			wake(obj);
+		vector2D<fixed32> topleft, bottomright;
+		getBounds(obj, topleft, bottomright);
+		// Things settle a fraction of a pixel apart, so reach a pixel past its box
+		topleft -= vector2D<fixed32>(1, 1);
+		bottomright += vector2D<fixed32>(1, 1);
+		despawnNeighbours.clear();
+		colEngine->findCandidates(topleft, bottomright, despawnNeighbours);
+		for (unsigned int n = 0; n < despawnNeighbours.size(); n++)
+			if (despawnNeighbours[n]->asleep)
+				wake(despawnNeighbours[n]);
+
+		// Get rid of everything that knows about it
+		if (!obj->collidesWithNothing())
+			colEngine->removeObject(obj);
+		sensors.removeObject(obj);
+		solver.removeObject(obj);
+		bodies.setActive(id, false);
+
+		// Then put it and its id back
+		plainObjects.remove(obj);
+		objects[id] = NULL;
+		freeIds.push_back(id);
+	}
+	pendingDespawns.clear();
 
-		// If the object is within the bounds of the screen, give it a sprite Id and tell it to draw.
-		if (screenPos.x >= int(animFrame->dimensions.x) * -1 && screenPos.x <= SCREEN_WIDTH  &&
-			screenPos.y >= int(animFrame->dimensions.y) * -1 && screenPos.y <= SCREEN_HEIGHT)
+	// Then make the new ones, skipping any that were despawned before they got made
+	for (unsigned int p = 0; p < pendingSpawns.size(); p++)
+	{
+		int id = pendingSpawns[p].handle.id;
+		if (generations[id] != pendingSpawns[p].handle.generation)
 		{
-			objects[i]->draw(spriteId);
-			++spriteId;
+			freeIds.push_back(id);
+			continue;
+		}
 
-			// We can only show so many sprites. For now, just don't show the overflow.
-			if(spriteId >= SPRITE_COUNT)
-				break;
+		object *newObj = plainObjects.add(oam, id, &bodies, &pendingSpawns[p].place);
+		if (!newObj)
+		{
+			++generations[id];
+			freeIds.push_back(id);
+			continue;
 		}
+		objects[id] = newObj;
+
+		// It starts out awake, and in the broadphase unless it can't collide with anything
+		bodies.setActive(id, true);
+		bodies.start[id] = newObj->position;
+		boxes.update(newObj);
+		if (!newObj->collidesWithNothing())
+			colEngine->insertObject(newObj);
 	}
+	pendingSpawns.clear();
+}
 
-	// Clear out all the sprite entires that aren't being used anymore
-	oamClear(oam, spriteId, SPRITE_COUNT - spriteId);
+// Stop a fast object at the first thing it hit
+void level::sweepObject(unsigned int i)
+{
+	object *obj = objects[i];
+	vector2D<fixed32> from = bodies.start[i];
+
+	// The box it swept through is its box at the start and end of the move and everything between
+	vector2D<fixed32> topleft, bottomright;
+	getBounds(obj, topleft, bottomright);
+	vector2D<fixed32> moved = obj->position - from;
+	if (moved.x > 0)
+		topleft.x -= moved.x;
+	else
+		bottomright.x -= moved.x;
+	if (moved.y > 0)
+		topleft.y -= moved.y;
+	else
+		bottomright.y -= moved.y;
+
+	sweepCandidates.clear();
+	colEngine->findCandidates(topleft, bottomright, sweepCandidates);
+	sweepCollector collect(sweepCandidates);
+	staticGeo->query(topleft, bottomright, collect);
+
+	// Find the one it hit first
+	object *first = NULL;
+	fixed32 firstToi = 2;
+	bool firstHitX = false;
+	for (unsigned int c = 0; c < sweepCandidates.size(); c++)
+	{
+		object *other = sweepCandidates[c];
+		if (other == obj || !other->frame || other->isSensor || !obj->layersCollide(other))
+			continue;
 
+		fixed32 toi;
+		bool hitX;
+		if (sweptCollisionDetect(obj, from, other, toi, hitX) && toi < firstToi)
+		{
+			first = other;
+			firstToi = toi;
+			firstHitX = hitX;
+		}
+	}
 
-	// Update the backgrounds
-	for (unsigned int i = 0; i < backgrounds.size(); i++)
+	// The regular narrowphase takes it from there
+	if (first)
+		sweptCollisionResolution(obj, from, first, firstToi, firstHitX);
+}
+
+// Wake up an object and its island
+void level::wake(object *obj)
+{
+	// Wake up everything that fell asleep in the same island
+	int island = obj->island;
+	for (int i = sleeperHead[island]; i >= 0; i = sleeperNext[i])
 	{
-		backgrounds[i]->update();
+		object *o = objects[i];
+		o->asleep = false;
+		o->restFrames = 0;
+		bodies.setActive(i, true);
+		bodies.start[i] = o->position;
+		--numAsleep;
+	}
+	sleeperHead[island] = -1;
+}
+
+// Find the root of an object's island
+int level::findIsland(int id)
+{
+	// Find the root
+	int root = id;
+	while (islandParent[root] != root)
+		root = islandParent[root];
+
+	// Point everything on the way straight at it for next time
+	while (islandParent[id] != root)
+	{
+		int next = islandParent[id];
+		islandParent[id] = root;
+		id = next;
+	}
+
+	return root;
+}
+
+// Put islands that have been at rest long enough to sleep
+void level::sleepObjects()
+{
+	// Count up how long everything has been at rest and find the least rested in each island.
+	// Anything that can't sleep keeps its whole island awake.
+	for (unsigned int i = 0; i < objects.size(); i++)
+		islandRest[i] = ZBE_SLEEP_FRAMES;
+	for (unsigned int i = 0; i < objects.size(); i++)
+	{
+		object *o = objects[i];
+		if (!o || o->asleep || o->isStatic)
+			continue;
+
+		vector2D<fixed32> delta = o->position - bodies.start[i];
+		if (o->canSleep() && abs(delta.x).getRaw() <= ZBE_SLEEP_EPSILON && abs(delta.y).getRaw() <= ZBE_SLEEP_EPSILON)
+		{
+			if (o->restFrames < ZBE_SLEEP_FRAMES)
+				++o->restFrames;
+		}
+		else
+			o->restFrames = 0;
+
+		int island = findIsland(i);
+		if (o->restFrames < islandRest[island])
+			islandRest[island] = o->restFrames;
+	}
+
+	// Put the islands that have all been resting long enough to sleep
+	for (unsigned int i = 0; i < objects.size(); i++)
+	{
+		object *o = objects[i];
+		if (!o || o->asleep || o->isStatic)
+			continue;
+
+		int island = findIsland(i);
+		if (islandRest[island] < ZBE_SLEEP_FRAMES)
+			continue;
+
+		o->asleep = true;
+		bodies.setActive(i, false);
+		o->island = island;
+		o->velocity = vector2D<fixed32>(0, 0);
+		sleeperNext[i] = sleeperHead[island];
+		sleeperHead[island] = i;
+		++numAsleep;
 	}
 }
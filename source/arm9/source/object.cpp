@@ -1,18 +1,22 @@
 #include "object.h"
 
 // object constructor
-object::object(OamState *Oam, int id,
+object::object(OamState *Oam, int id, bodyStore *bodies,
 	   frameAsset ***anim,
-	   vector2D<float> pos, vector2D<float> grav, uint8 Weight, bool Hidden,
+	   vector2D<fixed32> pos, vector2D<fixed32> grav, uint8 Weight, bool Hidden,
 	   int MatrixId, int ScaleX, int ScaleY, int Angle,
 	   bool Mosaic)
+: position(bodies->position[id]), velocity(bodies->velocity[id]), acceleration(bodies->acceleration[id]),
+  gravity(bodies->gravity[id]), falling(bodies->falling[id]), frame(bodies->frame[id])
 {
 	// Set all the variables
 	oam = Oam;
 	objectId = id;
 	animations = anim;
 	weight = Weight;
-	frame = anim[0][0]->gfx;
+	animation.setAnimations(anim);
+	animFrame = animation.getFrame();
+	frame = animFrame->gfx;
 
 	matrixId = MatrixId;
 
@@ -20,10 +24,7 @@ object::object(OamState *Oam, int id,
 	format = SpriteColorFormat_16Color;
 	hidden = Hidden;
 
-	if (MatrixId >= 0)
-	{
-		isRotateScale = true;
-	}
+	isRotateScale = MatrixId >= 0;
 	scale.x = ScaleX;
 	scale.y = ScaleY;
 	angle = Angle;
@@ -31,65 +32,85 @@ object::object(OamState *Oam, int id,
 
 	hflip = vflip = false;
 
+	// Not in the OAM yet
+	oamSlot = -1;
+	oamFlipped = false;
+	oamDirty = true;
+
 	position = pos;
 	gravity = grav;
-	printf("obj grav: %f %f\n", gravity.x, gravity.y);
 
-	acceleration.x = acceleration.y = 0.0;
-	velocity.x = velocity.y = 0.0;
+	acceleration.x = acceleration.y = 0;
+	velocity.x = velocity.y = 0;
 
 	// Objects default to being affected by gravity. This is changeable though.
 	falling = true;
 
-	colHeight = scale.y * 0.8f / 2;
-	colWidth  = scale.x * 0.8f / 2;
-}
+	// Plain objects don't have any hooks, the physics are all done by the bodyStore
+	hooks = typeHooks;
 
-// object update function, applies physics to the object
-bool object::update(touchPosition *touch)
-{
-	// Update position
+	// Not in the collisionMatrix yet
+	group = NULL;
+	groupPrev = groupNext = NULL;
 
-	if (falling)
-	{
-		velocity.x += gravity.x;
-		velocity.y += gravity.y;
-	}
+	// Everything starts awake
+	asleep = false;
+	restFrames = 0;
+	island = id;
 
-	velocity.x += acceleration.x;
-	velocity.y += acceleration.y;
+	// The level makes it static or a sensor if it needs to be
+	isStatic = false;
+	isSensor = false;
 
-	position.x += velocity.x;
-	position.y += velocity.y;
-
-	if (velocity.x != 0 || velocity.y != 0)
-		return true;
-	else return false;
+	// On the default layer and colliding with everything until the level says otherwise
+	category = ZBE_CATEGORY_DEFAULT;
+	mask = ZBE_MASK_ALL;
 }
 
 // Draw the object on screen
 void object::draw(int spriteId)
 {
-	// Load up the gfx
-	frame = animations[0][0]->gfx;
-	paletteAsset *pal = animations[0][0]->pal;
+	// Where it goes on the screen
+	int x = (position.x - screenOffset.x).toInt();
+	int y = (position.y - screenOffset.y).toInt();
+	bool flipped = isFlipped();
 
-	uint16 *frameMem = zbeAssets->getGfx(frame);
-	uint8 paletteId = zbeAssets->getPalette(pal);
+	// Same sprite as last frame and nothing changed, it's already right in the OAM.
+	// Changing frames sets oamDirty, see animate().
+	if (spriteId == oamSlot && !oamDirty && x == oamPosition.x && y == oamPosition.y && flipped == oamFlipped)
+		return;
 
-	// Flip horizontally?
-	if (velocity.x < 0)
-		hflip = true;
+	if (spriteId != oamSlot || oamDirty)
+	{
+		// Load up the gfx, only looked up again when the frame changes
+		uint16 *frameMem = animation.getGfx();
+		uint8 paletteId = animation.getPaletteId();
+
+		// Update the whole OAM entry
+		// NOTE: If hidden doesn't work as expected on affine transformed sprites, then there needs to be a check here to see if
+		//       the object is hidden and if so, pass -1 for affineIndex.
+		// void oamSet(OamState *oam, int id, int x, int y, int priority, int palette_id, SpriteSize size, SpriteColorFormat format,
+		//			const void * gfxOffset, int affineIndex, bool sizeDouble, bool hide, bool hflip, bool vflip, bool mosaic);
+		oamSet(oam, spriteId, x, y, priority, paletteId, frame->size, format,
+			   frameMem, matrixId, true, hidden, hflip, vflip, mosaic);
+	}
 	else
-		hflip = false;
-
-	// Update the OAM
-	// NOTE: If hidden doesn't work as expected on affine transformed sprites, then there needs to be a check here to see if
-	//       the object is hidden and if so, pass -1 for affineIndex.
-	// void oamSet(OamState *oam, int id, int x, int y, int priority, int palette_id, SpriteSize size, SpriteColorFormat format,
-	//			const void * gfxOffset, int affineIndex, bool sizeDouble, bool hide, bool hflip, bool vflip, bool mosaic);
-	oamSet(oam, spriteId, int (position.x - screenOffset.x), int (position.y - screenOffset.y), priority, paletteId, frame->size, format,
-		   frameMem, matrixId, true, hidden, hflip, vflip, mosaic);
+	{
+		// It only moved or turned around, so only rewrite those words. y is in attribute 0, x and the
+		// flip bit are in attribute 1.
+		SpriteEntry *entry = &oam->oamMemory[spriteId];
+		if (y != oamPosition.y)
+			entry->attribute[0] = (entry->attribute[0] & ~OBJ_Y(0xFFFF)) | OBJ_Y(y);
+		if (x != oamPosition.x || flipped != oamFlipped)
+			entry->attribute[1] = (entry->attribute[1] & ~(OBJ_X(0xFFFF) | ATTR1_FLIP_X)) | OBJ_X(x) | (flipped ? ATTR1_FLIP_X : 0);
+	}
+
+	// Remember what's in the OAM now
+	oamSlot = spriteId;
+	oamPosition.x = x;
+	oamPosition.y = y;
+	oamFlipped = flipped;
+	oamDirty = false;
 }
 
 // makes this sprite a RotateScale sprite
@@ -103,6 +124,7 @@ void object::makeRotateScale(int MatrixId, int Angle, int ScaleX, int ScaleY)
 
 	// make rotateScale
 	isRotateScale = true;
+	oamDirty = true;
 
 	// do rotation
 	oamRotateScale(oam, matrixId, angle, scale.x, scale.y);
@@ -118,6 +140,7 @@ int object::removeRotateScale()
 	int toReturn = matrixId;
 	matrixId = -1;
 	isRotateScale = false;
+	oamDirty = true;
 
 	// done
 	return toReturn;
@@ -114,75 +114,241 @@ void decapod :: jump(object sprite)
  * Collisions
  */
 
-// Check for a collision
-bool decapod :: collisionDetect(object *object1, object *object2)
+// Utility: a box in world space
+struct worldBox
+{
+	fixed32 left, top, right, bottom;
+};
+
+// Utility: put a box on an object's sprite into world space, mirrored if the sprite is flipped
+static inline void toWorld(object *obj, const vector2D<uint8> &topleft, const vector2D<uint8> &dimensions, worldBox &box)
+{
+	box.left = obj->position.x + obj->boxLeft(topleft.x, dimensions.x);
+	box.top = obj->position.y + topleft.y;
+	box.right = box.left + dimensions.x;
+	box.bottom = box.top + dimensions.y;
+}
+
+// Utility: get the boxes an object collides with, its frame's hitboxes or its gfx's box if there aren't any.
+// Returns how many there are.
+static int getHitboxes(object *obj, worldBox *boxes)
 {
-	// get the demensions of the objects
-	float left1 = object1->position.x + object1->frame->topleft.x;
-	float left2 = object2->position.x + object2->frame->topleft.x;
-	float right1 = left1 + object1->frame->dimensions.x;
-	float right2 = left2 + object2->frame->dimensions.x;
-	float top1 = object1->position.y + object1->frame->topleft.y;
-	float top2 = object2->position.y + object2->frame->topleft.y;
-	float bottom1 = top1 + object1->frame->dimensions.y;
-	float bottom2 = top2 + object2->frame->dimensions.y;
+	frameAsset *anim = obj->animFrame;
+	if (anim && anim->numHitboxes)
+	{
+		for (int i = 0; i < anim->numHitboxes; i++)
+			toWorld(obj, anim->hitboxes[i].topleft, anim->hitboxes[i].dimensions, boxes[i]);
+		return anim->numHitboxes;
+	}
 
+	toWorld(obj, obj->frame->topleft, obj->frame->dimensions, boxes[0]);
+	return 1;
+}
+
+// Utility: whether two boxes are touching
+static inline bool boxesTouch(const worldBox &box1, const worldBox &box2)
+{
 	// if completley outside one another return false
-	if (right1 < left2) return false;
-	if (left1 > right2) return false;
-	if (bottom1 < top2) return false;
-	if (top1 > bottom2) return false;
+	if (box1.right < box2.left) return false;
+	if (box1.left > box2.right) return false;
+	if (box1.bottom < box2.top) return false;
+	if (box1.top > box2.bottom) return false;
 
 	return true;
 }
 
+// Utility: find the first pair of hitboxes two objects are touching with. If there isn't one,
+// box1 and box2 are set to their first hitboxes.
+static bool findTouchingBoxes(object *object1, object *object2, worldBox &box1, worldBox &box2)
+{
+	worldBox boxes1[ZBE_MAX_FRAME_BOXES], boxes2[ZBE_MAX_FRAME_BOXES];
+	int num1 = getHitboxes(object1, boxes1);
+	int num2 = getHitboxes(object2, boxes2);
+
+	for (int i = 0; i < num1; i++)
+	{
+		for (int j = 0; j < num2; j++)
+		{
+			if (boxesTouch(boxes1[i], boxes2[j]))
+			{
+				box1 = boxes1[i];
+				box2 = boxes2[j];
+				return true;
+			}
+		}
+	}
+
+	box1 = boxes1[0];
+	box2 = boxes2[0];
+	return false;
+}
+
+// Check for a collision
+bool decapod :: collisionDetect(object *object1, object *object2)
+{
+	worldBox box1, box2;
+	return findTouchingBoxes(object1, object2, box1, box2);
+}
+
+// Check if one object is hitting another where it can be hurt
+bool decapod::hurtDetect(object *attacker, object *victim)
+{
+	frameAsset *anim = victim->animFrame;
+	if (!anim || !anim->numHurtboxes)
+		return false;
+
+	worldBox hitboxes[ZBE_MAX_FRAME_BOXES];
+	int numHitboxes = getHitboxes(attacker, hitboxes);
+	for (int i = 0; i < anim->numHurtboxes; i++)
+	{
+		worldBox hurtbox;
+		toWorld(victim, anim->hurtboxes[i].topleft, anim->hurtboxes[i].dimensions, hurtbox);
+		for (int j = 0; j < numHitboxes; j++)
+			if (boxesTouch(hitboxes[j], hurtbox))
+				return true;
+	}
+
+	return false;
+}
+
+// Utility: get 32 pixels of a mask row, starting at a pixel that can be off either end of it.
+// Bit i of the result is pixel start + i.
+static inline uint32 maskBits(const uint32 *row, int words, int start)
+{
+	if (start <= -32 || start >= words << 5)
+		return 0;
+	if (start < 0)
+		return row[0] << -start;
+
+	int word = start >> 5, shift = start & 31;
+	uint32 bits = row[word] >> shift;
+	if (shift && word + 1 < words)
+		bits |= row[word + 1] << (32 - shift);
+	return bits;
+}
+
+// Utility: reverse the order of the bits in a word. The ARM9 doesn't have an instruction for it.
+static inline uint32 reverseBits(uint32 bits)
+{
+	bits = ((bits >> 1) & 0x55555555) | ((bits & 0x55555555) << 1);
+	bits = ((bits >> 2) & 0x33333333) | ((bits & 0x33333333) << 2);
+	bits = ((bits >> 4) & 0x0F0F0F0F) | ((bits & 0x0F0F0F0F) << 4);
+	bits = ((bits >> 8) & 0x00FF00FF) | ((bits & 0x00FF00FF) << 8);
+	return (bits >> 16) | (bits << 16);
+}
+
+// Utility: like maskBits but the way the row is drawn. A flipped sprite's row is read backwards,
+// so pixel start + i comes from pixel width - 1 - start - i of the mask.
+static inline uint32 shownBits(const uint32 *row, const gfxAsset *gfx, bool flipped, int start)
+{
+	if (!flipped)
+		return maskBits(row, gfx->maskWords, start);
+	return reverseBits(maskBits(row, gfx->maskWords, gfx->dimensions.x - 32 - start));
+}
+
+// Check for a collision between pixels
+bool decapod::pixelCollisionDetect(object *object1, object *object2)
+{
+	// Hitboxes are already as tight as they need to be
+	if ((object1->animFrame && object1->animFrame->numHitboxes) || (object2->animFrame && object2->animFrame->numHitboxes))
+		return true;
+
+	gfxAsset *frame1 = object1->frame, *frame2 = object2->frame;
+	if (!frame1->mask || !frame2->mask)
+		return true;
+
+	// Where the masks are, in whole pixels. Flipped sprites have their masks mirrored.
+	bool flipped1 = object1->isFlipped(), flipped2 = object2->isFlipped();
+	int left1 = (object1->position.x + object1->boxLeft(frame1->topleft.x, frame1->dimensions.x)).toInt();
+	int top1 = (object1->position.y + frame1->topleft.y).toInt();
+	int left2 = (object2->position.x + object2->boxLeft(frame2->topleft.x, frame2->dimensions.x)).toInt();
+	int top2 = (object2->position.y + frame2->topleft.y).toInt();
+	int width2 = frame2->dimensions.x, height2 = frame2->dimensions.y;
+
+	// Only object 1's pixels that are in or right next to object 2 need checking
+	int minX = left1, maxX = left1 + frame1->dimensions.x;
+	int minY = top1, maxY = top1 + frame1->dimensions.y;
+	if (minX < left2 - 1)
+		minX = left2 - 1;
+	if (maxX > left2 + width2 + 1)
+		maxX = left2 + width2 + 1;
+	if (minY < top2 - 1)
+		minY = top2 - 1;
+	if (maxY > top2 + height2 + 1)
+		maxY = top2 + height2 + 1;
+
+	for (int y = minY; y < maxY; y++)
+	{
+		const uint32 *row1 = frame1->mask + (y - top1) * frame1->maskWords;
+		for (int x = minX; x < maxX; x += 32)
+		{
+			// Object 1's pixels, ignoring any past the edge of object 2
+			uint32 bits1 = shownBits(row1, frame1, flipped1, x - left1);
+			if (maxX - x < 32)
+				bits1 &= (1u << (maxX - x)) - 1;
+			if (!bits1)
+				continue;
+
+			// Object 2's pixels on, above, below and beside those pixels
+			uint32 bits2 = 0;
+			for (int row = y - top2 - 1; row <= y - top2 + 1; row++)
+			{
+				if (row < 0 || row >= height2)
+					continue;
+				const uint32 *row2 = frame2->mask + row * frame2->maskWords;
+				int start = x - left2;
+				bits2 |= shownBits(row2, frame2, flipped2, start - 1) | shownBits(row2, frame2, flipped2, start) | shownBits(row2, frame2, flipped2, start + 1);
+			}
+
+			if (bits1 & bits2)
+				return true;
+		}
+	}
+
+	return false;
+}
+
 
 // Resolve that collision
 object *decapod::collisionResolution(object *object1, object *object2)
 {
-	// Make object 1 the heavy one
-	if (object1->getWeight() < object2->getWeight())
+	// Make object 1 the heavy one. Static objects are heavier than anything.
+	if (object2->isStatic || (!object1->isStatic && object1->getWeight() < object2->getWeight()))
 	{
 		object *t = object1;
 		object1 = object2;
 		object2 = t;
 	}
 
-	// get the demensions of the objects
-	float left1 = object1->position.x + (float)object1->frame->topleft.x;
-	float left2 = object2->position.x + (float)object2->frame->topleft.x;
-	float right1 = left1 + (float)object1->frame->dimensions.x;
-	float right2 = left2 + (float)object2->frame->dimensions.x;
-	float top1 = object1->position.y + (float)object1->frame->topleft.y;
-	float top2 = object2->position.y + (float)object2->frame->topleft.y;
-	float bottom1 = top1 + (float)object1->frame->dimensions.y;
-	float bottom2 = top2 + (float)object2->frame->dimensions.y;
+	// get the hitboxes that are touching
+	worldBox box1, box2;
+	findTouchingBoxes(object1, object2, box1, box2);
 
 	// Figure out the overlap vector
-	float overRight = right1 - left2;
-	float overLeft = left1 - right2;
-	float overBottom = bottom1 - top2;
-	float overTop = top1 - bottom2;
-	vector2D<float> overlap(0.0, 0.0);
+	fixed32 overRight = box1.right - box2.left;
+	fixed32 overLeft = box1.left - box2.right;
+	fixed32 overBottom = box1.bottom - box2.top;
+	fixed32 overTop = box1.top - box2.bottom;
+	vector2D<fixed32> overlap(0, 0);
 
 	// Find x and y
-	if (fabs(overRight) <= fabs(overLeft))
+	if (abs(overRight) <= abs(overLeft))
 		overlap.x = overRight;
 	else
 		overlap.x = overLeft;
-	if (fabs(overBottom) <= fabs(overTop))
+	if (abs(overBottom) <= abs(overTop))
 		overlap.y = overBottom;
 	else
 		overlap.y = overTop;
 
 	// Only move both directions if the overlaps are equal
-	if (fabs(overlap.x) <= fabs(overlap.y))
+	if (abs(overlap.x) <= abs(overlap.y))
 	{
 		// Move only horizontally
 		object2->position.x += overlap.x;
 		object2->velocity.x = 0;
 	}
-	if (fabs(overlap.y) <= fabs(overlap.x))
+	if (abs(overlap.y) <= abs(overlap.x))
 	{
 		// Move on ly vertically
 		object2->position.y += overlap.y;
@@ -194,6 +360,155 @@ object *decapod::collisionResolution(object *object1, object *object2)
 	return object2;
 }
 
+
+// Find the contact between two colliding objects
+void decapod::findContact(object *object1, object *object2, contact &c)
+{
+	c.a = object1;
+	c.b = object2;
+	c.startA = object1->position;
+	c.startB = object2->position;
+	c.impulse = 0;
+
+	// Static objects are heavier than anything
+	if (object1->isStatic || (!object2->isStatic && object1->getWeight() > object2->getWeight()))
+	{
+		c.shareA = 0;
+		c.shareB = 1;
+	}
+	else if (object2->isStatic || object2->getWeight() > object1->getWeight())
+	{
+		c.shareA = 1;
+		c.shareB = 0;
+	}
+	else
+		c.shareA = c.shareB = fixed32(0.5);
+
+	worldBox box1, box2;
+	findTouchingBoxes(object1, object2, box1, box2);
+
+	// How far object 2 would have to go each way to stop overlapping
+	fixed32 overRight = box1.right - box2.left;
+	fixed32 overLeft = box2.right - box1.left;
+	fixed32 overBottom = box1.bottom - box2.top;
+	fixed32 overTop = box2.bottom - box1.top;
+	fixed32 overX = (overRight <= overLeft) ? overRight : overLeft;
+	fixed32 overY = (overBottom <= overTop) ? overBottom : overTop;
+
+	// Push along whichever is less
+	c.xAxis = overX < overY;
+	if (c.xAxis)
+	{
+		c.depth = overX;
+		c.sign = (overRight <= overLeft) ? 1 : -1;
+	}
+	else
+	{
+		c.depth = overY;
+		c.sign = (overBottom <= overTop) ? 1 : -1;
+	}
+}
+
+// Utility: find when, along one axis, a box moving by delta is overlapping another box.
+// Times are fractions of the move. Returns false if they never overlap on this axis.
+static bool sweepAxis(fixed32 min1, fixed32 max1, fixed32 delta, fixed32 min2, fixed32 max2, fixed32 &entry, fixed32 &exit)
+{
+	// Not moving this way: they have to be overlapping the whole time
+	if (delta == 0)
+	{
+		if (max1 <= min2 || min1 >= max2)
+			return false;
+		entry = -1;
+		exit = 2;
+		return true;
+	}
+
+	// Distances to the near and far sides, flipped around so it's always moving forward
+	fixed32 entryDist, exitDist;
+	if (delta > 0)
+	{
+		entryDist = min2 - max1;
+		exitDist = max2 - min1;
+	}
+	else
+	{
+		entryDist = min1 - max2;
+		exitDist = max1 - min2;
+		delta = -delta;
+	}
+
+	// Already past it or not getting to it this frame
+	if (exitDist <= 0 || entryDist >= delta)
+		return false;
+
+	// Only divide when the answer is actually in the move, which keeps it from overflowing
+	entry = (entryDist < 0) ? fixed32(-1) : entryDist / delta;
+	exit = (exitDist >= delta) ? fixed32(2) : exitDist / delta;
+	return true;
+}
+
+// Find when a moving object hit another
+bool decapod::sweptCollisionDetect(object *mover, const vector2D<fixed32> &from, object *other, fixed32 &toi, bool &hitX)
+{
+	// Where the mover's box started and how far it went. Flipped sprites' boxes are mirrored.
+	fixed32 left1 = from.x + mover->boxLeft(mover->frame->topleft.x, mover->frame->dimensions.x);
+	fixed32 top1 = from.y + mover->frame->topleft.y;
+	fixed32 right1 = left1 + mover->frame->dimensions.x;
+	fixed32 bottom1 = top1 + mover->frame->dimensions.y;
+	vector2D<fixed32> delta = mover->position - from;
+
+	fixed32 left2 = other->position.x + other->boxLeft(other->frame->topleft.x, other->frame->dimensions.x);
+	fixed32 top2 = other->position.y + other->frame->topleft.y;
+	fixed32 right2 = left2 + other->frame->dimensions.x;
+	fixed32 bottom2 = top2 + other->frame->dimensions.y;
+
+	// They're touching once they overlap on both axes
+	fixed32 entryX, exitX, entryY, exitY;
+	if (!sweepAxis(left1, right1, delta.x, left2, right2, entryX, exitX))
+		return false;
+	if (!sweepAxis(top1, bottom1, delta.y, top2, bottom2, entryY, exitY))
+		return false;
+
+	fixed32 entry = (entryX > entryY) ? entryX : entryY;
+	fixed32 exit = (exitX < exitY) ? exitX : exitY;
+	if (entry < 0 || entry > exit)
+		return false;
+
+	toi = entry;
+	hitX = entryX > entryY;
+	return true;
+}
+
+// Put a moving object where it hit something
+void decapod::sweptCollisionResolution(object *mover, const vector2D<fixed32> &from, object *other, fixed32 toi, bool hitX)
+{
+	vector2D<fixed32> delta = mover->position - from;
+	mover->position.x = from.x + delta.x * toi;
+	mover->position.y = from.y + delta.y * toi;
+
+	// Line it up exactly with the side it hit, toi is rounded
+	if (hitX)
+	{
+		fixed32 moverLeft = mover->boxLeft(mover->frame->topleft.x, mover->frame->dimensions.x);
+		fixed32 otherLeft = other->position.x + other->boxLeft(other->frame->topleft.x, other->frame->dimensions.x);
+		if (delta.x > 0)
+			mover->position.x = otherLeft - mover->frame->dimensions.x - moverLeft;
+		else
+			mover->position.x = otherLeft + other->frame->dimensions.x - moverLeft;
+		mover->velocity.x = 0;
+	}
+	else
+	{
+		if (delta.y > 0)
+			mover->position.y = other->position.y + other->frame->topleft.y - mover->frame->dimensions.y - mover->frame->topleft.y;
+		else
+			mover->position.y = other->position.y + other->frame->topleft.y + other->frame->dimensions.y - mover->frame->topleft.y;
+		mover->velocity.y = 0;
+	}
+
+	mover->moved();
+}
+
 /*
 bool decapod :: collisionHorrizontalLine(object *obj1, int yval)
 {
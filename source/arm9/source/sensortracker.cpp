@@ -0,0 +1,81 @@
+#include "sensortracker.h"
+#include <algorithm>
+
+// Add an overlap found this frame
+void sensorTracker::addOverlap(object *sensor, object *other)
+{
+	overlap add;
+	add.key = (uint32) sensor->getObjectId() << 16 | (uint32) other->getObjectId();
+	add.sensor = sensor;
+	add.other = other;
+	found.push_back(add);
+}
+
+// Send out this frame's events
+void sensorTracker::update(vector<bool> &objMoved)
+{
+	sort(found.begin(), found.end());
+
+	// Both lists are sorted, so walk them together
+	merged.clear();
+	unsigned int i = 0, j = 0;
+	while (i < overlaps.size() || j < found.size())
+	{
+		// A pair can only be found once a frame, but don't send it twice if it was
+		if (j > 0 && j < found.size() && found[j].key == found[j - 1].key)
+		{
+			j++;
+			continue;
+		}
+
+		if (j == found.size() || (i < overlaps.size() && overlaps[i].key < found[j].key))
+		{
+			// Not found this frame. Still there if neither of them moved.
+			overlap &last = overlaps[i++];
+			if (!moved(objMoved, last.sensor) && !moved(objMoved, last.other))
+			{
+				merged.push_back(last);
+				last.sensor->sensorStay(last.other);
+			}
+			else
+				last.sensor->sensorExit(last.other);
+		}
+		else if (i == overlaps.size() || found[j].key < overlaps[i].key)
+		{
+			// Just started overlapping
+			merged.push_back(found[j]);
+			found[j].sensor->sensorEnter(found[j].other);
+			j++;
+		}
+		else
+		{
+			// Overlapping both frames
+			merged.push_back(found[j]);
+			found[j].sensor->sensorStay(found[j].other);
+			i++;
+			j++;
+		}
+	}
+
+	overlaps.swap(merged);
+	found.clear();
+}
+
+// Forget an object that's going away
+void sensorTracker::removeObject(object *obj)
+{
+	// Keep the rest in order
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < overlaps.size(); i++)
+	{
+		if (overlaps[i].sensor == obj)
+			continue;
+		if (overlaps[i].other == obj)
+		{
+			overlaps[i].sensor->sensorExit(obj);
+			continue;
+		}
+		overlaps[kept++] = overlaps[i];
+	}
+	overlaps.resize(kept);
+}
@@ -0,0 +1,49 @@
+#include "staticgeometry.h"
+
+// Bake the static objects into the grid
+staticGeometry::staticGeometry(const vector<object*> &statics, int levelWidth, int levelHeight)
+{
+	// Always have at least one cell so queries don't have to check
+	cellsWide = (levelWidth + ZBE_STATIC_CELL_SIZE - 1) >> ZBE_STATIC_CELL_SHIFT;
+	cellsHigh = (levelHeight + ZBE_STATIC_CELL_SIZE - 1) >> ZBE_STATIC_CELL_SHIFT;
+	if (cellsWide < 1) cellsWide = 1;
+	if (cellsHigh < 1) cellsHigh = 1;
+	unsigned int numCells = cellsWide * cellsHigh;
+
+	// Get everyone's box
+	if (statics.size() > 0xFFFF)
+		iprintf("W: %d static objs, only using %d\n", (int) statics.size(), 0xFFFF);
+	for (unsigned int i = 0; i < statics.size() && i < 0xFFFF; i++)
+	{
+		staticBox box;
+		box.obj = statics[i];
+		getBounds(box.obj, box.min, box.max);
+		box.cellMin = vector2D<int>(cellX(box.min.x), cellY(box.min.y));
+		boxes.push_back(box);
+	}
+
+	// Count how many boxes are in each cell
+	cellStart.resize(numCells + 1, 0);
+	for (unsigned int b = 0; b < boxes.size(); b++)
+	{
+		int maxX = cellX(boxes[b].max.x), maxY = cellY(boxes[b].max.y);
+		for (int y = boxes[b].cellMin.y; y <= maxY; y++)
+			for (int x = boxes[b].cellMin.x; x <= maxX; x++)
+				++cellStart[y * cellsWide + x + 1];
+	}
+
+	// Turn the counts into where each cell's list starts
+	for (unsigned int c = 1; c <= numCells; c++)
+		cellStart[c] += cellStart[c - 1];
+
+	// Then fill in the lists. fill tracks where the next box goes in each cell.
+	cellBoxes.resize(cellStart[numCells]);
+	vector<unsigned int> fill(cellStart.begin(), cellStart.end() - 1);
+	for (unsigned int b = 0; b < boxes.size(); b++)
+	{
+		int maxX = cellX(boxes[b].max.x), maxY = cellY(boxes[b].max.y);
+		for (int y = boxes[b].cellMin.y; y <= maxY; y++)
+			for (int x = boxes[b].cellMin.x; x <= maxX; x++)
+				cellBoxes[fill[y * cellsWide + x]++] = b;
+	}
+}
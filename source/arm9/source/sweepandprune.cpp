@@ -0,0 +1,93 @@
+#include "sweepandprune.h"
+
+// Add an object to the end of the array
+void sweepAndPrune::insertObject(object *add)
+{
+	sapEntry entry;
+	entry.obj = add;
+	getBounds(add, entry.min, entry.max);
+	entries.push_back(entry);
+}
+
+// Remove an object from the array
+bool sweepAndPrune::removeObject(object *remove)
+{
+	for (vector<sapEntry>::iterator e = entries.begin(); e != entries.end(); ++e)
+	{
+		if (e->obj == remove)
+		{
+			// Erasing keeps the rest in order
+			entries.erase(e);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Find all the overlapping pairs
+unsigned int sweepAndPrune::findPairs(vector<bool> &objMoved, vector<objPair> &pairs)
+{
+	unsigned int numEntries = entries.size();
+
+	// Refresh everyone's bounds and layers
+	for (unsigned int i = 0; i < numEntries; i++)
+	{
+		getBounds(entries[i].obj, entries[i].min, entries[i].max);
+		entries[i].category = entries[i].obj->category;
+		entries[i].mask = entries[i].obj->mask;
+	}
+
+	// Insertion sort by left edge. The array was sorted last frame so this hardly
+	// has to move anything.
+	for (unsigned int i = 1; i < numEntries; i++)
+	{
+		if (!(entries[i].min.x < entries[i - 1].min.x))
+			continue;
+
+		sapEntry move = entries[i];
+		unsigned int j = i;
+		for (; j > 0 && move.min.x < entries[j - 1].min.x; j--)
+			entries[j] = entries[j - 1];
+		entries[j] = move;
+	}
+
+	// Sweep: each box can only overlap the boxes after it that start before it ends
+	movedPairCollector collect(objMoved, pairs);
+	unsigned int numPairs = 0;
+	for (unsigned int i = 0; i < numEntries; i++)
+	{
+		sapEntry &a = entries[i];
+		for (unsigned int j = i + 1; j < numEntries && !(a.max.x < entries[j].min.x); j++)
+		{
+			sapEntry &b = entries[j];
+
+			// Skip pairs whose layers don't collide
+			if (!(a.category & b.mask) || !(b.category & a.mask))
+				continue;
+
+			// Check the other axis
+			if (a.max.y < b.min.y || b.max.y < a.min.y)
+				continue;
+
+			collect(a.obj, b.obj);
+			numPairs++;
+		}
+	}
+
+	return numPairs;
+}
+
+// Find everything in a region
+void sweepAndPrune::findCandidates(vector2D<fixed32> min, vector2D<fixed32> max, vector<object*> &found)
+{
+	for (unsigned int i = 0; i < entries.size(); i++)
+	{
+		vector2D<fixed32> objMin, objMax;
+		getBounds(entries[i].obj, objMin, objMax);
+		if (objMax.x < min.x || max.x < objMin.x || objMax.y < min.y || max.y < objMin.y)
+			continue;
+
+		found.push_back(entries[i].obj);
+	}
+}
@@ -37,8 +37,19 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <algorithm>
 #include "game.h"
 #include "util.h"
+#include "collisionmatrix.h"
+#include "sweepandprune.h"
+#include "aabbtree.h"
+#include "staticgeometry.h"
+#include "tilemap.h"
+#include "aabbstore.h"
+#include "contactsolver.h"
+#include "sensortracker.h"
+#include "bodystore.h"
+#include "objectbucket.h"
 
 /**
  *    GLOBAL VARIABLES
@@ -132,17 +143,17 @@ public:
 		collisionMatrix mat(10, 10, 5);
 
 		iprintf("Making some objects\n");
-		vector2D<float> objPos[5];
-		objPos[0] = vector2D<float>(2.5, 2.5);  //   _________
-		objPos[1] = vector2D<float>(7.5, 2.5);  //  |0&4 |1   |
-		objPos[2] = vector2D<float>(2.5, 7.5);  //  |____|____|
-		objPos[3] = vector2D<float>(7.5, 7.5);  //  |2   |3   |
-		objPos[4] = vector2D<float>(2.5, 2.5);  //  |____|____|
+		vector2D<fixed32> objPos[5];
+		objPos[0] = vector2D<fixed32>(2.5, 2.5);  //   _________
+		objPos[1] = vector2D<fixed32>(7.5, 2.5);  //  |0&4 |1   |
+		objPos[2] = vector2D<fixed32>(2.5, 7.5);  //  |____|____|
+		objPos[3] = vector2D<fixed32>(7.5, 7.5);  //  |2   |3   |
+		objPos[4] = vector2D<fixed32>(2.5, 2.5);  //  |____|____|
 
 		object *objects[5];
 		for (int i = 0; i < 5; i++)
 		{
-			objects[i] = new object(objPos[i]);
+			objects[i] = new object(objPos[i], i);
 			if (!objects[i])
 			{
 				//       --------------------------------
@@ -188,9 +199,9 @@ public:
 
 
 		// See if they're all appropriately sized
-		if (objGroups[0]->objects.size() != 2)
+		if (objGroups[0]->numObjects != 2)
 		{
-			iprintf("objGroup 0 has %d objects\n", objGroups[0]->objects.size());
+			iprintf("objGroup 0 has %d objects\n", objGroups[0]->numObjects);
 			iprintf("should be 2\n");
 			iprintf("Test failed.\n");
 			pauseIfTesting();
@@ -199,9 +210,9 @@ public:
 		// don't do group 0 or group 4
 		for (int i = 1; i < 4; i++)
 		{
-			if (objGroups[i]->objects.size() != 1)
+			if (objGroups[i]->numObjects != 1)
 			{
-				iprintf("objGroup %d has %d objects\n", i, objGroups[i]->objects.size());
+				iprintf("objGroup %d has %d objects\n", i, objGroups[i]->numObjects);
 				iprintf("should be 1\n");
 				iprintf("Test failed.\n");
 				pauseIfTesting();
@@ -232,7 +243,7 @@ public:
 
 
 		iprintf("moving first object\n");
-		objPos[0] = vector2D<float>(7.5, 7.5);
+		objPos[0] = vector2D<fixed32>(7.5, 7.5);
 		objects[0]->position = objPos[0];
 
 		// Remove that object from its old collision matrix and re-insert into the collisionMatrix
@@ -256,9 +267,9 @@ public:
 		}
 
 		// See if they're all appropriately sized
-		if (objGroups[0]->objects.size() != 2)
+		if (objGroups[0]->numObjects != 2)
 		{
-			iprintf("objGroup 0 has %d objects\n", objGroups[0]->objects.size());
+			iprintf("objGroup 0 has %d objects\n", objGroups[0]->numObjects);
 			iprintf("should be 2\n");
 			iprintf("Test failed.\n");
 			pauseIfTesting();
@@ -269,9 +280,9 @@ public:
 			// skip the 3rd group
 			if ( i == 3 ) continue;
 
-			if (objGroups[i]->objects.size() != 1)
+			if (objGroups[i]->numObjects != 1)
 			{
-				iprintf("objGroup %d has %d objects\n", i, objGroups[i]->objects.size());
+				iprintf("objGroup %d has %d objects\n", i, objGroups[i]->numObjects);
 				iprintf("should be 1\n");
 				iprintf("Test failed.\n");
 				pauseIfTesting();
@@ -284,10 +295,10 @@ public:
 		//       --------------------------------
 		iprintf("Test cM::getCollisionCandidates\n");
 		vector<object*> quadCands[4];
-		quadCands[0] = mat.getCollisionCandidates(vector2D<float>(2.5, 2.5));
-		quadCands[1] = mat.getCollisionCandidates(vector2D<float>(7.5, 2.5));
-		quadCands[2] = mat.getCollisionCandidates(vector2D<float>(2.5, 7.5));
-		quadCands[3] = mat.getCollisionCandidates(vector2D<float>(7.5, 7.5));
+		quadCands[0] = mat.getCollisionCandidates(vector2D<fixed32>(2.5, 2.5));
+		quadCands[1] = mat.getCollisionCandidates(vector2D<fixed32>(7.5, 2.5));
+		quadCands[2] = mat.getCollisionCandidates(vector2D<fixed32>(2.5, 7.5));
+		quadCands[3] = mat.getCollisionCandidates(vector2D<fixed32>(7.5, 7.5));
 		for (int i = 0; i < 4; i++)
 		{
 			if (quadCands[i].empty())
@@ -378,6 +389,76 @@ public:
 
 
 
+		iprintf("\n   Testing cM::moveObject()\n\n");
+
+		// Moving within the same block shouldn't change anything
+		objects[0]->position = vector2D<fixed32>(8, 8);
+		if (mat.moveObject(objects[0]) != objGroups[3] || objGroups[3]->numObjects != 2)
+		{
+			iprintf("\nobj0 changed groups moving\n");
+			iprintf("within its block.\n");
+			iprintf("Test failed.\n");
+			pauseIfTesting();
+			return false;
+		}
+
+		// Move it back in with object 4
+		objects[0]->position = vector2D<fixed32>(2.5, 2.5);
+		objGroups[0] = mat.moveObject(objects[0]);
+		if (objGroups[0] != objGroups[4] || objGroups[0]->numObjects != 2 || objGroups[3]->numObjects != 1)
+		{
+			iprintf("\nobj0 not moved back in\n");
+			iprintf("with obj4.\n");
+			iprintf("Test failed.\n");
+			pauseIfTesting();
+			return false;
+		}
+
+		// Make sure removeObject really takes it out
+		if (!mat.removeObject(objects[0]) || objects[0]->group || objGroups[4]->numObjects != 1 || objGroups[4]->first != objects[4])
+		{
+			iprintf("\ncM::removeObject() failed\n");
+			iprintf("Test failed.\n");
+			pauseIfTesting();
+			return false;
+		}
+
+
+		iprintf("\n   Testing objects off the level\n\n");
+
+		// Objects past the left edge still get groups and find each other
+		object outsideA(vector2D<fixed32>(-3, 12), 5), outsideB(vector2D<fixed32>(-6, 12), 6);
+		object *outside[2] = {&outsideA, &outsideB};
+		objGroup *outGroup = mat.addObject(outside[0]);
+		vector<object*> outCands;
+		if (mat.addObject(outside[1]))
+			outCands = mat.getCollisionCandidates(outside[1]->position);
+		if (!outGroup || mat.getObjGroup(outside[0]->position) != outGroup || find(outCands.begin(), outCands.end(), outside[0]) == outCands.end())
+		{
+			iprintf("\nObjects off the level didn't\n");
+			iprintf("find each other.\n");
+			iprintf("Test failed.\n");
+			pauseIfTesting();
+			return false;
+		}
+
+		// Moving way off, then back in, and taking them out leaves nothing behind
+		outside[1]->position = vector2D<fixed32>(1000, -1000);
+		bool movedOff = mat.moveObject(outside[1]) == mat.getObjGroup(outside[1]->position);
+		outside[1]->position = vector2D<fixed32>(7.5, 7.5);
+		bool movedIn = mat.moveObject(outside[1]) == objGroups[3];
+		mat.removeObject(outside[0]);
+		mat.removeObject(outside[1]);
+		if (!movedOff || !movedIn || mat.getObjGroup(vector2D<fixed32>(-3, 12)) || mat.getObjGroup(vector2D<fixed32>(1000, -1000)))
+		{
+			iprintf("\nObjects off the level didn't\n");
+			iprintf("move right.\n");
+			iprintf("Test failed.\n");
+			pauseIfTesting();
+			return false;
+		}
+
+
 		iprintf("\n        Cleaning up\n");
 		for (int i = 0; i < 5; i++)
 			delete objects[i];
@@ -393,6 +474,3340 @@ private:
 
 
 
+/**
+ * aabbTreeTest
+ *
+ * A functional test to test the workings of the aabbTree broadphase and its queries
+ *
+ * @author Joe Balough
+ */
+class aabbTreeTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	aabbTreeTest()
+	{
+		name = "aabbTree Test";
+
+		// Every object in the test is a 16 x 16 box
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Puts a row of objects in a tree then checks region queries, ray casts, moving and removing.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("aabbTree functional Test\n\n");
+
+		iprintf("Making a row of %d objects\n", numObjects);
+		aabbTree tree;
+		object *objects[numObjects];
+		for (int i = 0; i < numObjects; i++)
+		{
+			objects[i] = new object(vector2D<fixed32>(i * 100, 50), i);
+			objects[i]->frame = &box;
+			tree.insertObject(objects[i]);
+		}
+
+		bool success = true;
+		if (tree.getNumNodes() != 2 * numObjects - 1)
+		{
+			iprintf("\nTree has %d nodes\n", tree.getNumNodes());
+			iprintf("should be %d\n", 2 * numObjects - 1);
+			success = false;
+		}
+		if (tree.getHeight() > 2 * 4)
+		{
+			iprintf("\nTree is %d tall\n", tree.getHeight());
+			iprintf("It's not being balanced.\n");
+			success = false;
+		}
+
+		iprintf("testing tree::queryRegion()\n");
+		objectCounter found;
+		tree.queryRegion(vector2D<fixed32>(0, 0), vector2D<fixed32>(150, 100), found);
+		if (found.count != 2)
+		{
+			iprintf("\nRegion found %d objects\n", found.count);
+			iprintf("should be objects 0 and 1\n");
+			success = false;
+		}
+
+		iprintf("testing tree::rayCast()\n");
+		objectCounter hit;
+		tree.rayCast(vector2D<fixed32>(0, 58), vector2D<fixed32>(1000, 58), hit);
+		objectCounter miss;
+		tree.rayCast(vector2D<fixed32>(50, 0), vector2D<fixed32>(50, 40), miss);
+		objectCounter first;
+		first.stopAfter = 1;
+		tree.rayCast(vector2D<fixed32>(0, 58), vector2D<fixed32>(1000, 58), first);
+		if (hit.count != numObjects || miss.count != 0 || first.count != 1)
+		{
+			iprintf("\nRay hit %d, %d, and %d\n", hit.count, miss.count, first.count);
+			iprintf("should be %d, 0, and 1\n", numObjects);
+			success = false;
+		}
+
+		iprintf("testing tree::updateObject()\n");
+		objects[3]->position = vector2D<fixed32>(3000, 3000);
+		tree.updateObject(objects[3]);
+		objectCounter moved;
+		tree.queryRegion(vector2D<fixed32>(2990, 2990), vector2D<fixed32>(3100, 3100), moved);
+		if (moved.count != 1 || moved.last != objects[3])
+		{
+			iprintf("\nMoved object not found\n");
+			success = false;
+		}
+
+		iprintf("testing tree::removeObject()\n");
+		if (!tree.removeObject(objects[3]) || tree.removeObject(objects[3]))
+		{
+			iprintf("\nremoveObject() returned\n");
+			iprintf("the wrong thing.\n");
+			success = false;
+		}
+		objectCounter removed;
+		tree.queryRegion(vector2D<fixed32>(2990, 2990), vector2D<fixed32>(3100, 3100), removed);
+		if (removed.count != 0)
+		{
+			iprintf("\nRemoved object still found\n");
+			success = false;
+		}
+
+		iprintf("\n        Cleaning up\n");
+		for (int i = 0; i < numObjects; i++)
+			delete objects[i];
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Counts the objects a query visits, stopping after stopAfter if it's set
+	struct objectCounter
+	{
+		objectCounter() { count = stopAfter = 0; last = NULL; }
+		inline bool operator()(object *found)
+		{
+			last = found;
+			return ++count != stopAfter;
+		}
+		int count, stopAfter;
+		object *last;
+	};
+
+	// The frame every object uses
+	gfxAsset box;
+
+	// How many objects to put in the tree
+	static const int numObjects = 10;
+};
+
+
+/**
+ * gridQueryTest
+ *
+ * A functional test to test the collisionMatrix's region, ray and nearest object queries
+ *
+ * @author Joe Balough
+ */
+class gridQueryTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	gridQueryTest()
+	{
+		name = "Grid Query Test";
+
+		// The row of objects are 16 x 16 boxes and the big one is 100 x 20
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+		wide.dimensions = vector2D<uint8>(100, 20);
+		wide.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Puts a row of objects and one object bigger than a block in a collisionMatrix
+	 * then checks that the queries find each object once and stop when asked.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Grid Query functional Test\n\n");
+
+		iprintf("Making a row of %d objects\n", numObjects);
+		iprintf("and a big one under it\n");
+		collisionMatrix matrix(512, 512, 32);
+		object *objects[numObjects + 1];
+		for (int i = 0; i < numObjects; i++)
+		{
+			objects[i] = new object(vector2D<fixed32>(i * 40, 50), i);
+			objects[i]->frame = &box;
+			matrix.insertObject(objects[i]);
+		}
+		object *big = objects[numObjects] = new object(vector2D<fixed32>(100, 190), numObjects);
+		big->frame = &wide;
+		matrix.insertObject(big);
+
+		bool success = true;
+
+		iprintf("testing matrix::queryRegion()\n");
+		objectCounter found;
+		matrix.queryRegion(vector2D<fixed32>(0, 0), vector2D<fixed32>(60, 100), found);
+		objectCounter bigFound;
+		matrix.queryRegion(vector2D<fixed32>(0, 150), vector2D<fixed32>(400, 300), bigFound);
+		if (found.count != 2 || bigFound.count != 1 || bigFound.last != big)
+		{
+			iprintf("\nRegions found %d and %d\n", found.count, bigFound.count);
+			iprintf("should be 2 and 1\n");
+			success = false;
+		}
+
+		iprintf("testing matrix::rayCast()\n");
+		objectCounter row;
+		matrix.rayCast(vector2D<fixed32>(0, 58), vector2D<fixed32>(1000, 58), row);
+		objectCounter back;
+		matrix.rayCast(vector2D<fixed32>(1000, 58), vector2D<fixed32>(0, 58), back);
+		objectCounter diagonal;
+		matrix.rayCast(vector2D<fixed32>(0, 0), vector2D<fixed32>(300, 300), diagonal);
+		objectCounter miss;
+		matrix.rayCast(vector2D<fixed32>(20, 0), vector2D<fixed32>(20, 40), miss);
+		objectCounter first;
+		first.stopAfter = 1;
+		matrix.rayCast(vector2D<fixed32>(0, 58), vector2D<fixed32>(1000, 58), first);
+		if (row.count != numObjects || back.count != numObjects || diagonal.count != 2 || miss.count != 0 || first.count != 1)
+		{
+			iprintf("\nRays hit %d, %d, %d,\n", row.count, back.count, diagonal.count);
+			iprintf("%d, and %d\n", miss.count, first.count);
+			iprintf("should be %d, %d, 2, 0, and 1\n", numObjects, numObjects);
+			success = false;
+		}
+		if (first.last != objects[0] || back.last != objects[0])
+		{
+			iprintf("\nRays didn't go in order\n");
+			success = false;
+		}
+
+		iprintf("testing matrix::findNearest()\n");
+		objectSkipper all(NULL);
+		objectSkipper notThree(objects[3]);
+		object *nearest = matrix.findNearest(vector2D<fixed32>(130, 100), 200, all);
+		object *nextNearest = matrix.findNearest(vector2D<fixed32>(130, 100), 200, notThree);
+		object *tooFar = matrix.findNearest(vector2D<fixed32>(130, 100), 20, all);
+		object *nearBig = matrix.findNearest(vector2D<fixed32>(150, 300), 200, all);
+		if (nearest != objects[3] || nextNearest != objects[4] || tooFar != NULL || nearBig != big)
+		{
+			iprintf("\nNearest objects were wrong\n");
+			success = false;
+		}
+
+		iprintf("\n        Cleaning up\n");
+		for (int i = 0; i <= numObjects; i++)
+			delete objects[i];
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Counts the objects a query visits, stopping after stopAfter if it's set
+	struct objectCounter
+	{
+		objectCounter() { count = stopAfter = 0; last = NULL; }
+		inline bool operator()(object *found)
+		{
+			last = found;
+			return ++count != stopAfter;
+		}
+		int count, stopAfter;
+		object *last;
+	};
+
+	// A findNearest filter that takes everything but one object
+	struct objectSkipper
+	{
+		objectSkipper(object *Skip) : skip(Skip) {}
+		inline bool operator()(object *candidate)
+		{
+			return candidate != skip;
+		}
+		object *skip;
+	};
+
+	// The frames the objects use
+	gfxAsset box, wide;
+
+	// How many objects to put in the row
+	static const int numObjects = 10;
+};
+
+
+/**
+ * staticGeometryTest
+ *
+ * A functional test to test baking and querying the staticGeometry
+ *
+ * @author Joe Balough
+ */
+class staticGeometryTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	staticGeometryTest()
+	{
+		name = "staticGeometry Test";
+
+		// A floor as wide as the level and a 16 x 16 block
+		floor.dimensions = vector2D<uint8>(255, 16);
+		floor.topleft = vector2D<uint8>(0, 0);
+		block.dimensions = vector2D<uint8>(16, 16);
+		block.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Bakes a floor and a few blocks then checks that queries find each one once.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("staticGeometry functional Test\n\n");
+
+		iprintf("Baking a floor and %d blocks\n", numBlocks);
+		vector<object*> statics;
+		statics.push_back(new object(vector2D<fixed32>(0, 176), 0));
+		statics[0]->frame = &floor;
+		for (int i = 1; i <= numBlocks; i++)
+		{
+			statics.push_back(new object(vector2D<fixed32>(i * 50, 100), i));
+			statics[i]->frame = &block;
+		}
+		staticGeometry geo(statics, 256, 192);
+
+		bool success = true;
+		if (geo.getNumBoxes() != numBlocks + 1 || geo.getNumEntries() <= geo.getNumBoxes())
+		{
+			iprintf("\nBaked %d boxes, %d entries\n", geo.getNumBoxes(), geo.getNumEntries());
+			iprintf("should be %d boxes and the\n", numBlocks + 1);
+			iprintf("floor in more than one cell\n");
+			success = false;
+		}
+
+		iprintf("testing query() on the floor\n");
+		objectCounter floorHits;
+		geo.query(vector2D<fixed32>(0, 170), vector2D<fixed32>(255, 180), floorHits);
+		if (floorHits.count != 1 || floorHits.last != statics[0])
+		{
+			iprintf("\nFloor found %d times\n", floorHits.count);
+			iprintf("should be once\n");
+			success = false;
+		}
+
+		iprintf("testing query() on blocks\n");
+		objectCounter blockHits;
+		geo.query(vector2D<fixed32>(40, 90), vector2D<fixed32>(110, 110), blockHits);
+		objectCounter miss;
+		geo.query(vector2D<fixed32>(0, 0), vector2D<fixed32>(40, 40), miss);
+		if (blockHits.count != 2 || miss.count != 0)
+		{
+			iprintf("\nQueries found %d and %d\n", blockHits.count, miss.count);
+			iprintf("should be 2 and 0\n");
+			success = false;
+		}
+
+		iprintf("testing query() off the level\n");
+		objectCounter offLevel;
+		geo.query(vector2D<fixed32>(-100, 150), vector2D<fixed32>(1000, 1000), offLevel);
+		objectCounter first;
+		first.stopAfter = 1;
+		geo.query(vector2D<fixed32>(0, 0), vector2D<fixed32>(255, 191), first);
+		if (offLevel.count != 1 || first.count != 1)
+		{
+			iprintf("\nQueries found %d and %d\n", offLevel.count, first.count);
+			iprintf("should be 1 and 1\n");
+			success = false;
+		}
+
+		iprintf("\n        Cleaning up\n");
+		for (unsigned int i = 0; i < statics.size(); i++)
+			delete statics[i];
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Counts the objects a query visits, stopping after stopAfter if it's set
+	struct objectCounter
+	{
+		objectCounter() { count = stopAfter = 0; last = NULL; }
+		inline bool operator()(object *found)
+		{
+			last = found;
+			return ++count != stopAfter;
+		}
+		int count, stopAfter;
+		object *last;
+	};
+
+	// The frames the static objects use
+	gfxAsset floor, block;
+
+	// How many blocks to bake
+	static const int numBlocks = 4;
+};
+
+
+/**
+ * tileMapTest
+ *
+ * A functional test to test colliding objects with a background's collision layer
+ *
+ * @author Joe Balough
+ */
+class tileMapTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	tileMapTest()
+	{
+		name = "tileMap Test";
+
+		// Every object in the test is an 8 x 8 box
+		box.dimensions = vector2D<uint8>(8, 8);
+		box.topleft = vector2D<uint8>(0, 0);
+
+		// Except the flipped one, which is in the left half of a 16 x 16 sprite
+		offCentre.dimensions = vector2D<uint8>(8, 8);
+		offCentre.topleft = vector2D<uint8>(0, 0);
+		offCentre.size = SpriteSize_16x16;
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Makes an 8 x 8 tile collision layer with a solid floor, a solid column, a one-way ledge
+	 * and a slope, then moves an object into each one to make sure it ends up where it should.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("tileMap functional Test\n\n");
+
+		iprintf("Making a 64 x 64 px level\n");
+		backgroundAsset bg;
+		bg.w = bg.h = 8;
+		bg.colLength = 8 * 8;
+		bg.collision = new uint8[bg.colLength];
+		for (int i = 0; i < 8 * 8; i++)
+			bg.collision[i] = ZBE_TILE_EMPTY;
+		for (int x = 0; x < 8; x++)
+			bg.collision[7 * 8 + x] = ZBE_TILE_SOLID;
+		bg.collision[4 * 8 + 0] = bg.collision[4 * 8 + 1] = ZBE_TILE_ONEWAY;
+		bg.collision[6 * 8 + 5] = ZBE_TILE_SLOPE_UP;
+		bg.collision[1 * 8 + 2] = bg.collision[2 * 8 + 2] = ZBE_TILE_SOLID;
+		tileMap tiles(&bg, 64, 64);
+
+		bool success = true;
+		if (tiles.getTile(0, 7) != ZBE_TILE_SOLID || tiles.getTile(3, 3) != ZBE_TILE_EMPTY || tiles.getTile(-1, 0) != ZBE_TILE_SOLID || tiles.getTile(0, 8) != ZBE_TILE_SOLID)
+		{
+			iprintf("\ngetTile() returned\n");
+			iprintf("the wrong thing.\n");
+			success = false;
+		}
+
+		iprintf("testing a solid floor\n");
+		success &= move(tiles, vector2D<fixed32>(24, 46), vector2D<fixed32>(24, 50), vector2D<fixed32>(24, 48), true);
+
+		iprintf("testing one-way from above\n");
+		success &= move(tiles, vector2D<fixed32>(0, 22), vector2D<fixed32>(0, 26), vector2D<fixed32>(0, 24), true);
+
+		iprintf("testing one-way from below\n");
+		success &= move(tiles, vector2D<fixed32>(0, 40), vector2D<fixed32>(0, 36), vector2D<fixed32>(0, 36), false);
+
+		iprintf("testing a slope\n");
+		success &= move(tiles, vector2D<fixed32>(40, 40), vector2D<fixed32>(40, 47), vector2D<fixed32>(40, 44), true);
+
+		iprintf("testing the edge of the level\n");
+		success &= move(tiles, vector2D<fixed32>(52, 0), vector2D<fixed32>(60, 0), vector2D<fixed32>(56, 0), true);
+
+		iprintf("testing a fast fall\n");
+		success &= move(tiles, vector2D<fixed32>(24, 0), vector2D<fixed32>(24, 60), vector2D<fixed32>(24, 48), true);
+
+		iprintf("testing a fast fall on one-way\n");
+		success &= move(tiles, vector2D<fixed32>(0, 8), vector2D<fixed32>(0, 40), vector2D<fixed32>(0, 24), true);
+
+		iprintf("testing a flipped sprite\n");
+		success &= move(tiles, vector2D<fixed32>(20, 12), vector2D<fixed32>(8, 12), vector2D<fixed32>(16, 12), true, true);
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Moves an object from one place to another and checks where collide() puts it. A flipped
+	// object uses the off-centre frame facing left, so its box is in the right half of its sprite.
+	bool move(tileMap &tiles, vector2D<fixed32> from, vector2D<fixed32> to, vector2D<fixed32> expected, bool expectPushed, bool flipped = false)
+	{
+		object obj(to);
+		obj.frame = &box;
+		if (flipped)
+		{
+			obj.frame = &offCentre;
+			obj.velocity = to - from;
+			obj.animate();
+		}
+		bool pushed = tiles.collide(&obj, from);
+		if (pushed != expectPushed || obj.position.x != expected.x || obj.position.y != expected.y)
+		{
+			iprintf("\nEnded at (%d, %d) %s\n", obj.position.x.toInt(), obj.position.y.toInt(), pushed ? "pushed" : "not pushed");
+			iprintf("should be (%d, %d) %s\n", expected.x.toInt(), expected.y.toInt(), expectPushed ? "pushed" : "not pushed");
+			return false;
+		}
+		return true;
+	}
+
+	// The frames the objects use
+	gfxAsset box, offCentre;
+};
+
+
+/**
+ * sweptCollisionTest
+ *
+ * A functional test to make sure fast objects can't go through thin objects
+ *
+ * @author Joe Balough
+ */
+class sweptCollisionTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	sweptCollisionTest()
+	{
+		name = "Swept Collision Test";
+
+		box.dimensions = vector2D<uint8>(8, 8);
+		box.topleft = vector2D<uint8>(0, 0);
+		platform.dimensions = vector2D<uint8>(32, 2);
+		platform.topleft = vector2D<uint8>(0, 0);
+
+		// The same box in the left half of a 16 x 16 sprite
+		offCentre.dimensions = vector2D<uint8>(8, 8);
+		offCentre.topleft = vector2D<uint8>(0, 0);
+		offCentre.size = SpriteSize_16x16;
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Moves an 8 x 8 box past a 32 x 2 platform in one step a few different ways and
+	 * checks whether the swept test says it hit and where it stops it.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Swept Collision functional Test\n\n");
+
+		iprintf("Platform at (0, 40)\n");
+		object plat(vector2D<fixed32>(0, 40));
+		plat.frame = &platform;
+
+		bool success = true;
+		iprintf("testing falling through it\n");
+		success &= move(plat, vector2D<fixed32>(8, 0), vector2D<fixed32>(8, 80), true, vector2D<fixed32>(8, 32));
+
+		iprintf("testing hitting its side\n");
+		success &= move(plat, vector2D<fixed32>(-40, 36), vector2D<fixed32>(60, 36), true, vector2D<fixed32>(-8, 36));
+
+		iprintf("testing jumping up through it\n");
+		success &= move(plat, vector2D<fixed32>(16, 80), vector2D<fixed32>(16, 0), true, vector2D<fixed32>(16, 42));
+
+		iprintf("testing missing it\n");
+		success &= move(plat, vector2D<fixed32>(40, 0), vector2D<fixed32>(40, 80), false, vector2D<fixed32>(40, 80));
+
+		iprintf("testing stopping short of it\n");
+		success &= move(plat, vector2D<fixed32>(8, 0), vector2D<fixed32>(8, 20), false, vector2D<fixed32>(8, 20));
+
+		iprintf("testing starting inside it\n");
+		success &= move(plat, vector2D<fixed32>(8, 36), vector2D<fixed32>(8, 80), false, vector2D<fixed32>(8, 80));
+
+		iprintf("testing a flipped box\n");
+		success &= move(plat, vector2D<fixed32>(60, 36), vector2D<fixed32>(-60, 36), true, vector2D<fixed32>(24, 36), true);
+		success &= move(plat, vector2D<fixed32>(28, 0), vector2D<fixed32>(27, 80), false, vector2D<fixed32>(27, 80), true);
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Moves the box from one place to another and checks what the swept test does with it. A
+	// flipped box is the off-centre one moving left, so it's in the right half of its sprite.
+	bool move(object &plat, vector2D<fixed32> from, vector2D<fixed32> to, bool expectHit, vector2D<fixed32> expected, bool flipped = false)
+	{
+		object obj(to);
+		obj.frame = flipped ? &offCentre : &box;
+		obj.velocity = to - from;
+		obj.animate();
+
+		fixed32 toi;
+		bool hitX;
+		bool hit = sweptCollisionDetect(&obj, from, &plat, toi, hitX);
+		if (hit)
+			sweptCollisionResolution(&obj, from, &plat, toi, hitX);
+
+		if (hit != expectHit || obj.position.x != expected.x || obj.position.y != expected.y)
+		{
+			iprintf("\nEnded at (%d, %d) %s\n", obj.position.x.toInt(), obj.position.y.toInt(), hit ? "hit" : "no hit");
+			iprintf("should be (%d, %d) %s\n", expected.x.toInt(), expected.y.toInt(), expectHit ? "hit" : "no hit");
+			return false;
+		}
+		return true;
+	}
+
+	// The frames the box and platform use
+	gfxAsset box, platform, offCentre;
+};
+
+
+/**
+ * pixelCollisionTest
+ *
+ * A functional test to make sure collision masks are compared correctly
+ *
+ * @author Joe Balough
+ */
+class pixelCollisionTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; sets the test name and makes the masks
+	 * @author Joe Balough
+	 */
+	pixelCollisionTest()
+	{
+		name = "Pixel Collision Test";
+
+		// An 8 x 8 triangle filling in the top-left corner
+		makeMask(triangle, 8, 8);
+		for (int y = 0; y < 8; y++)
+			triangle.mask[y] = (1u << (8 - y)) - 1;
+
+		// A solid 8 x 8 block
+		makeMask(block, 8, 8);
+		for (int y = 0; y < 8; y++)
+			block.mask[y] = 0xFF;
+
+		// A 40 x 1 line with only pixel 33 set, so it needs two words
+		makeMask(dot, 40, 1);
+		dot.mask[0] = 0;
+		dot.mask[1] = 1u << 1;
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Puts pairs of objects with different masks near each other and makes sure
+	 * pixelCollisionDetect only says they're colliding when their pixels touch.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Pixel Collision functional Test\n\n");
+
+		bool success = true;
+		iprintf("testing triangle corners\n");
+		success &= check(triangle, vector2D<fixed32>(0, 0), triangle, vector2D<fixed32>(6, 6), false);
+
+		iprintf("testing overlapping triangles\n");
+		success &= check(triangle, vector2D<fixed32>(0, 0), triangle, vector2D<fixed32>(3, 3), true);
+
+		iprintf("testing blocks side by side\n");
+		success &= check(block, vector2D<fixed32>(0, 0), block, vector2D<fixed32>(8, 0), true);
+
+		iprintf("testing a block on a triangle\n");
+		success &= check(triangle, vector2D<fixed32>(0, 0), block, vector2D<fixed32>(5, 5), false);
+		success &= check(triangle, vector2D<fixed32>(0, 0), block, vector2D<fixed32>(4, 4), true);
+		success &= check(block, vector2D<fixed32>(5, 5), triangle, vector2D<fixed32>(0, 0), false);
+
+		iprintf("testing the second word\n");
+		success &= check(dot, vector2D<fixed32>(0, 0), block, vector2D<fixed32>(35, -4), false);
+		success &= check(dot, vector2D<fixed32>(0, 0), block, vector2D<fixed32>(34, -4), true);
+		success &= check(block, vector2D<fixed32>(34, -4), dot, vector2D<fixed32>(0, 0), true);
+
+		iprintf("testing no mask\n");
+		success &= check(noMask, vector2D<fixed32>(0, 0), triangle, vector2D<fixed32>(6, 6), true);
+
+		iprintf("testing a flipped triangle\n");
+		success &= check(triangle, vector2D<fixed32>(0, 0), block, vector2D<fixed32>(8, 4), false);
+		success &= check(triangle, vector2D<fixed32>(0, 0), block, vector2D<fixed32>(8, 4), true, true);
+		success &= check(block, vector2D<fixed32>(8, 4), triangle, vector2D<fixed32>(0, 0), true, false, true);
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Sets up a frame with an empty mask
+	void makeMask(gfxAsset &frame, int w, int h)
+	{
+		frame.dimensions = vector2D<uint8>(w, h);
+		frame.topleft = vector2D<uint8>(0, 0);
+		frame.maskWords = (w + 31) >> 5;
+		frame.mask = new uint32[h * frame.maskWords];
+	}
+
+	// Checks whether two objects' pixels are touching. Objects moving left are drawn flipped.
+	bool check(gfxAsset &frame1, vector2D<fixed32> pos1, gfxAsset &frame2, vector2D<fixed32> pos2, bool expected, bool flip1 = false, bool flip2 = false)
+	{
+		object obj1(pos1, 0), obj2(pos2, 1);
+		obj1.frame = &frame1;
+		obj2.frame = &frame2;
+		obj1.velocity.x = flip1 ? -1 : 0;
+		obj2.velocity.x = flip2 ? -1 : 0;
+		obj1.animate();
+		obj2.animate();
+		if (pixelCollisionDetect(&obj1, &obj2) != expected)
+		{
+			iprintf("\nShould%s be colliding\n", expected ? "" : " not");
+			return false;
+		}
+		return true;
+	}
+
+	// The frames the objects use. noMask is just a box.
+	gfxAsset triangle, block, dot, noMask;
+};
+
+
+/**
+ * hitboxTest
+ *
+ * A functional test to make sure animation frame hitboxes and hurtboxes are used
+ *
+ * @author Joe Balough
+ */
+class hitboxTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; sets the test name and makes the frames
+	 * @author Joe Balough
+	 */
+	hitboxTest()
+	{
+		name = "Hitbox Test";
+
+		// Both frames are on a 32 x 32 gfx
+		sprite.dimensions = vector2D<uint8>(32, 32);
+		sprite.topleft = vector2D<uint8>(0, 0);
+		sprite.size = SpriteSize_32x32;
+		boxed.gfx = plain.gfx = &sprite;
+
+		// The boxed frame has an 8 x 8 hitbox in the middle and three hurtboxes: its head, its feet
+		// and its tail, which sticks out of its left side
+		boxed.numHitboxes = 1;
+		boxed.hitboxes = new frameBox[1];
+		setBox(boxed.hitboxes[0], 12, 12, 8, 8);
+		boxed.numHurtboxes = 3;
+		boxed.hurtboxes = new frameBox[3];
+		setBox(boxed.hurtboxes[0], 12, 0, 8, 4);
+		setBox(boxed.hurtboxes[1], 12, 28, 8, 4);
+		setBox(boxed.hurtboxes[2], 0, 12, 4, 4);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Puts a plain object and one with hitboxes near each other and checks what
+	 * collisionDetect, collisionResolution and hurtDetect make of them.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Hitbox functional Test\n\n");
+
+		object wall(vector2D<fixed32>(0, 0), 0), obj(vector2D<fixed32>(0, 0), 1);
+		wall.frame = &sprite;
+		wall.animFrame = &plain;
+		wall.isStatic = true;
+		obj.frame = &sprite;
+		obj.animFrame = &boxed;
+
+		bool success = true;
+		iprintf("testing sprites overlapping\n");
+		obj.position = vector2D<fixed32>(21, 0);
+		if (collisionDetect(&wall, &obj))
+		{
+			iprintf("\nShouldn't be colliding\n");
+			success = false;
+		}
+
+		iprintf("testing hitbox overlapping\n");
+		obj.position = vector2D<fixed32>(14, 0);
+		if (!collisionDetect(&wall, &obj))
+		{
+			iprintf("\nShould be colliding\n");
+			success = false;
+		}
+
+		iprintf("testing resolution\n");
+		obj.velocity = vector2D<fixed32>(-1, 0);
+		collisionResolution(&wall, &obj);
+		if (obj.position.x != 20 || obj.position.y != 0 || obj.velocity.x != 0)
+		{
+			iprintf("\nPushed to (%d, %d)\n", obj.position.x.toInt(), obj.position.y.toInt());
+			iprintf("should be (20, 0)\n");
+			success = false;
+		}
+
+		iprintf("testing hurtboxes\n");
+		obj.position = vector2D<fixed32>(0, 30);
+		if (!hurtDetect(&wall, &obj) || hurtDetect(&obj, &wall))
+		{
+			iprintf("\nHead hurtbox wrong\n");
+			success = false;
+		}
+		obj.position = vector2D<fixed32>(0, 14);
+		if (!hurtDetect(&wall, &obj))
+		{
+			iprintf("\nHead hurtbox missed\n");
+			success = false;
+		}
+		obj.position = vector2D<fixed32>(0, 33);
+		if (hurtDetect(&wall, &obj))
+		{
+			iprintf("\nShouldn't be hurt\n");
+			success = false;
+		}
+
+		iprintf("testing flipped hurtboxes\n");
+		obj.position = vector2D<fixed32>(-31, 0);
+		obj.velocity = vector2D<fixed32>(0, 0);
+		obj.animate();
+		if (hurtDetect(&wall, &obj))
+		{
+			iprintf("\nTail should be facing left\n");
+			success = false;
+		}
+		obj.velocity = vector2D<fixed32>(-1, 0);
+		obj.animate();
+		if (!hurtDetect(&wall, &obj))
+		{
+			iprintf("\nTail should be facing right\n");
+			success = false;
+		}
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Sets a box
+	void setBox(frameBox &box, int x, int y, int w, int h)
+	{
+		box.topleft = vector2D<uint8>(x, y);
+		box.dimensions = vector2D<uint8>(w, h);
+	}
+
+	// The gfx both frames use
+	gfxAsset sprite;
+
+	// A frame with hitboxes and hurtboxes and one without
+	frameAsset boxed, plain;
+};
+
+
+/**
+ * gridSizingTest
+ *
+ * A functional test to make sure the collisionMatrix picks a good block size and finds
+ * objects that are too big for a block exactly once
+ *
+ * @author Joe Balough
+ */
+class gridSizingTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; sets the test name and makes the frames
+	 * @author Joe Balough
+	 */
+	gridSizingTest()
+	{
+		name = "Grid Sizing Test";
+
+		// A platform much wider than a block and a box that fits in one
+		platform.dimensions = vector2D<uint8>(100, 20);
+		platform.topleft = vector2D<uint8>(0, 0);
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Checks chooseBlockSize on a few sets of objects, then puts a platform that
+	 * spans four blocks in a grid with some boxes and checks that every query and
+	 * pair involving it comes up once.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Grid Sizing functional Test\n\n");
+		bool success = true;
+
+		iprintf("testing chooseBlockSize()\n");
+		vector<int> smallish(9, 16), same(10, 32), odd(1, 40), huge(1, 1000), none;
+		smallish.push_back(200);
+		int sizes[5] = {collisionMatrix::chooseBlockSize(smallish), collisionMatrix::chooseBlockSize(same),
+		                collisionMatrix::chooseBlockSize(odd), collisionMatrix::chooseBlockSize(huge),
+		                collisionMatrix::chooseBlockSize(none)};
+		int expected[5] = {16, 32, 64, ZBE_GRID_MAX_BLOCK, ZBE_GRID_DEFAULT_BLOCK};
+		for (int i = 0; i < 5; i++)
+		{
+			if (sizes[i] != expected[i])
+			{
+				iprintf("\nSet %d got %d, should be %d\n", i, sizes[i], expected[i]);
+				success = false;
+			}
+		}
+
+		iprintf("Making 256 x 256 px @ 32px\n");
+		collisionMatrix mat(256, 256, 32);
+
+		// The platform spans blocks (0, 0) to (3, 0). The first three boxes touch it
+		// from blocks on and around it, the last is nowhere near.
+		object plat(vector2D<fixed32>(10, 10), 0);
+		plat.frame = &platform;
+		object box1(vector2D<fixed32>(90, 20), 1), box2(vector2D<fixed32>(40, 0), 2),
+		       box3(vector2D<fixed32>(100, 25), 3), box4(vector2D<fixed32>(200, 200), 4);
+		object *boxes[numBoxes] = {&box1, &box2, &box3, &box4};
+		mat.addObject(&plat);
+		for (int i = 0; i < numBoxes; i++)
+		{
+			boxes[i]->frame = &box;
+			mat.addObject(boxes[i]);
+		}
+
+		iprintf("testing forEachPair()\n");
+		if (!checkPairs(mat, &plat, 1, 1, 1, 0))
+			success = false;
+
+		iprintf("testing findCandidates()\n");
+		vector<object*> found;
+		mat.findCandidates(vector2D<fixed32>(0, 0), vector2D<fixed32>(255, 40), found);
+		if (count(found.begin(), found.end(), &plat) != 1 || found.size() != 4)
+		{
+			iprintf("\nFound %d objects, should be 4\n", (int) found.size());
+			success = false;
+		}
+
+		iprintf("testing forEachCandidate()\n");
+		candidateCounter near;
+		mat.forEachCandidate(vector2D<fixed32>(70, 10), near);
+		if (near.count[0] != 1)
+		{
+			iprintf("\nPlatform visited %d times\n", near.count[0]);
+			iprintf("should be once\n");
+			success = false;
+		}
+
+		iprintf("testing moveObject()\n");
+		plat.position = vector2D<fixed32>(150, 190);
+		objGroup *group = mat.moveObject(&plat);
+		if (group != mat.getObjGroup(plat.position) || !checkPairs(mat, &plat, 0, 0, 0, 1))
+		{
+			iprintf("\nPlatform not moved right\n");
+			success = false;
+		}
+
+		iprintf("testing shrinking\n");
+		plat.frame = &box;
+		plat.position = vector2D<fixed32>(96, 0);
+		group = mat.moveObject(&plat);
+		if (group != mat.getObjGroup(plat.position) || !checkPairs(mat, &plat, 1, 0, 1, 0))
+		{
+			iprintf("\nPlatform not shrunk right\n");
+			success = false;
+		}
+
+		iprintf("testing removeObject()\n");
+		plat.frame = &platform;
+		mat.moveObject(&plat);
+		bool removed = mat.removeObject(&plat), again = mat.removeObject(&plat);
+		if (!removed || again || !checkPairs(mat, &plat, 0, 0, 0, 0))
+		{
+			iprintf("\nPlatform not removed right\n");
+			success = false;
+		}
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// How many boxes to put in the grid
+	static const int numBoxes = 4;
+
+	// Counts how many times each object is paired with one of interest
+	struct pairCounter
+	{
+		pairCounter(object *Watch) : watch(Watch) { for (int i = 0; i <= numBoxes; i++) count[i] = 0; }
+		inline void operator()(object *a, object *b)
+		{
+			if (a == watch)
+				count[b->getObjectId()]++;
+			else if (b == watch)
+				count[a->getObjectId()]++;
+		}
+		object *watch;
+		int count[numBoxes + 1];
+	};
+
+	// Counts how many times each object is visited
+	struct candidateCounter
+	{
+		candidateCounter() { for (int i = 0; i <= numBoxes; i++) count[i] = 0; }
+		inline void operator()(object *found)
+		{
+			count[found->getObjectId()]++;
+		}
+		int count[numBoxes + 1];
+	};
+
+	// Checks how many times each box is paired with obj
+	bool checkPairs(collisionMatrix &mat, object *obj, int box1, int box2, int box3, int box4)
+	{
+		pairCounter pairs(obj);
+		mat.forEachPair(pairs);
+		int expected[numBoxes] = {box1, box2, box3, box4};
+		bool success = true;
+		for (int i = 0; i < numBoxes; i++)
+		{
+			if (pairs.count[i + 1] != expected[i])
+			{
+				iprintf("\nBox %d paired %d times\n", i + 1, pairs.count[i + 1]);
+				iprintf("should be %d\n", expected[i]);
+				success = false;
+			}
+		}
+		return success;
+	}
+
+	// The frames the objects use
+	gfxAsset platform, box;
+};
+
+
+/**
+ * collisionLayerTest
+ *
+ * A functional test to make sure every broadphase engine and the static geometry
+ * leave out pairs whose collision layers don't collide
+ *
+ * @author Joe Balough
+ */
+class collisionLayerTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; sets the test name and makes the frame
+	 * @author Joe Balough
+	 */
+	collisionLayerTest()
+	{
+		name = "Collision Layer Test";
+
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Piles a hero, two pickups that only collide with heroes and a decoration on the
+	 * same spot in each broadphase engine and checks that only the hero and pickup
+	 * pairs come out. Then checks the same for a pickup against a static wall.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Collision Layer functional Test\n\n");
+		bool success = true;
+
+		// Everything is on top of everything else
+		object player(vector2D<fixed32>(100, 100), 0), pickupA(vector2D<fixed32>(104, 100), 1),
+		       pickupB(vector2D<fixed32>(100, 104), 2), decoration(vector2D<fixed32>(104, 104), 3);
+		object *objs[numObjs] = {&player, &pickupA, &pickupB, &decoration};
+		for (int i = 0; i < numObjs; i++)
+			objs[i]->frame = &box;
+		// Pickups are on layer 1 and only collide with heroes on layer 0
+		objs[1]->category = objs[2]->category = 1 << 1;
+		objs[1]->mask = objs[2]->mask = 1 << 0;
+		// The decoration doesn't collide with anything
+		objs[3]->mask = 0;
+
+		iprintf("testing layersCollide()\n");
+		if (!objs[0]->layersCollide(objs[1]) || !objs[1]->layersCollide(objs[0]) ||
+		    objs[1]->layersCollide(objs[2]) || objs[0]->layersCollide(objs[3]) ||
+		    objs[0]->collidesWithNothing() || !objs[3]->collidesWithNothing())
+		{
+			iprintf("\nWrong layer results\n");
+			success = false;
+		}
+
+		const char *names[3] = {"grid", "sap", "tree"};
+		int types[3] = {ZBE_BROADPHASE_GRID, ZBE_BROADPHASE_SAP, ZBE_BROADPHASE_TREE};
+		for (int t = 0; t < 3; t++)
+		{
+			iprintf("testing %s findPairs()\n", names[t]);
+			broadphase *engine = newBroadphase(types[t], 256, 256);
+			for (int i = 0; i < numObjs; i++)
+				engine->insertObject(objs[i]);
+
+			vector<bool> objMoved(numObjs, true);
+			vector<objPair> pairs;
+			engine->findPairs(objMoved, pairs);
+			delete engine;
+
+			// Only the hero and each pickup
+			bool found[numObjs] = {false, false, false, false};
+			bool wrong = pairs.size() != 2;
+			for (unsigned int p = 0; p < pairs.size(); p++)
+			{
+				object *other = (pairs[p].a == objs[0]) ? pairs[p].b : pairs[p].a;
+				if ((pairs[p].a != objs[0] && pairs[p].b != objs[0]) || other == objs[3])
+					wrong = true;
+				found[other->getObjectId()] = true;
+			}
+			if (wrong || !found[1] || !found[2])
+			{
+				iprintf("\n%s found %d pairs\n", names[t], (int) pairs.size());
+				iprintf("should be hero + pickups\n");
+				success = false;
+			}
+		}
+
+		iprintf("testing static pairs\n");
+		object wall(vector2D<fixed32>(96, 96), numObjs);
+		wall.frame = &box;
+		wall.isStatic = true;
+		wall.category = 1 << 2;
+		vector<object*> statics(1, &wall);
+		staticGeometry geo(statics, 256, 256);
+		vector<objPair> pairs;
+		staticPairCollector heroCollect(objs[0], pairs), pickupCollect(objs[1], pairs);
+		geo.query(vector2D<fixed32>(100, 100), vector2D<fixed32>(116, 116), heroCollect);
+		geo.query(vector2D<fixed32>(104, 100), vector2D<fixed32>(120, 116), pickupCollect);
+		if (pairs.size() != 1 || pairs[0].a != objs[0] || pickupCollect.count != 1)
+		{
+			iprintf("\nFound %d static pairs\n", (int) pairs.size());
+			iprintf("should be just the hero\n");
+			success = false;
+		}
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// How many objects to pile up
+	static const int numObjs = 4;
+
+	// The frame every object uses
+	gfxAsset box;
+};
+
+
+/**
+ * stackingTest
+ *
+ * A functional test to make sure the contactSolver settles a stack of boxes on a floor
+ *
+ * @author Joe Balough
+ */
+class stackingTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; sets the test name and makes the frames
+	 * @author Joe Balough
+	 */
+	stackingTest()
+	{
+		name = "Stacking Test";
+
+		floorGfx.dimensions = vector2D<uint8>(200, 16);
+		floorGfx.topleft = vector2D<uint8>(0, 0);
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Drops a column of boxes, each a pixel to the right of the one below it, onto a
+	 * static floor and runs them and the solver for a few seconds. Every box should end
+	 * up resting exactly on the one below it without sliding off.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Stacking functional Test\n\n");
+		bool success = true;
+
+		object floor(vector2D<fixed32>(0, 200), 0);
+		floor.frame = &floorGfx;
+		floor.isStatic = true;
+		vector<object*> objs(1, &floor);
+		for (int i = 0; i < numBoxes; i++)
+		{
+			objs.push_back(new object(vector2D<fixed32>(50 + i, 180 - 18 * i), i + 1));
+			objs.back()->frame = &box;
+		}
+
+		iprintf("dropping %d boxes\n", numBoxes);
+		contactSolver solver;
+		vector<object*> pushed;
+		unsigned int contacts = 0;
+		for (int frame = 0; frame < numFrames; frame++)
+		{
+			// Fall
+			for (int i = 1; i <= numBoxes; i++)
+			{
+				objs[i]->velocity.y += fixed32(0.25);
+				objs[i]->position += objs[i]->velocity;
+			}
+
+			// Everything against everything is fine for this many
+			for (unsigned int i = 0; i < objs.size(); i++)
+				for (unsigned int j = i + 1; j < objs.size(); j++)
+					if (collisionDetect(objs[i], objs[j]))
+						solver.addContact(objs[i], objs[j]);
+			contacts = solver.getNumContacts();
+			solver.solve(pushed);
+		}
+
+		iprintf("testing resting positions\n");
+		for (int i = 1; i <= numBoxes; i++)
+		{
+			object *o = objs[i];
+			if (o->position.x != 50 + i - 1 || o->position.y != 184 - 16 * (i - 1) || o->velocity.y != 0)
+			{
+				iprintf("\nBox %d at (%d, %d)\n", i, o->position.x.toInt(), o->position.y.toInt());
+				iprintf("should be (%d, %d)\n", 50 + i - 1, 184 - 16 * (i - 1));
+				success = false;
+			}
+		}
+
+		iprintf("testing contacts\n");
+		if (contacts != (unsigned int) numBoxes)
+		{
+			iprintf("\n%d contacts, should be %d\n", contacts, numBoxes);
+			success = false;
+		}
+
+		for (int i = 1; i <= numBoxes; i++)
+			delete objs[i];
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// How many boxes to stack and how long to let them fall
+	static const int numBoxes = 5;
+	static const int numFrames = 180;
+
+	// The frames the floor and boxes use
+	gfxAsset floorGfx, box;
+};
+
+
+/**
+ * sensorTest
+ *
+ * A functional test to test the sensorTracker's enter, stay and exit events
+ *
+ * @author Joe Balough
+ */
+class sensorTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	sensorTest()
+	{
+		name = "Sensor Test";
+
+		// A 32 x 32 sensor and a 16 x 16 box to walk through it
+		zone.dimensions = vector2D<uint8>(32, 32);
+		zone.topleft = vector2D<uint8>(0, 0);
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Walks a box through a sensor, stopping in the middle for a while, and counts the
+	 * events the sensor gets. Like the level, the overlap is only tested on the frames
+	 * the box moves.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Sensor functional Test\n\n");
+
+		iprintf("Walking a box through a sensor\n");
+		countingSensor sensor(vector2D<fixed32>(100, 100), 0);
+		sensor.frame = &zone;
+		sensor.isSensor = true;
+		object walker(vector2D<fixed32>(50, 108), 1);
+		walker.frame = &box;
+
+		sensorTracker tracker;
+		vector<bool> objMoved(2, false);
+		bool success = true;
+		for (int frame = 0; frame < numFrames; frame++)
+		{
+			// Stand still in the middle of it for a bit
+			bool moving = frame < 6 || frame >= 11;
+			if (moving)
+				walker.position.x += 10;
+			objMoved[1] = moving;
+
+			if (moving && collisionDetect(&sensor, &walker))
+				tracker.addOverlap(&sensor, &walker);
+			tracker.update(objMoved);
+
+			if (frame == 8 && (sensor.exits != 0 || tracker.getNumOverlaps() != 1))
+			{
+				iprintf("\nStanding still exited it\n");
+				success = false;
+			}
+		}
+
+		iprintf("testing events\n");
+		if (sensor.enters != 1 || sensor.stays != 9 || sensor.exits != 1 || sensor.last != &walker)
+		{
+			iprintf("\nGot %d enters, %d stays\n", sensor.enters, sensor.stays);
+			iprintf("and %d exits\n", sensor.exits);
+			iprintf("should be 1, 9, and 1\n");
+			success = false;
+		}
+		if (tracker.getNumOverlaps() != 0)
+		{
+			iprintf("\n%d overlaps left over\n", tracker.getNumOverlaps());
+			success = false;
+		}
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// A sensor that counts its events
+	class countingSensor : public object
+	{
+	public:
+		countingSensor(vector2D<fixed32> position, int id) : object(position, id)
+		{
+			enters = stays = exits = 0;
+			last = NULL;
+		}
+		virtual void sensorEnter(object *other) { enters++; last = other; }
+		virtual void sensorStay(object *other) { stays++; last = other; }
+		virtual void sensorExit(object *other) { exits++; last = other; }
+		int enters, stays, exits;
+		object *last;
+	};
+
+	// How many frames to walk for
+	static const int numFrames = 20;
+
+	// The frames the sensor and box use
+	gfxAsset zone, box;
+};
+
+
+/**
+ * spawnPoolTest
+ *
+ * A functional test to make sure objects can be made and destroyed over and over the way
+ * level::spawn() and level::despawn() do it: the objectBucket reuses its slots, the broadphase
+ * engines are fine with an id being reused and sensors hear about objects going away.
+ *
+ * @author Joe Balough
+ */
+class spawnPoolTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	spawnPoolTest()
+	{
+		name = "Spawn Pool Test";
+
+		// Everything is a 16 x 16 box
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Fills a pool, churns through it, then puts a new object in a reused id in each
+	 * broadphase engine and takes an object out from under a sensor.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Spawn Pool functional Test\n\n");
+		bool success = true;
+
+		// Something for them all to look like, made the way the assets class makes them
+		objectAsset *asset = new objectAsset(1);
+		asset->animations = new frameAsset**[2];
+		asset->animations[0] = new frameAsset*[2];
+		asset->animations[0][0] = new frameAsset;
+		asset->animations[0][0]->gfx = &box;
+		asset->animations[0][1] = NULL;
+		asset->animations[1] = NULL;
+		levelObjectAsset place(vector2D<fixed32>(100, 100), vector2D<fixed32>(0, 0), asset);
+
+		iprintf("testing filling the pool\n");
+		bodyStore bodies;
+		bodies.resize(capacity);
+		objectBucket<object> pool;
+		pool.reserve(capacity);
+		object *made[capacity];
+		for (int i = 0; i < capacity; i++)
+			made[i] = pool.add(NULL, i, &bodies, &place);
+		if (!made[0] || !made[capacity - 1] || pool.add(NULL, 0, &bodies, &place) || pool.size() != capacity)
+		{
+			iprintf("\nThe pool didn't fill up right\n");
+			success = false;
+		}
+
+		iprintf("testing reusing slots\n");
+		bool reused = true;
+		for (int frame = 0; frame < numFrames; frame++)
+		{
+			int i = frame % capacity;
+			pool.remove(made[i]);
+			if (pool.add(NULL, i, &bodies, &place) != made[i] || pool.size() != capacity)
+				reused = false;
+		}
+		if (!reused)
+		{
+			iprintf("\nThe pool didn't reuse a slot\n");
+			success = false;
+		}
+
+		// Id 1 goes away and comes back somewhere else
+		const char *names[3] = {"grid", "sap", "tree"};
+		int types[3] = {ZBE_BROADPHASE_GRID, ZBE_BROADPHASE_SAP, ZBE_BROADPHASE_TREE};
+		for (int t = 0; t < 3; t++)
+		{
+			iprintf("testing %s with a reused id\n", names[t]);
+			broadphase *engine = newBroadphase(types[t], 256, 256);
+			engine->insertObject(made[0]);
+			engine->insertObject(made[1]);
+
+			engine->removeObject(made[1]);
+			pool.remove(made[1]);
+			place.position = vector2D<fixed32>(200, 200);
+			made[1] = pool.add(NULL, 1, &bodies, &place);
+			engine->insertObject(made[1]);
+
+			vector<bool> objMoved(capacity, true);
+			vector<objPair> pairs;
+			engine->findPairs(objMoved, pairs);
+			unsigned int apart = pairs.size();
+
+			made[1]->position = vector2D<fixed32>(104, 104);
+			engine->updateObject(made[1]);
+			pairs.clear();
+			engine->findPairs(objMoved, pairs);
+			delete engine;
+
+			if (apart != 0 || pairs.size() != 1)
+			{
+				iprintf("\nFound %d then %d pairs\n", apart, (int) pairs.size());
+				iprintf("should be 0 then 1\n");
+				success = false;
+			}
+			place.position = vector2D<fixed32>(100, 100);
+		}
+
+		iprintf("testing despawning from a sensor\n");
+		exitCounter sensor(vector2D<fixed32>(100, 100), capacity);
+		sensor.frame = &box;
+		sensor.isSensor = true;
+		sensorTracker tracker;
+		vector<bool> objMoved(capacity + 1, false);
+		tracker.addOverlap(&sensor, made[0]);
+		tracker.update(objMoved);
+		tracker.removeObject(made[0]);
+		pool.remove(made[0]);
+		if (sensor.exits != 1 || tracker.getNumOverlaps() != 0)
+		{
+			iprintf("\nGot %d exits, should be 1\n", sensor.exits);
+			success = false;
+		}
+		delete asset;
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// A sensor that counts its exits
+	class exitCounter : public object
+	{
+	public:
+		exitCounter(vector2D<fixed32> position, int id) : object(position, id)
+		{
+			exits = 0;
+		}
+		virtual void sensorExit(object * /*other*/) { exits++; }
+		int exits;
+	};
+
+	// How many objects fit in the pool
+	static const int capacity = 8;
+
+	// How many times to take one out and put one back
+	static const int numFrames = 100;
+
+	// The frame everything uses
+	gfxAsset box;
+};
+
+
+/**
+ * levelSpawnTest
+ *
+ * A functional test to make sure level::spawn(), level::despawn() and level::getObject() make
+ * and destroy objects at the end of an update, reuse ids without old handles finding the new
+ * objects, stop at ZBE_SPAWN_CAPACITY and wake up anything left asleep on a despawned object,
+ * along with the rest of its island.
+ *
+ * @author Joe Balough
+ */
+class levelSpawnTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; sets the test name and makes an empty level to spawn into
+	 * @author Joe Balough
+	 */
+	levelSpawnTest()
+	{
+		name = "Level Spawn Test";
+
+		// A big empty level with no backgrounds, objects or heroes
+		empty[0] = NULL;
+		metadata.objects = metadata.heroes = empty;
+		metadata.name = NULL;
+		metadata.expMessage = metadata.debugMessage = NULL;
+		metadata.timer = 0;
+		metadata.tileset = NULL;
+		metadata.collisionLayer = ZBE_NO_COLLISION_LAYER;
+		for (int i = 0; i < 4; i++)
+			metadata.bgs[i].background = NULL;
+		metadata.dimensions = vector2D<uint32>(512, 512);
+		metadata.broadphase = ZBE_BROADPHASE_GRID;
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Spawns the testing assets' first object into the level until it's full, then despawns
+	 * and respawns some of them, checking what their handles find after every update.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Level Spawn functional Test\n\n");
+		bool success = true;
+		level lvl(&metadata, ZBE_GAMEPLAY_OAM);
+
+		iprintf("testing filling the level\n");
+		objectHandle handles[ZBE_SPAWN_CAPACITY];
+		bool filled = true;
+		for (int i = 0; i < ZBE_SPAWN_CAPACITY; i++)
+		{
+			handles[i] = lvl.spawn(0, spot(i));
+			filled &= !handles[i].isNull();
+		}
+		if (!filled || !lvl.spawn(0, spot(0)).isNull())
+		{
+			iprintf("\nThe level didn't fill up right\n");
+			success = false;
+		}
+
+		iprintf("testing making them\n");
+		bool waited = !lvl.getObject(handles[0]);
+		lvl.update();
+		object *first = lvl.getObject(handles[0]);
+		if (!waited || !first || first->position != spot(0))
+		{
+			iprintf("\nShould be made in update()\n");
+			success = false;
+		}
+
+		iprintf("testing despawning\n");
+		if (!lvl.despawn(handles[1]) || lvl.despawn(handles[1]) || lvl.getObject(handles[1]))
+		{
+			iprintf("\nThe despawned handle still works\n");
+			success = false;
+		}
+		lvl.update();
+
+		iprintf("testing reusing ids\n");
+		objectHandle reused = lvl.spawn(0, spot(1));
+		lvl.update();
+		if (reused.id != handles[1].id || lvl.getObject(handles[1]) || !lvl.getObject(reused))
+		{
+			iprintf("\nId %d should be reused\n", handles[1].id);
+			iprintf("and only found by the new handle\n");
+			success = false;
+		}
+
+		iprintf("testing despawning early\n");
+		lvl.despawn(reused);
+		lvl.update();
+		objectHandle early = lvl.spawn(0, spot(1));
+		bool cancelled = lvl.despawn(early);
+		lvl.update();
+		objectHandle again = lvl.spawn(0, spot(1));
+		if (!cancelled || lvl.getObject(early) || again.id != early.id)
+		{
+			iprintf("\nShouldn't be made and its id\n");
+			iprintf("should be free again\n");
+			success = false;
+		}
+		lvl.despawn(again);
+
+		// The boxes all fall asleep, then another one is put on top of one of them. The new
+		// one hasn't moved so the sleeping one doesn't notice it.
+		iprintf("testing waking sleepers\n");
+		for (int i = 0; i <= ZBE_SLEEP_FRAMES; i++)
+			lvl.update();
+		object *bottom = lvl.getObject(handles[ZBE_SPAWN_CAPACITY - 1]);
+		objectHandle top = lvl.spawn(0, spot(ZBE_SPAWN_CAPACITY - 1) - vector2D<fixed32>(0, 32));
+		lvl.update();
+		bool slept = bottom->asleep;
+		lvl.despawn(top);
+		lvl.update();
+		if (!slept || bottom->asleep)
+		{
+			iprintf("\nShould have slept then woken\n");
+			success = false;
+		}
+
+		// Two boxes fall into a stack on the floor and fall asleep together. Waking the top
+		// one has to wake the one under it too.
+		iprintf("testing waking an island\n");
+		for (int i = 2; i < 5; i++)
+			lvl.despawn(handles[i]);
+		lvl.update();
+		vector2D<fixed32> gravity(0, fixed32(0.25));
+		objectHandle lower = lvl.spawn(0, vector2D<fixed32>(136, 448), gravity);
+		objectHandle upper = lvl.spawn(0, vector2D<fixed32>(136, 400), gravity);
+		for (int i = 0; i < 4 * ZBE_SLEEP_FRAMES; i++)
+			lvl.update();
+		object *under = lvl.getObject(lower), *over = lvl.getObject(upper);
+		slept = under && over && under->asleep && over->asleep;
+		top = lvl.spawn(0, vector2D<fixed32>(136, 416));
+		lvl.update();
+		lvl.despawn(top);
+		lvl.update();
+		if (!slept || under->asleep || over->asleep)
+		{
+			iprintf("\nThe stack should have slept\n");
+			iprintf("then woken together\n");
+			success = false;
+		}
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Where the ith object goes, 8 in a row with room to spare around each one
+	vector2D<fixed32> spot(int i)
+	{
+		return vector2D<fixed32>(16 + (i % 8) * 60, 48 + (i / 8) * 100);
+	}
+
+	// The level everything is spawned into
+	levelAsset metadata;
+	levelObjectAsset *empty[1];
+};
+
+
+/**
+ * animationTest
+ *
+ * A functional test that makes sure the animationController shows each frame for its
+ * time, loops, switches animations when it's asked to and holds frames with no time.
+ *
+ * @author Joe Balough
+ */
+class animationTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	animationTest()
+	{
+		name = "Animation Test";
+
+		// A small box and a big one, so a frame change is also a hitbox change
+		small.dimensions = vector2D<uint8>(8, 8);
+		small.topleft = vector2D<uint8>(0, 0);
+		big.dimensions = vector2D<uint8>(16, 16);
+		big.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Steps through a walk animation with two frames, interrupts it, queues up a
+	 * jump after it and holds the jump's frame with no time. Then makes sure a
+	 * bucket reports an object that didn't move but changed frames.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Animation functional Test\n\n");
+		bool success = true;
+
+		// Walking is two frames, 3 and 2 blanks long. Jumping is one frame held with no time.
+		objectAsset *asset = new objectAsset(2);
+		asset->animations = new frameAsset**[3];
+		asset->animations[0] = new frameAsset*[3];
+		asset->animations[0][0] = new frameAsset;
+		asset->animations[0][0]->gfx = &small;
+		asset->animations[0][0]->time = 3;
+		asset->animations[0][1] = new frameAsset;
+		asset->animations[0][1]->gfx = &big;
+		asset->animations[0][1]->time = 2;
+		asset->animations[0][2] = NULL;
+		asset->animations[1] = new frameAsset*[2];
+		asset->animations[1][0] = new frameAsset;
+		asset->animations[1][0]->gfx = &big;
+		asset->animations[1][0]->time = 0;
+		asset->animations[1][1] = NULL;
+		asset->animations[2] = NULL;
+		frameAsset **walk = asset->animations[0], **jump = asset->animations[1];
+
+		iprintf("testing frame times\n");
+		animationController anim;
+		anim.setAnimations(asset->animations);
+		frameAsset *expected[7] = {walk[0], walk[0], walk[1], walk[1], walk[0], walk[0], walk[0]};
+		bool timed = anim.getFrame() == walk[0];
+		int changes = 0;
+		for (int i = 0; i < 7; i++)
+		{
+			if (anim.step())
+				changes++;
+			if (anim.getFrame() != expected[i])
+				timed = false;
+		}
+		if (!timed || changes != 2)
+		{
+			iprintf("\nWalk frames were wrong, %d changes\n", changes);
+			iprintf("should be 2\n");
+			success = false;
+		}
+
+		iprintf("testing play\n");
+		anim.play(0);
+		anim.play(1);
+		bool played = anim.step() && anim.getAnimation() == 1 && anim.getFrame() == jump[0];
+		for (int i = 0; i < 10; i++)
+			if (anim.step())
+				played = false;
+		anim.play(7);
+		if (!played || anim.step() || anim.getAnimation() != 1)
+		{
+			iprintf("\nplay didn't switch and hold\n");
+			success = false;
+		}
+
+		iprintf("testing playAfter\n");
+		anim.play(0);
+		anim.step();
+		anim.step();
+		anim.playAfter(1);
+		bool waited = true;
+		for (int i = 0; i < 3; i++)
+		{
+			anim.step();
+			if (anim.getAnimation() != 0)
+				waited = false;
+		}
+		anim.step();
+		if (!waited || anim.getAnimation() != 1 || anim.getFrameIndex() != 0)
+		{
+			iprintf("\nplayAfter didn't wait for the end\n");
+			success = false;
+		}
+
+		iprintf("testing frame changes as moves\n");
+		levelObjectAsset place(vector2D<fixed32>(100, 100), vector2D<fixed32>(0, 0), asset);
+		bodyStore bodies;
+		bodies.resize(2);
+		objectBucket<object> bucket;
+		bucket.reserve(2);
+		object *still = bucket.add(NULL, 0, &bodies, &place);
+		object *sleeper = bucket.add(NULL, 1, &bodies, &place);
+		bodies.setActive(still->getObjectId(), true);
+		vector<int> moved;
+		for (int i = 0; i < 3; i++)
+			bucket.animate(bodies, moved);
+		if (moved.size() != 1 || moved[0] != still->getObjectId() || still->frame != &big || still->animFrame != walk[1] ||
+		    sleeper->frame != &big)
+		{
+			iprintf("\n%d objects were moved\n", (int) moved.size());
+			iprintf("should be 1\n");
+			success = false;
+		}
+		bucket.remove(still);
+		bucket.remove(sleeper);
+		delete asset;
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// The frames' gfx
+	gfxAsset small, big;
+};
+
+
+/**
+ * oamShadowTest
+ *
+ * A functional test that makes sure an object only writing the parts of its OAM entry that
+ * changed ends up with the same entry oamSet would have written, and that it doesn't write
+ * anything when nothing changed. Draws into its own copy of the shadow OAM so the screen isn't touched.
+ *
+ * libnds API calls:
+ *   oamSet -- Sets a sprite in the OAM, for what the object should have written
+ *
+ * @author Joe Balough
+ */
+class oamShadowTest : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	oamShadowTest()
+	{
+		name = "OAM Shadow Test";
+
+		// Two 16 x 16 frames already in video memory, one after the other
+		for (int i = 0; i < 2; i++)
+		{
+			frames[i].dimensions = vector2D<uint8>(16, 16);
+			frames[i].topleft = vector2D<uint8>(0, 0);
+			frames[i].size = SpriteSize_16x16;
+			frames[i].vmLoaded = true;
+			frames[i].offset = SPRITE_GFX + i * 128;
+		}
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Draws an object, then moves it, turns it around, scrolls the screen, leaves it alone, turns
+	 * it back, changes its frame and gives it a different sprite id, checking its OAM entry each time.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("OAM Shadow functional Test\n\n");
+		bool success = true;
+
+		// Our own shadow OAMs, one for the object and one for oamSet
+		SpriteEntry written[SPRITE_COUNT], expected[SPRITE_COUNT];
+		memset(written, 0, sizeof(written));
+		memset(expected, 0, sizeof(expected));
+		OamState shadow = oamMain, reference = oamMain;
+		shadow.oamMemory = written;
+		reference.oamMemory = expected;
+
+		// One animation, the first frame shown for 3 blanks, so it changes on the third animate()
+		objectAsset *asset = new objectAsset(1);
+		asset->animations = new frameAsset**[2];
+		asset->animations[0] = new frameAsset*[3];
+		for (int i = 0; i < 2; i++)
+		{
+			asset->animations[0][i] = new frameAsset;
+			asset->animations[0][i]->gfx = &frames[i];
+			asset->animations[0][i]->time = 3;
+		}
+		asset->animations[0][2] = NULL;
+		asset->animations[1] = NULL;
+		levelObjectAsset place(vector2D<fixed32>(100, 100), vector2D<fixed32>(0, 0), asset);
+
+		bodyStore bodies;
+		bodies.resize(1);
+		objectBucket<object> bucket;
+		bucket.reserve(1);
+		object *obj = bucket.add(&shadow, 0, &bodies, &place);
+		vector2D<fixed32> oldOffset = screenOffset;
+		screenOffset = vector2D<fixed32>(0, 0);
+
+		iprintf("testing the first draw\n");
+		success &= check(obj, 0, written, &reference);
+
+		iprintf("testing moving\n");
+		obj->position = vector2D<fixed32>(-4, 150);
+		success &= check(obj, 0, written, &reference);
+
+		iprintf("testing flipping\n");
+		obj->velocity.x = -1;
+		obj->animate();
+		success &= check(obj, 0, written, &reference);
+
+		iprintf("testing scrolling\n");
+		screenOffset = vector2D<fixed32>(5, 5);
+		success &= check(obj, 0, written, &reference);
+
+		iprintf("testing not changing\n");
+		uint16 untouched = written[0].attribute[2] ^ 0x3FF;
+		written[0].attribute[2] = untouched;
+		obj->draw(0);
+		if (written[0].attribute[2] != untouched)
+		{
+			iprintf("\nAn unchanged sprite was written\n");
+			success = false;
+		}
+		written[0].attribute[2] ^= 0x3FF;
+
+		iprintf("testing turning back\n");
+		obj->velocity.x = 1;
+		obj->animate();
+		written[0].attribute[2] = untouched;
+		obj->draw(0);
+		if (written[0].attribute[2] != untouched || (written[0].attribute[1] & ATTR1_FLIP_X))
+		{
+			iprintf("\nTurning should only patch\n");
+			iprintf("the flip bit\n");
+			success = false;
+		}
+		written[0].attribute[2] ^= 0x3FF;
+		success &= check(obj, 0, written, &reference);
+
+		iprintf("testing changing frames\n");
+		obj->animate();
+		success &= check(obj, 0, written, &reference);
+
+		iprintf("testing a new sprite id\n");
+		obj->forgetSprite();
+		success &= check(obj, 1, written, &reference);
+
+		screenOffset = oldOffset;
+		bucket.remove(obj);
+		delete asset;
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Draws the object and makes sure its entry is what oamSet makes with the same settings
+	bool check(object *obj, int spriteId, SpriteEntry *written, OamState *reference)
+	{
+		obj->draw(spriteId);
+		oamSet(reference, spriteId, (obj->position.x - screenOffset.x).toInt(), (obj->position.y - screenOffset.y).toInt(), 1, 0,
+		       obj->frame->size, SpriteColorFormat_16Color, obj->frame->offset, -1, true, false, obj->isFlipped(), false, false);
+
+		for (int i = 0; i < 3; i++)
+		{
+			if (written[spriteId].attribute[i] != reference->oamMemory[spriteId].attribute[i])
+			{
+				iprintf("\nAttribute %d was %x\n", i, written[spriteId].attribute[i]);
+				iprintf("should be %x\n", reference->oamMemory[spriteId].attribute[i]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The frames' gfx
+	gfxAsset frames[2];
+};
+
+
+/**
+ * rebinBenchmark
+ *
+ * A functional test that times how long it takes to put thousands of moving objects back into their
+ * collisionMatrix blocks every frame. The old way (a vector per block that has to be searched before the
+ * object can be erased from it) is recreated locally and timed against collisionMatrix::moveObject().
+ * The test fails if the two ways disagree about how many objects are in a block.
+ *
+ * libnds API calls:
+ *   cpuStartTiming -- Starts timers 0 and 1 cascaded for timing
+ *   cpuEndTiming -- Returns the number of bus ticks since cpuStartTiming
+ *
+ * @author Joe Balough
+ */
+class rebinBenchmark : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	rebinBenchmark()
+	{
+		name = "collisionMatrix Rebin Benchmark";
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Moves a bunch of objects around a level for a bunch of frames, re-binning every one of them each
+	 * frame, once with vectors and once with the intrusive objGroup lists.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("collisionMatrix Rebin Benchmark\n\n");
+		iprintf("%d objects for %d frames\n\n", numObjects, numFrames);
+
+		// Two identical sets of objects
+		vector<object*> oldObjs, newObjs;
+		for (int i = 0; i < numObjects; i++)
+		{
+			vector2D<fixed32> pos(i * 37 % levelSize, i * 91 % levelSize);
+			oldObjs.push_back(new object(pos, i));
+			newObjs.push_back(new object(pos, i));
+			oldObjs[i]->velocity = newObjs[i]->velocity = vector2D<fixed32>(i % 7 - 3, i % 5 - 2);
+		}
+
+		// The old way: a vector per block and the block index of every object
+		const int blocksWide = levelSize / blockSize + 1;
+		vector< vector<object*> > oldBlocks(blocksWide * blocksWide);
+		vector<int> oldBlockOf(numObjects);
+		for (int i = 0; i < numObjects; i++)
+		{
+			oldBlockOf[i] = blockOf(oldObjs[i], blocksWide);
+			oldBlocks[oldBlockOf[i]].push_back(oldObjs[i]);
+		}
+
+		// The new way
+		collisionMatrix mat(levelSize, levelSize, blockSize);
+		for (int i = 0; i < numObjects; i++)
+			mat.addObject(newObjs[i]);
+
+		// Time the old way
+		uint32 oldTicks = 0;
+		for (int f = 0; f < numFrames; f++)
+		{
+			moveAll(oldObjs);
+			cpuStartTiming(0);
+			for (int i = 0; i < numObjects; i++)
+			{
+				// Search and erase, then push onto the new block
+				vector<object*> &from = oldBlocks[oldBlockOf[i]];
+				for (vector<object*>::iterator c = from.begin(); c != from.end(); ++c)
+				{
+					if (*c == oldObjs[i])
+					{
+						from.erase(c);
+						break;
+					}
+				}
+				oldBlockOf[i] = blockOf(oldObjs[i], blocksWide);
+				oldBlocks[oldBlockOf[i]].push_back(oldObjs[i]);
+			}
+			oldTicks += cpuEndTiming();
+		}
+
+		// Time the new way
+		uint32 newTicks = 0;
+		for (int f = 0; f < numFrames; f++)
+		{
+			moveAll(newObjs);
+			cpuStartTiming(0);
+			for (int i = 0; i < numObjects; i++)
+				mat.moveObject(newObjs[i]);
+			newTicks += cpuEndTiming();
+		}
+
+		iprintf("vector:    %8ld ticks\n", (long int) oldTicks);
+		iprintf("           %8ld / frame\n", (long int) (oldTicks / numFrames));
+		iprintf("intrusive: %8ld ticks\n", (long int) newTicks);
+		iprintf("           %8ld / frame\n", (long int) (newTicks / numFrames));
+
+		// Both ways should have ended up with the same blocks
+		bool success = true;
+		for (int i = 0; i < numObjects && success; i++)
+		{
+			objGroup *group = mat.getObjGroup(newObjs[i]->position);
+			if (newObjs[i]->group != group || group->numObjects != oldBlocks[oldBlockOf[i]].size())
+			{
+				iprintf("\nObject %d is in the wrong\n", i);
+				iprintf("objGroup after moving.\n");
+				success = false;
+			}
+		}
+
+		for (int i = 0; i < numObjects; i++)
+		{
+			delete oldObjs[i];
+			delete newObjs[i];
+		}
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	/**
+	 * moveAll function
+	 *
+	 * Moves every object by its velocity, bouncing it off the edges of the level
+	 *
+	 * @param vector<object*> &objs
+	 *   The objects to move
+	 * @author Joe Balough
+	 */
+	void moveAll(vector<object*> &objs)
+	{
+		for (unsigned int i = 0; i < objs.size(); i++)
+		{
+			object *o = objs[i];
+			o->position += o->velocity;
+			if (o->position.x < 0 || o->position.x >= levelSize)
+			{
+				o->velocity.x = -o->velocity.x;
+				o->position.x += o->velocity.x;
+			}
+			if (o->position.y < 0 || o->position.y >= levelSize)
+			{
+				o->velocity.y = -o->velocity.y;
+				o->position.y += o->velocity.y;
+			}
+		}
+	}
+
+	/**
+	 * blockOf function
+	 *
+	 * Gets the index of the block an object is in for the old vector way
+	 *
+	 * @param object *o
+	 *   The object to find the block of
+	 * @param int blocksWide
+	 *   How many blocks wide (and tall) the level is
+	 * @return int
+	 *   The index of that block
+	 * @author Joe Balough
+	 */
+	inline int blockOf(object *o, int blocksWide)
+	{
+		return (o->position.y.toInt() / blockSize) * blocksWide + o->position.x.toInt() / blockSize;
+	}
+
+	// How much work to time
+	static const int numObjects = 2000;
+	static const int numFrames = 30;
+
+	// The level is levelSize x levelSize px broken into blockSize px blocks
+	static const int levelSize = 1024;
+	static const int blockSize = 64;
+};
+
+
+/**
+ * pairCountBenchmark
+ *
+ * A functional test that compares the number of pairs tested on a dense level when every object queries its
+ * whole neighbourhood (collisionMatrix::forEachCandidate) against the unique pairs found by
+ * collisionMatrix::forEachPair. The test fails unless the neighbourhood queries found every pair exactly twice.
+ *
+ * libnds API calls:
+ *   cpuStartTiming -- Starts timers 0 and 1 cascaded for timing
+ *   cpuEndTiming -- Returns the number of bus ticks since cpuStartTiming
+ *
+ * @author Joe Balough
+ */
+class pairCountBenchmark : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	pairCountBenchmark()
+	{
+		name = "Broadphase Pair Count Benchmark";
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Packs a bunch of objects into a small level and counts (and times) the pairs found both ways.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Broadphase Pair Count Benchmark\n\n");
+		iprintf("%d objects in %d x %d px\n\n", numObjects, levelSize, levelSize);
+
+		collisionMatrix mat(levelSize, levelSize, blockSize);
+		vector<object*> objs;
+		for (int i = 0; i < numObjects; i++)
+		{
+			objs.push_back(new object(vector2D<fixed32>(i * 37 % levelSize, i * 91 % levelSize), i));
+			mat.addObject(objs[i]);
+		}
+
+		// Every object asks about its neighbourhood
+		candidateCounter candidates;
+		cpuStartTiming(0);
+		for (int i = 0; i < numObjects; i++)
+		{
+			candidates.self = objs[i];
+			mat.forEachCandidate(objs[i]->position, candidates);
+		}
+		uint32 candTicks = cpuEndTiming();
+
+		// One sweep for unique pairs
+		pairCounter pairs;
+		cpuStartTiming(0);
+		uint32 numPairs = mat.forEachPair(pairs);
+		uint32 pairTicks = cpuEndTiming();
+
+		iprintf("per object: %6ld pairs\n", (long int) candidates.count);
+		iprintf("            %6ld ticks\n", (long int) candTicks);
+		iprintf("unique:     %6ld pairs\n", (long int) numPairs);
+		iprintf("            %6ld ticks\n", (long int) pairTicks);
+
+		for (int i = 0; i < numObjects; i++)
+			delete objs[i];
+
+		if (numPairs != pairs.count || candidates.count != 2 * numPairs)
+		{
+			iprintf("\nforEachPair found %ld pairs,\n", (long int) numPairs);
+			iprintf("should be %ld\n", (long int) (candidates.count / 2));
+			iprintf("Test failed.\n");
+			pauseIfTesting();
+			return false;
+		}
+
+		iprintf("\n       Test successful.\n");
+		pauseIfTesting();
+		return true;
+	}
+
+private:
+	// Counts forEachCandidate visits that aren't the object asking
+	struct candidateCounter
+	{
+		candidateCounter() { count = 0; self = NULL; }
+		inline void operator()(object *candidate) { if (candidate != self) count++; }
+		uint32 count;
+		object *self;
+	};
+
+	// Counts forEachPair visits
+	struct pairCounter
+	{
+		pairCounter() { count = 0; }
+		inline void operator()(object *, object *) { count++; }
+		uint32 count;
+	};
+
+	// How much work to do
+	static const int numObjects = 300;
+
+	// The level is levelSize x levelSize px broken into blockSize px blocks
+	static const int levelSize = 256;
+	static const int blockSize = 64;
+};
+
+
+/**
+ * pairCacheBenchmark
+ *
+ * A functional test that times collisionMatrix::findPairs, which only walks the cached neighbours of
+ * the objects that moved, against sweeping every occupied block with collisionMatrix::forEachPair on a
+ * dense level where only some of the objects move each frame. A few objects are too big for a block and
+ * some switch sizes along the way. The test fails if the two ever disagree about the pairs.
+ *
+ * libnds API calls:
+ *   cpuStartTiming -- Starts timers 0 and 1 cascaded for timing
+ *   cpuEndTiming -- Returns the number of bus ticks since cpuStartTiming
+ *
+ * @author Joe Balough
+ */
+class pairCacheBenchmark : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	pairCacheBenchmark()
+	{
+		name = "Pair Cache Benchmark";
+
+		// Most objects fit in a block, the big ones don't
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+		wide.dimensions = vector2D<uint8>(80, 24);
+		wide.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Moves every moveEvery-th object each frame and finds the pairs both ways.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Pair Cache Benchmark\n\n");
+		iprintf("%d objects for %d frames,\n", numObjects, numFrames);
+		iprintf("1 in %d moving\n\n", moveEvery);
+
+		collisionMatrix mat(levelSize, levelSize, blockSize);
+		vector<object*> objs;
+		for (int i = 0; i < numObjects; i++)
+		{
+			objs.push_back(new object(vector2D<fixed32>(i * 37 % levelSize, i * 91 % levelSize), i));
+			objs[i]->frame = (i % bigEvery) ? &box : &wide;
+			objs[i]->velocity = vector2D<fixed32>(i % 7 - 3, i % 5 - 2);
+			mat.insertObject(objs[i]);
+		}
+
+		uint32 cacheTicks = 0, sweepTicks = 0;
+		unsigned int wrong = 0;
+		vector<objPair> cached, swept;
+		vector< pair<int, int> > cachedIds, sweptIds;
+		for (int f = 0; f < numFrames; f++)
+		{
+			// Move some of them, turning the odd one big or small
+			vector<bool> objMoved(numObjects, false);
+			for (int i = f % moveEvery; i < numObjects; i += moveEvery)
+			{
+				object *o = objs[i];
+				o->position += o->velocity;
+				if (o->position.x < 0 || o->position.x >= levelSize)
+					o->velocity.x = -o->velocity.x;
+				if (o->position.y < 0 || o->position.y >= levelSize)
+					o->velocity.y = -o->velocity.y;
+				if ((i + f) % 97 == 0)
+					o->frame = (o->frame == &box) ? &wide : &box;
+
+				mat.updateObject(o);
+				objMoved[i] = true;
+			}
+
+			cached.clear();
+			cpuStartTiming(0);
+			mat.findPairs(objMoved, cached);
+			cacheTicks += cpuEndTiming();
+
+			swept.clear();
+			cpuStartTiming(0);
+			movedPairCollector collect(objMoved, swept);
+			mat.forEachPair(collect);
+			sweepTicks += cpuEndTiming();
+
+			// They only need the same pairs, not the same order
+			sortedIds(cached, cachedIds);
+			sortedIds(swept, sweptIds);
+			if (cachedIds != sweptIds)
+				wrong++;
+		}
+
+		iprintf("cached: %8ld ticks/frame\n", (long int) (cacheTicks / numFrames));
+		iprintf("swept:  %8ld ticks/frame\n", (long int) (sweepTicks / numFrames));
+
+		for (int i = 0; i < numObjects; i++)
+			delete objs[i];
+
+		if (wrong)
+		{
+			iprintf("\n%ld frames disagree\n", (long int) wrong);
+			iprintf("Test failed.\n");
+			pauseIfTesting();
+			return false;
+		}
+
+		iprintf("\n       Test successful.\n");
+		pauseIfTesting();
+		return true;
+	}
+
+private:
+	// Lists pairs by id, lower id first, in order
+	static void sortedIds(vector<objPair> &pairs, vector< pair<int, int> > &ids)
+	{
+		ids.clear();
+		for (unsigned int p = 0; p < pairs.size(); p++)
+		{
+			int a = pairs[p].a->getObjectId(), b = pairs[p].b->getObjectId();
+			ids.push_back((a < b) ? make_pair(a, b) : make_pair(b, a));
+		}
+		sort(ids.begin(), ids.end());
+	}
+
+	// How much work to do
+	static const int numObjects = 400;
+	static const int numFrames = 60;
+
+	// Every moveEvery-th object moves each frame and every bigEvery-th one starts out big
+	static const int moveEvery = 8;
+	static const int bigEvery = 25;
+
+	// The level is levelSize x levelSize px broken into blockSize px blocks
+	static const int levelSize = 512;
+	static const int blockSize = 32;
+
+	// The frames the objects use
+	gfxAsset box, wide;
+};
+
+
+/**
+ * aabbBatchBenchmark
+ *
+ * A functional test that times the narrowphase's box tests on a dense level: collisionDetect on every
+ * pair one by one against aabbStore::overlapBatch on all of them at once. The test fails unless both
+ * ways (and overlapBatchScalar, if overlapBatch is the SSE2 one) agree about every pair.
+ *
+ * libnds API calls:
+ *   cpuStartTiming -- Starts timers 0 and 1 cascaded for timing
+ *   cpuEndTiming -- Returns the number of bus ticks since cpuStartTiming
+ *
+ * @author Joe Balough
+ */
+class aabbBatchBenchmark : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; sets the test name and makes the frame
+	 * @author Joe Balough
+	 */
+	aabbBatchBenchmark()
+	{
+		name = "Batched AABB Benchmark";
+
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Packs a bunch of objects into a small level, finds their pairs with a grid
+	 * and tests (and times) the pairs' boxes both ways.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Batched AABB Benchmark\n\n");
+		iprintf("%d objects in %d x %d px\n\n", numObjects, levelSize, levelSize);
+
+		collisionMatrix mat(levelSize, levelSize, blockSize);
+		aabbStore boxes;
+		boxes.resize(numObjects);
+		vector<object*> objs;
+		for (int i = 0; i < numObjects; i++)
+		{
+			objs.push_back(new object(vector2D<fixed32>(i * 37 % levelSize, i * 91 % levelSize), i));
+			objs[i]->frame = &box;
+			mat.addObject(objs[i]);
+			boxes.update(objs[i]);
+		}
+
+		pairLister pairs;
+		mat.forEachPair(pairs);
+		unsigned int numPairs = pairs.idsA.size();
+
+		// One pair at a time, following the pointers
+		vector<uint8> oneByOne(numPairs);
+		cpuStartTiming(0);
+		for (unsigned int p = 0; p < numPairs; p++)
+			oneByOne[p] = collisionDetect(objs[pairs.idsA[p]], objs[pairs.idsB[p]]);
+		uint32 oneTicks = cpuEndTiming();
+
+		// All at once
+		vector<uint8> batched(numPairs), scalar(numPairs);
+		cpuStartTiming(0);
+		unsigned int numHits = boxes.overlapBatch(&pairs.idsA[0], &pairs.idsB[0], numPairs, &batched[0]);
+		uint32 batchTicks = cpuEndTiming();
+		unsigned int numScalarHits = boxes.overlapBatchScalar(&pairs.idsA[0], &pairs.idsB[0], numPairs, &scalar[0]);
+
+		iprintf("pairs:      %6ld\n", (long int) numPairs);
+		iprintf("touching:   %6ld\n", (long int) numHits);
+		iprintf("one by one: %6ld ticks\n", (long int) oneTicks);
+		iprintf("batched:    %6ld ticks\n", (long int) batchTicks);
+
+		for (int i = 0; i < numObjects; i++)
+			delete objs[i];
+
+		unsigned int wrong = 0;
+		for (unsigned int p = 0; p < numPairs; p++)
+			if (oneByOne[p] != batched[p] || batched[p] != scalar[p])
+				wrong++;
+		if (wrong || numHits != numScalarHits)
+		{
+			iprintf("\n%ld pairs disagree\n", (long int) wrong);
+			iprintf("Test failed.\n");
+			pauseIfTesting();
+			return false;
+		}
+
+		iprintf("\n       Test successful.\n");
+		pauseIfTesting();
+		return true;
+	}
+
+private:
+	// Lists forEachPair's pairs by id
+	struct pairLister
+	{
+		inline void operator()(object *a, object *b)
+		{
+			idsA.push_back(a->getObjectId());
+			idsB.push_back(b->getObjectId());
+		}
+		vector<int> idsA, idsB;
+	};
+
+	// How much work to do
+	static const int numObjects = 300;
+
+	// The level is levelSize x levelSize px broken into blockSize px blocks
+	static const int levelSize = 256;
+	static const int blockSize = 64;
+
+	// The frame every object uses
+	gfxAsset box;
+};
+
+
+/**
+ * broadphaseBenchmark
+ *
+ * A functional test that runs every broadphase engine on the same scenes: a small level packed with objects
+ * and a huge level with only a few. Each engine is timed keeping up with the objects as they move and finding
+ * pairs every frame. The test fails if the engines don't agree on how many pairs are actually colliding.
+ *
+ * libnds API calls:
+ *   cpuStartTiming -- Starts timers 0 and 1 cascaded for timing
+ *   cpuEndTiming -- Returns the number of bus ticks since cpuStartTiming
+ *
+ * @author Joe Balough
+ */
+class broadphaseBenchmark : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	broadphaseBenchmark()
+	{
+		name = "Broadphase Engine Benchmark";
+
+		// Every object in the test is a 16 x 16 box
+		box.dimensions = vector2D<uint8>(16, 16);
+		box.topleft = vector2D<uint8>(0, 0);
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Runs both scenes with every engine
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("Broadphase Engine Benchmark\n\n");
+
+		bool success = true;
+		iprintf("Dense: %d objs, %dx%d px\n", denseObjects, denseSize, denseSize);
+		success &= runScene(denseObjects, denseSize);
+		iprintf("Sparse: %d objs, %dx%d px\n", sparseObjects, sparseSize, sparseSize);
+		success &= runScene(sparseObjects, sparseSize);
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	/**
+	 * runScene function
+	 *
+	 * Runs one scene with every engine and prints how long each took
+	 *
+	 * @param int numObjects
+	 *   How many objects to put in the level
+	 * @param int levelSize
+	 *   The level is levelSize x levelSize px
+	 * @return bool
+	 *   Whether or not the engines agreed
+	 * @author Joe Balough
+	 */
+	bool runScene(int numObjects, int levelSize)
+	{
+		const char *names[numEngines] = {"grid", "sap", "tree"};
+		const int types[numEngines] = {ZBE_BROADPHASE_GRID, ZBE_BROADPHASE_SAP, ZBE_BROADPHASE_TREE};
+		uint32 hits[numEngines];
+
+		for (int e = 0; e < numEngines; e++)
+		{
+			// Make the same objects every time. They all moved every frame.
+			vector<object*> objs;
+			vector<bool> objMoved(numObjects, true);
+			vector<objPair> pairs;
+			broadphase *engine = newBroadphase(types[e], levelSize, levelSize);
+			for (int i = 0; i < numObjects; i++)
+			{
+				objs.push_back(new object(vector2D<fixed32>(i * 37 % (levelSize - 16), i * 91 % (levelSize - 16)), i));
+				objs[i]->frame = &box;
+				objs[i]->velocity = vector2D<fixed32>(i % 7 - 3, i % 5 - 2);
+				engine->insertObject(objs[i]);
+			}
+
+			hits[e] = 0;
+			uint32 ticks = 0, numPairs = 0;
+			for (int f = 0; f < numFrames; f++)
+			{
+				// Move everything and keep it in the level
+				for (int i = 0; i < numObjects; i++)
+				{
+					object *o = objs[i];
+					o->position += o->velocity;
+					if (o->position.x < 0 || o->position.x >= levelSize - 16)
+					{
+						o->velocity.x = -o->velocity.x;
+						o->position.x += o->velocity.x;
+					}
+					if (o->position.y < 0 || o->position.y >= levelSize - 16)
+					{
+						o->velocity.y = -o->velocity.y;
+						o->position.y += o->velocity.y;
+					}
+				}
+
+				cpuStartTiming(0);
+				for (int i = 0; i < numObjects; i++)
+					engine->updateObject(objs[i]);
+				pairs.clear();
+				numPairs += engine->findPairs(objMoved, pairs);
+				ticks += cpuEndTiming();
+
+				// Count the ones that are actually colliding
+				for (unsigned int p = 0; p < pairs.size(); p++)
+					if (decapod::collisionDetect(pairs[p].a, pairs[p].b))
+						hits[e]++;
+			}
+
+			iprintf(" %-4s %8ld ticks/frame\n", names[e], (long int) (ticks / numFrames));
+			iprintf("      %8ld pairs/frame\n", (long int) (numPairs / numFrames));
+
+			delete engine;
+			for (int i = 0; i < numObjects; i++)
+				delete objs[i];
+		}
+
+		for (int e = 1; e < numEngines; e++)
+		{
+			if (hits[e] != hits[0])
+			{
+				iprintf("\n%s found %ld collisions,\n", names[e], (long int) hits[e]);
+				iprintf("%s found %ld\n", names[0], (long int) hits[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The frame every object uses
+	gfxAsset box;
+
+	// How many engines there are to test
+	static const int numEngines = 3;
+
+	// How much work to do
+	static const int numFrames = 30;
+	static const int denseObjects = 200;
+	static const int denseSize = 256;
+	static const int sparseObjects = 50;
+	static const int sparseSize = 4096;
+};
+
+
+/**
+ * fixedPointBenchmark
+ *
+ * A functional test that times one frame's worth of decapodian physics done with floats against the
+ * same work done with fixed32. The float path is a copy of the old object::update() and
+ * decapod::collisionDetect() so the numbers show what switching to fixed point bought us on real hardware.
+ * The test fails if the two paths end up more than a pixel apart.
+ *
+ * libnds API calls:
+ *   cpuStartTiming -- Starts timers 0 and 1 cascaded for timing
+ *   cpuEndTiming -- Returns the number of bus ticks since cpuStartTiming
+ *
+ * @author Joe Balough
+ */
+class fixedPointBenchmark : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	fixedPointBenchmark()
+	{
+		name = "fixed32 Physics Benchmark";
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Integrates a bunch of bodies for a bunch of frames and runs a bounding box test on every pair
+	 * each frame, once with floats and once with fixed32.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("fixed32 Physics Benchmark\n\n");
+		iprintf("%d bodies for %d frames\n\n", numBodies, numFrames);
+
+		// Float path
+		vector2D<float> fPos[numBodies], fVel[numBodies];
+		vector2D<float> fGrav(0.0, 0.025);
+		// Fixed path
+		vector2D<fixed32> xPos[numBodies], xVel[numBodies];
+		vector2D<fixed32> xGrav(0, fixed32(0.025));
+
+		for (int i = 0; i < numBodies; i++)
+		{
+			fPos[i] = vector2D<float>(float(i * 7 % 256), float(i * 13 % 192));
+			fVel[i] = vector2D<float>(float(i % 5) / 4.0, 0.0);
+			xPos[i] = vector2D<fixed32>(i * 7 % 256, i * 13 % 192);
+			xVel[i] = vector2D<fixed32>(fixed32(i % 5) / 4, 0);
+		}
+
+		// Time the float path
+		uint32 fHits = 0;
+		cpuStartTiming(0);
+		for (int f = 0; f < numFrames; f++)
+		{
+			for (int i = 0; i < numBodies; i++)
+			{
+				fVel[i].x += fGrav.x;
+				fVel[i].y += fGrav.y;
+				fPos[i].x += fVel[i].x;
+				fPos[i].y += fVel[i].y;
+			}
+			for (int i = 0; i < numBodies; i++)
+				for (int j = i + 1; j < numBodies; j++)
+					if (!(fPos[i].x + 16.0 < fPos[j].x || fPos[i].x > fPos[j].x + 16.0 ||
+					      fPos[i].y + 16.0 < fPos[j].y || fPos[i].y > fPos[j].y + 16.0))
+						++fHits;
+		}
+		uint32 fTicks = cpuEndTiming();
+
+		// Time the fixed32 path
+		uint32 xHits = 0;
+		fixed32 size(16);
+		cpuStartTiming(0);
+		for (int f = 0; f < numFrames; f++)
+		{
+			for (int i = 0; i < numBodies; i++)
+			{
+				xVel[i] += xGrav;
+				xPos[i] += xVel[i];
+			}
+			for (int i = 0; i < numBodies; i++)
+				for (int j = i + 1; j < numBodies; j++)
+					if (!(xPos[i].x + size < xPos[j].x || xPos[i].x > xPos[j].x + size ||
+					      xPos[i].y + size < xPos[j].y || xPos[i].y > xPos[j].y + size))
+						++xHits;
+		}
+		uint32 xTicks = cpuEndTiming();
+
+		iprintf("float:   %8ld ticks\n", (long int) fTicks);
+		iprintf("         %8ld / frame\n", (long int) (fTicks / numFrames));
+		iprintf("         %8ld hits\n", (long int) fHits);
+		iprintf("fixed32: %8ld ticks\n", (long int) xTicks);
+		iprintf("         %8ld / frame\n", (long int) (xTicks / numFrames));
+		iprintf("         %8ld hits\n", (long int) xHits);
+
+		// Make sure the fixed32 path is still doing the same physics
+		for (int i = 0; i < numBodies; i++)
+		{
+			int dx = int(fPos[i].x) - xPos[i].x.toInt();
+			int dy = int(fPos[i].y) - xPos[i].y.toInt();
+			if (dx < -1 || dx > 1 || dy < -1 || dy > 1)
+			{
+				iprintf("\nBody %d drifted:\n", i);
+				iprintf(" float (%d, %d)\n", int(fPos[i].x), int(fPos[i].y));
+				iprintf(" fixed32 (%d, %d)\n", xPos[i].x.toInt(), xPos[i].y.toInt());
+				iprintf("Test failed.\n");
+				pauseIfTesting();
+				return false;
+			}
+		}
+
+		iprintf("\n       Test successful.\n");
+		pauseIfTesting();
+		return true;
+	}
+
+private:
+	// How much work to time
+	static const int numBodies = 64;
+	static const int numFrames = 60;
+};
+
+
+/**
+ * bodyStoreBenchmark
+ *
+ * A functional test that times moving a bunch of objects the old way (each one allocated on its own
+ * with its physics in among everything else and moved by its virtual update function) against
+ * bodyStore::integrate(). The old way is recreated locally. The test fails if the two end up
+ * anywhere different, if they disagree on what moved or if an object doesn't see its slot.
+ *
+ * libnds API calls:
+ *   cpuStartTiming -- Starts timers 0 and 1 cascaded for timing
+ *   cpuEndTiming -- Returns the number of bus ticks since cpuStartTiming
+ *
+ * @author Joe Balough
+ */
+class bodyStoreBenchmark : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	bodyStoreBenchmark()
+	{
+		name = "bodyStore Benchmark";
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Moves the same bodies both ways for a bunch of frames, with every fourth one asleep,
+	 * then makes sure they match.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("bodyStore Benchmark\n\n");
+		iprintf("%d bodies for %d frames\n\n", numBodies, numFrames);
+
+		// Set up both with the same bodies
+		vector<scatteredBody*> scattered;
+		bodyStore bodies;
+		bodies.resize(numBodies);
+		for (int i = 0; i < numBodies; i++)
+		{
+			scatteredBody *body = new scatteredBody;
+			body->position = vector2D<fixed32>(i * 7 % 256, i * 13 % 192);
+			body->velocity = vector2D<fixed32>(fixed32(i % 5) / 4, 0);
+			body->acceleration = vector2D<fixed32>(0, 0);
+			body->gravity = vector2D<fixed32>(0, (i % 3) ? fixed32(0.025) : fixed32(0));
+			body->falling = (i % 7) != 0;
+			body->asleep = (i % 4) == 3;
+			scattered.push_back(body);
+
+			bodies.position[i] = body->position;
+			bodies.velocity[i] = body->velocity;
+			bodies.acceleration[i] = body->acceleration;
+			bodies.gravity[i] = body->gravity;
+			bodies.falling[i] = body->falling;
+			bodies.setActive(i, !body->asleep);
+		}
+
+		// Time the old way
+		vector<int> moved;
+		uint32 oldMoved = 0;
+		cpuStartTiming(0);
+		for (int f = 0; f < numFrames; f++)
+		{
+			moved.clear();
+			for (int i = 0; i < numBodies; i++)
+			{
+				if (scattered[i]->asleep)
+					continue;
+				if (scattered[i]->update())
+					moved.push_back(i);
+			}
+			oldMoved += moved.size();
+		}
+		uint32 oldTicks = cpuEndTiming();
+
+		// Time the bodyStore
+		uint32 newMoved = 0;
+		cpuStartTiming(0);
+		for (int f = 0; f < numFrames; f++)
+		{
+			moved.clear();
+			bodies.integrate(moved);
+			newMoved += moved.size();
+		}
+		uint32 newTicks = cpuEndTiming();
+
+		iprintf("virtual update: %8ld ticks\n", (long int) oldTicks);
+		iprintf("                %8ld / frame\n", (long int) (oldTicks / numFrames));
+		iprintf("bodyStore:      %8ld ticks\n", (long int) newTicks);
+		iprintf("                %8ld / frame\n", (long int) (newTicks / numFrames));
+
+		// They have to have done exactly the same thing
+		bool success = oldMoved == newMoved;
+		for (int i = 0; i < numBodies; i++)
+		{
+			scatteredBody *body = scattered[i];
+			if (body->position.x != bodies.position[i].x || body->position.y != bodies.position[i].y ||
+			    body->velocity.x != bodies.velocity[i].x || body->velocity.y != bodies.velocity[i].y)
+				success = false;
+			delete body;
+		}
+		if (!success)
+		{
+			iprintf("\nThe bodyStore moved things\n");
+			iprintf("differently.\n");
+		}
+
+		// An object's fields are its slot
+		gfxAsset gfx;
+		gfx.dimensions = vector2D<uint8>(16, 16);
+		gfx.topleft = vector2D<uint8>(0, 0);
+		frameAsset frame;
+		frame.gfx = &gfx;
+		frameAsset *animation[] = {&frame, NULL};
+		frameAsset **animations[] = {animation, NULL};
+		bodyStore one;
+		one.resize(2);
+		object bound(NULL, 1, &one, animations, vector2D<fixed32>(20, 30), vector2D<fixed32>(0, 1), 1);
+		one.setActive(1, true);
+		moved.clear();
+		one.integrate(moved);
+		if (bound.position.y != 31 || bound.velocity.y != 1 || one.frame[1] != &gfx || moved.size() != 1 || moved[0] != 1)
+		{
+			iprintf("\nAn object didn't see its slot\n");
+			success = false;
+		}
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+			iprintf("Test failed.\n");
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// An object the old way: its physics are in among things that don't get touched every frame
+	class scatteredBody
+	{
+	public:
+		virtual ~scatteredBody()
+		{}
+
+		// A copy of the old object::update()
+		virtual bool update()
+		{
+			if (falling)
+			{
+				velocity.x += gravity.x;
+				velocity.y += gravity.y;
+			}
+
+			velocity.x += acceleration.x;
+			velocity.y += acceleration.y;
+
+			position.x += velocity.x;
+			position.y += velocity.y;
+
+			return velocity.x != 0 || velocity.y != 0;
+		}
+
+		void *oam;
+		void *animations;
+		int matrixId, priority, angle;
+		vector2D<int> scale;
+		bool falling;
+		vector2D<fixed32> position, velocity, acceleration, gravity;
+		void *frame, *animFrame, *group, *groupPrev, *groupNext;
+		bool asleep;
+		bool hflip, vflip, mosaic, hidden;
+	};
+
+	// How much work to time
+	static const int numBodies = 256;
+	static const int numFrames = 60;
+};
+
+
+/**
+ * objectBucketBenchmark
+ *
+ * A functional test that times running two types of objects' update functions the old way (all
+ * mixed together in one list, called through the vtable) against running them from an objectBucket
+ * per type. The test fails if the two end up with different velocities.
+ *
+ * libnds API calls:
+ *   cpuStartTiming -- Starts timers 0 and 1 cascaded for timing
+ *   cpuEndTiming -- Returns the number of bus ticks since cpuStartTiming
+ *
+ * @author Joe Balough
+ */
+class objectBucketBenchmark : public functionalTest
+{
+public:
+
+	/**
+	 * Constructor; just sets the test name
+	 * @author Joe Balough
+	 */
+	objectBucketBenchmark()
+	{
+		name = "objectBucket Benchmark";
+	}
+
+	/**
+	 * Test run function
+	 *
+	 * Makes the same objects both ways, updates them for a bunch of frames and makes sure
+	 * they match.
+	 *
+	 * @author Joe Balough
+	 */
+	virtual bool run()
+	{
+		//       --------------------------------
+		iprintf("objectBucket Benchmark\n\n");
+
+		// Something for them all to look like, made the way the assets class makes them
+		gfxAsset gfx;
+		gfx.dimensions = vector2D<uint8>(16, 16);
+		gfx.topleft = vector2D<uint8>(0, 0);
+		objectAsset *asset = new objectAsset(1);
+		asset->animations = new frameAsset**[2];
+		asset->animations[0] = new frameAsset*[2];
+		asset->animations[0][0] = new frameAsset;
+		asset->animations[0][0]->gfx = &gfx;
+		asset->animations[0][1] = NULL;
+		asset->animations[1] = NULL;
+		levelObjectAsset place(vector2D<fixed32>(0, 0), vector2D<fixed32>(0, 0), asset);
+
+		// The old way: both types mixed together
+		bodyStore mixedBodies;
+		mixedBodies.resize(numObjects);
+		vector<object*> mixed;
+		for (int i = 0; i < numObjects; i++)
+		{
+			if (i % 2)
+				mixed.push_back(new walker(NULL, i, &mixedBodies, asset->animations, place.position, place.gravity, 1));
+			else
+				mixed.push_back(new pacer(NULL, i, &mixedBodies, asset->animations, place.position, place.gravity, 1));
+			mixedBodies.setActive(i, true);
+		}
+
+		// The new way: a bucket for each
+		bodyStore bucketBodies;
+		bucketBodies.resize(numObjects);
+		objectBucket<pacer> pacers;
+		objectBucket<walker> walkers;
+		objectBucket<object> plain;
+		pacers.reserve(numObjects / 2);
+		walkers.reserve(numObjects / 2);
+		for (int i = 0; i < numObjects; i++)
+		{
+			if (i % 2)
+				walkers.add(NULL, i, &bucketBodies, &place);
+			else
+				pacers.add(NULL, i, &bucketBodies, &place);
+			bucketBodies.setActive(i, true);
+		}
+		iprintf("%d objects for %d frames\n\n", numObjects, numFrames);
+
+		// Time the old way
+		cpuStartTiming(0);
+		for (int f = 0; f < numFrames; f++)
+			for (unsigned int i = 0; i < mixed.size(); i++)
+				if (mixedBodies.isActive(mixed[i]->getObjectId()))
+					mixed[i]->update(NULL);
+		uint32 mixedTicks = cpuEndTiming();
+
+		// Time the buckets
+		cpuStartTiming(0);
+		for (int f = 0; f < numFrames; f++)
+		{
+			pacers.update(NULL, bucketBodies);
+			walkers.update(NULL, bucketBodies);
+			plain.update(NULL, bucketBodies);
+		}
+		uint32 bucketTicks = cpuEndTiming();
+
+		iprintf("virtual update: %8ld ticks\n", (long int) mixedTicks);
+		iprintf("                %8ld / frame\n", (long int) (mixedTicks / numFrames));
+		iprintf("objectBucket:   %8ld ticks\n", (long int) bucketTicks);
+		iprintf("                %8ld / frame\n", (long int) (bucketTicks / numFrames));
+
+		// They have to have done exactly the same thing
+		bool success = pacers.size() + walkers.size() == (unsigned int) numObjects;
+		for (int i = 0; i < numObjects; i++)
+		{
+			if (mixedBodies.velocity[i].x != bucketBodies.velocity[i].x || mixedBodies.velocity[i].y != bucketBodies.velocity[i].y)
+				success = false;
+			delete mixed[i];
+		}
+		delete asset;
+
+		if (success)
+			iprintf("\n       Test successful.\n");
+		else
+		{
+			iprintf("\nThe buckets updated things\n");
+			iprintf("differently.\n");
+			iprintf("Test failed.\n");
+		}
+		pauseIfTesting();
+		return success;
+	}
+
+private:
+	// Paces back and forth
+	class pacer : public object
+	{
+	public:
+		pacer(OamState *oam, int id, bodyStore *bodies, frameAsset ***animations, vector2D<fixed32> position,
+		      vector2D<fixed32> gravity, uint8 weight)
+		: object(oam, id, bodies, animations, position, gravity, weight)
+		{
+			hooks = typeHooks;
+		}
+
+		static const uint8 typeHooks = ZBE_HOOK_UPDATE;
+
+		virtual void update(touchPosition * /*touch*/)
+		{
+			velocity.x += fixed32(0.05);
+			if (velocity.x > 2)
+				velocity.x = -2;
+		}
+	};
+
+	// Bobs up and down
+	class walker : public object
+	{
+	public:
+		walker(OamState *oam, int id, bodyStore *bodies, frameAsset ***animations, vector2D<fixed32> position,
+		       vector2D<fixed32> gravity, uint8 weight)
+		: object(oam, id, bodies, animations, position, gravity, weight)
+		{
+			hooks = typeHooks;
+		}
+
+		static const uint8 typeHooks = ZBE_HOOK_UPDATE;
+
+		virtual void update(touchPosition * /*touch*/)
+		{
+			velocity.y -= fixed32(0.1);
+			if (velocity.y < -2)
+				velocity.y = 2;
+		}
+	};
+
+	// How much work to time
+	static const int numObjects = 128;
+	static const int numFrames = 60;
+};
+
+
+
 
 
 
@@ -424,6 +3839,98 @@ void getFunctionalTests(vector<functionalTest*> &tests)
 	collisionMatrixTest *cmt = new collisionMatrixTest;
 	tests.push_back((functionalTest*) cmt);
 
+	// Add the aabbTree test
+	aabbTreeTest *att = new aabbTreeTest;
+	tests.push_back((functionalTest*) att);
+
+	// Add the grid query test
+	gridQueryTest *gqt = new gridQueryTest;
+	tests.push_back((functionalTest*) gqt);
+
+	// Add the staticGeometry test
+	staticGeometryTest *sgt = new staticGeometryTest;
+	tests.push_back((functionalTest*) sgt);
+
+	// Add the tileMap test
+	tileMapTest *tmt = new tileMapTest;
+	tests.push_back((functionalTest*) tmt);
+
+	// Add the swept collision test
+	sweptCollisionTest *sct = new sweptCollisionTest;
+	tests.push_back((functionalTest*) sct);
+
+	// Add the pixel collision test
+	pixelCollisionTest *pct = new pixelCollisionTest;
+	tests.push_back((functionalTest*) pct);
+
+	// Add the hitbox test
+	hitboxTest *hbt = new hitboxTest;
+	tests.push_back((functionalTest*) hbt);
+
+	// Add the grid sizing test
+	gridSizingTest *gst = new gridSizingTest;
+	tests.push_back((functionalTest*) gst);
+
+	// Add the collision layer test
+	collisionLayerTest *clt = new collisionLayerTest;
+	tests.push_back((functionalTest*) clt);
+
+	// Add the stacking test
+	stackingTest *stt = new stackingTest;
+	tests.push_back((functionalTest*) stt);
+
+	// Add the sensor test
+	sensorTest *snt = new sensorTest;
+	tests.push_back((functionalTest*) snt);
+
+	// Add the spawn pool test
+	spawnPoolTest *spt = new spawnPoolTest;
+	tests.push_back((functionalTest*) spt);
+
+	// Add the level spawn test
+	levelSpawnTest *lst = new levelSpawnTest;
+	tests.push_back((functionalTest*) lst);
+
+	// Add the animation test
+	animationTest *ant = new animationTest;
+	tests.push_back((functionalTest*) ant);
+
+	// Add the OAM shadow test
+	oamShadowTest *ost = new oamShadowTest;
+	tests.push_back((functionalTest*) ost);
+
+	// Add the fixed32 physics benchmark
+	fixedPointBenchmark *fpb = new fixedPointBenchmark;
+	tests.push_back((functionalTest*) fpb);
+
+	// Add the bodyStore benchmark
+	bodyStoreBenchmark *bsb = new bodyStoreBenchmark;
+	tests.push_back((functionalTest*) bsb);
+
+	// Add the objectBucket benchmark
+	objectBucketBenchmark *obb = new objectBucketBenchmark;
+	tests.push_back((functionalTest*) obb);
+
+	// Add the collisionMatrix rebin benchmark
+	rebinBenchmark *rbb = new rebinBenchmark;
+	tests.push_back((functionalTest*) rbb);
+
+	// Add the broadphase pair count benchmark
+	pairCountBenchmark *pcb = new pairCountBenchmark;
+	tests.push_back((functionalTest*) pcb);
+
+	// Add the pair cache benchmark
+	pairCacheBenchmark *pcc = new pairCacheBenchmark;
+	tests.push_back((functionalTest*) pcc);
+
+	// Add the batched AABB benchmark
+	aabbBatchBenchmark *abb = new aabbBatchBenchmark;
+	tests.push_back((functionalTest*) abb);
+
+	// Add the broadphase engine benchmark
+	broadphaseBenchmark *bpb = new broadphaseBenchmark;
+	tests.push_back((functionalTest*) bpb);
+
 	// TODO: ADD YOUR CUSTOM FUNCTIONAL TESTS HERE
 
 }
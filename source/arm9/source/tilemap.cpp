@@ -0,0 +1,164 @@
+#include "tilemap.h"
+
+// The smallest step a fixed32 can take. Used to turn a box's right or bottom edge
+// into the last pixel that's actually in it.
+static const fixed32 fixedEpsilon = fixed32::fromRaw(1);
+
+// Utility: whether or not a tile is a slope
+static inline bool isSlope(uint8 tile)
+{
+	return tile == ZBE_TILE_SLOPE_UP || tile == ZBE_TILE_SLOPE_DOWN;
+}
+
+
+// Constructor
+tileMap::tileMap(backgroundAsset *bg, int levelWidth, int levelHeight)
+{
+	tilesWide = (levelWidth + ZBE_TILE_SIZE - 1) >> ZBE_TILE_SHIFT;
+	tilesHigh = (levelHeight + ZBE_TILE_SIZE - 1) >> ZBE_TILE_SHIFT;
+
+	// Use the background's collision layer if it has one
+	if (bg && bg->collision && bg->colLength >= bg->w * bg->h)
+	{
+		tiles = bg->collision;
+		mapWidth = bg->w;
+		mapHeight = bg->h;
+	}
+	else
+	{
+		tiles = NULL;
+		mapWidth = mapHeight = 0;
+	}
+}
+
+// Push an object out of the tiles it ran into
+bool tileMap::collide(object *obj, const vector2D<fixed32> &from) const
+{
+	if (!obj->frame)
+		return false;
+
+	bool pushed = false;
+	// The gfx's box, mirrored if the sprite is flipped
+	vector2D<fixed32> offset(obj->boxLeft(obj->frame->topleft.x, obj->frame->dimensions.x), obj->frame->topleft.y);
+	fixed32 width = obj->frame->dimensions.x, height = obj->frame->dimensions.y;
+	fixed32 halfWidth = fixed32::fromRaw(width.getRaw() >> 1);
+
+	// Horizontal: check the column the leading edge moved into, at the old height
+	fixed32 oldTop = from.y + offset.y;
+	fixed32 oldBottom = oldTop + height;
+	int top = tileOf(oldTop), bottom = tileOf(oldBottom - fixedEpsilon);
+
+	// Something standing on a slope can walk off the top of it onto the tiles next to it
+	if (isSlope(getTile(tileOf(from.x + offset.x + halfWidth), bottom)))
+		--bottom;
+
+	// Every column the leading edge moved into is checked, nearest first, so something
+	// moving more than a tile a frame can't skip over a wall. Usually that's just one.
+	fixed32 oldLeft = from.x + offset.x;
+	fixed32 left = obj->position.x + offset.x;
+	if (obj->position.x > from.x)
+	{
+		int last = tileOf(left + width - fixedEpsilon);
+		int column = tileOf(oldLeft + width - fixedEpsilon) + 1;
+		if (column > last)
+			column = last;
+		for (; column <= last; column++)
+		{
+			if (solidInColumn(column, top, bottom))
+			{
+				obj->position.x = fixed32(column << ZBE_TILE_SHIFT) - width - offset.x;
+				obj->velocity.x = 0;
+				pushed = true;
+				break;
+			}
+		}
+	}
+	else if (obj->position.x < from.x)
+	{
+		int last = tileOf(left);
+		int column = tileOf(oldLeft) - 1;
+		if (column < last)
+			column = last;
+		for (; column >= last; column--)
+		{
+			if (solidInColumn(column, top, bottom))
+			{
+				obj->position.x = fixed32((column + 1) << ZBE_TILE_SHIFT) - offset.x;
+				obj->velocity.x = 0;
+				pushed = true;
+				break;
+			}
+		}
+	}
+
+	// Vertical: check the rows the leading edge moved into, at the new horizontal position
+	left = obj->position.x + offset.x;
+	int leftColumn = tileOf(left), rightColumn = tileOf(left + width - fixedEpsilon);
+	fixed32 newTop = obj->position.y + offset.y;
+	if (obj->position.y > from.y)
+	{
+		int last = tileOf(newTop + height - fixedEpsilon);
+		int row = tileOf(oldBottom - fixedEpsilon) + 1;
+		if (row > last)
+			row = last;
+		for (; row <= last; row++)
+		{
+			fixed32 rowTop = fixed32(row << ZBE_TILE_SHIFT);
+
+			// One-way tiles only count if the object was above them last frame
+			bool land = solidInRow(row, leftColumn, rightColumn);
+			for (int x = leftColumn; !land && x <= rightColumn && oldBottom <= rowTop; x++)
+				land = getTile(x, row) == ZBE_TILE_ONEWAY;
+
+			if (land)
+			{
+				obj->position.y = rowTop - height - offset.y;
+				obj->velocity.y = 0;
+				pushed = true;
+				break;
+			}
+		}
+	}
+	else if (obj->position.y < from.y)
+	{
+		int last = tileOf(newTop);
+		int row = tileOf(oldTop) - 1;
+		if (row < last)
+			row = last;
+		for (; row >= last; row--)
+		{
+			if (solidInRow(row, leftColumn, rightColumn))
+			{
+				obj->position.y = fixed32((row + 1) << ZBE_TILE_SHIFT) - offset.y;
+				obj->velocity.y = 0;
+				pushed = true;
+				break;
+			}
+		}
+	}
+
+	// Slopes: put the object's bottom-center on the floor if it's below it. Things moving up
+	// go through slopes so they can jump up onto them.
+	if (obj->position.y >= from.y)
+	{
+		fixed32 centerX = obj->position.x + offset.x + halfWidth;
+		fixed32 bottomY = obj->position.y + offset.y + height;
+		int column = tileOf(centerX), row = tileOf(bottomY - fixedEpsilon);
+		uint8 tile = getTile(column, row);
+		if (isSlope(tile))
+		{
+			// How far into the tile the center is, and so how high the floor is there
+			fixed32 into = centerX - fixed32(column << ZBE_TILE_SHIFT);
+			fixed32 floorHeight = (tile == ZBE_TILE_SLOPE_UP) ? into : fixed32(ZBE_TILE_SIZE) - into;
+			fixed32 floorY = fixed32((row + 1) << ZBE_TILE_SHIFT) - floorHeight;
+			if (bottomY > floorY)
+			{
+				obj->position.y = floorY - height - offset.y;
+				obj->velocity.y = 0;
+				pushed = true;
+			}
+		}
+	}
+
+	return pushed;
+}
@@ -1,10 +1,13 @@
 #include "vars.h"
 
 // Initialize the global screenoffset variable
-vector2D<float> screenOffset(0.0, 0.0);
+vector2D<fixed32> screenOffset(0, 0);
 
 // init the level size vector
-vector2D<float> levelSize;
+vector2D<fixed32> levelSize;
 
 // This is initialized by game
 assets *zbeAssets;
+
+// This is set by the level that's running
+level *zbeLevel = NULL;
@@ -45,7 +45,7 @@
 /**
  *   Define the zbe verison here!!
  */
-#define ZBE_VERSION 1
+#define ZBE_VERSION 3
 
 
 // Yes, we use the C++ standard library here.
@@ -83,17 +83,22 @@ string xmlDesc = "<?xml version=\"1.0\" ?>\n"
 	"\t<backgrounds>\n"
 	"\t\t<background tiles=\"backgroundTiles id\" palette=\"Default Palette id\">\n"
 	"\t\t\t<row>\n"
-	"\t\t\t\t<tile pal=\"Default overriding palette id\" id=\"Tile id\" hflip=\"0\" vflip=\"1\" />\n"
+	"\t\t\t\t<tile pal=\"Default overriding palette id\" id=\"Tile id\" hflip=\"0\" vflip=\"1\" col=\"empty, solid, oneway, slopeup, or slopedown (default empty)\" />\n"
 	"\t\t\t\t...\n"
 	"\t\t\t</row>\n"
 	"\t\t\t...\n"
 	"\t\t</background>\n"
 	"\t</backgrounds>\n"
 	"\t<objects>\n"
-	"\t\t<object weight=\"weight for collision resolution\">\n"
+	"\t\t<object weight=\"weight for collision resolution\" category=\"layers it's on, 0 to 15 (default 0)\" mask=\"layers it collides with, or all or none (default all)\" sensor=\"true or false, only detects overlaps (default false)\">\n"
 	"\t\t\t<animations>\n"
 	"\t\t\t\t<animation>\n"
-	"\t\t\t\t\t<frame id=\"gfxId\" pal=\"paletteId\" time=\"time in blanks\" />\n"
+	"\t\t\t\t\t<frame id=\"gfxId\" pal=\"paletteId\" time=\"time in blanks\">\n"
+	"\t\t\t\t\t\t<hitbox x=\"left of a box it collides with, from the sprite's top-left\" y=\"top\" w=\"width\" h=\"height\" />\n"
+	"\t\t\t\t\t\t... (up to 15, the gfx's box is used if there are none, boxes are clamped to it)\n"
+	"\t\t\t\t\t\t<hurtbox x=\"left of a box it can be hurt in\" y=\"top\" w=\"width\" h=\"height\" />\n"
+	"\t\t\t\t\t\t... (up to 15, also clamped to the gfx's box)\n"
+	"\t\t\t\t\t</frame>\n"
 	"\t\t\t\t\t...\n"
 	"\t\t\t\t</animation>\n"
 	"\t\t\t\t...\n"
@@ -102,13 +107,13 @@ string xmlDesc = "<?xml version=\"1.0\" ?>\n"
 	"\t\t...\n"
 	"\t</objects>\n"
 	"\t<levels>\n"
-	"\t\t<level bg0=\"Background id to use for farthest background\">\n"
+	"\t\t<level bg0=\"Background id to use for farthest background\" broadphase=\"grid, sap, or tree (default grid)\">\n"
 	"\t\t\t<heroes>\n"
 	"\t\t\t\t<hero id=\"id for corresponding object defined above\" x=\"\" y=\"\" />\n"
 	"\t\t\t\t...\n"
 	"\t\t\t</heroes>\n"
 	"\t\t\t<objects>\n"
-	"\t\t\t\t<object id=\"id for corresponding object defined above\" x=\"\" y=\"\" />\n"
+	"\t\t\t\t<object id=\"id for corresponding object defined above\" x=\"\" y=\"\" static=\"true or false (default false)\" />\n"
 	"\t\t\t\t...\n"
 	"\t\t\t</objects>\n"
 	"\t\t</level>\n"
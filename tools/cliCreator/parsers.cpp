@@ -1,5 +1,94 @@
 #include "parsers.h"
 
+/**
+ * getSpriteDimension function
+ *
+ * Rounds a gfx's width or height up to the size of the sprite it goes in.
+ * NOTE: this needs to match assets::getSpriteSize on the DS
+ *
+ * @param int size
+ *   The width or height of the gfx
+ * @return int
+ *   8, 16, 32 or 64
+ * @author Joe Balough
+ */
+int getSpriteDimension(int size)
+{
+	if (size <= 8)
+		return 8;
+	if (size <= 16)
+		return 16;
+	if (size <= 32)
+		return 32;
+	return 64;
+}
+
+
+/**
+ * writeGfxMask function
+ *
+ * Reads a gfx's tiles back out of its bin file and writes its collision mask: one bit
+ * for every pixel of the w x h box at (left, top), set if that pixel isn't transparent
+ * (palette index 0). Each row is packed into (w + 31) / 32 words with the leftmost pixel
+ * in bit 0 of the first word.
+ * NOTE: this needs to match the gfxAsset mask on the DS
+ *
+ * @param FILE *output
+ *   The zbe file to write the mask to
+ * @param string inFile
+ *   The gfx's bin file, 4 bit tiles from grit
+ * @param int w, int h, int t, int l
+ *   The gfx's width, height, top and left
+ * @return uint16_t
+ *   The length of the mask in bytes
+ * @author Joe Balough
+ */
+uint16_t writeGfxMask(FILE *output, string inFile, int w, int h, int t, int l)
+{
+	// Read the tiles back in
+	vector<uint8_t> tiles;
+	FILE *input = fopen(inFile.c_str(), "rb");
+	if (input)
+	{
+		uint8_t byte;
+		while (fread(&byte, sizeof(uint8_t), 1, input))
+			tiles.push_back(byte);
+		fclose(input);
+	}
+
+	// The tiles go across the whole sprite, row by row
+	int tilesWide = getSpriteDimension(w) / 8;
+	int words = (w + 31) / 32;
+	int opaque = 0;
+	for (int y = 0; y < h; y++)
+	{
+		for (int word = 0; word < words; word++)
+		{
+			uint32_t bits = 0;
+			for (int bit = 0; bit < 32 && word * 32 + bit < w; bit++)
+			{
+				int px = l + word * 32 + bit, py = t + y;
+
+				// 32 bytes per tile, 4 per row of a tile, 2 pixels per byte with the left one in the low nibble
+				unsigned int index = ((py / 8) * tilesWide + px / 8) * 32 + (py % 8) * 4 + (px % 8) / 2;
+				if (index >= tiles.size())
+					continue;
+				uint8_t pixel = (px & 1) ? tiles[index] >> 4 : tiles[index] & 0xF;
+				if (pixel)
+				{
+					bits |= 1u << bit;
+					++opaque;
+				}
+			}
+			fwrite<uint32_t>(bits, output);
+		}
+	}
+
+	debug("	Mask: %d of %d pixels opaque\n", opaque, w * h);
+	return uint16_t(h * words * 4);
+}
+
+
 // Parse GFX
 int parseGfx(TiXmlElement *zbeXML, FILE *output)
 {
@@ -41,6 +130,13 @@ int parseGfx(TiXmlElement *zbeXML, FILE *output)
 			goWrite<uint16_t>(uint16_t(len), output, &lenPos);
 			debug("\tTiles' length: %d B\n", int(len));
 
+			// Then the collision mask, made from those tiles
+			debug("\t");
+			fpos_t maskLenPos = tempVal<uint16_t>("Mask Length", output);
+			uint16_t maskLen = writeGfxMask(output, thisBin, w, h, t, l);
+			goWrite<uint16_t>(maskLen, output, &maskLenPos);
+			debug("\tMask's length: %d B\n", int(maskLen));
+
 			// Get the next sibling
 			gfxXML = gfxXML->NextSiblingElement("gfx");
 			debug("GFX done\n");
@@ -108,13 +204,15 @@ struct bgTile
 	{
 		tileId = palId = 0;
 		hflip = vflip = false;
+		col = 0;
 	}
-	bgTile(uint16_t TileId, uint8_t PalId, bool Hflip = false, bool Vflip = false)
+	bgTile(uint16_t TileId, uint8_t PalId, bool Hflip = false, bool Vflip = false, uint8_t Col = 0)
 	{
 		tileId = TileId;
 		palId = PalId;
 		hflip = Hflip;
 		vflip = Vflip;
+		col = Col;
 	}
 
 	// Returns the 16 bit integer that represents this tile in the maps array
@@ -148,9 +246,47 @@ struct bgTile
 	uint16_t palId;
 	// Horizontal and vertical flip
 	bool hflip, vflip;
+	// Collision type of this tile
+	uint8_t col;
 };
 
 
+/**
+ * getTileCollision function
+ *
+ * Converts the col attribute of a background tile into its collision type.
+ * NOTE: these values need to match the ZBE_TILE_ defines in tilemap.h
+ *
+ * @param const char *colStr
+ *   The value of the col attribute or NULL if it wasn't set
+ * @param unsigned int w, unsigned int h, int bgNo
+ *   Where the tile is, for the warning
+ * @return uint8_t
+ *   The collision type. Empty if not set or unknown.
+ * @author Joe Balough
+ */
+uint8_t getTileCollision(const char *colStr, unsigned int w, unsigned int h, int bgNo)
+{
+	if (!colStr)
+		return 0;
+
+	string col = colStr;
+	if (col == "empty")
+		return 0;
+	if (col == "solid")
+		return 1;
+	if (col == "oneway")
+		return 2;
+	if (col == "slopeup")
+		return 3;
+	if (col == "slopedown")
+		return 4;
+
+	fprintf(stderr, "WARNING: Unknown collision \"%s\" for tile %d in row %d of background %d. Using empty.\n", colStr, w, h, bgNo);
+	return 0;
+}
+
+
 // Parse a single background
 void parseBackground(TiXmlElement *bgXML, FILE *output, int bgNo, uint32_t pal, bool defPal)
 {
@@ -163,10 +299,11 @@ void parseBackground(TiXmlElement *bgXML, FILE *output, int bgNo, uint32_t pal,
 
 	// Process each row
 	TiXmlElement *bgRowXML = bgXML->FirstChildElement("row");
-	debug("\tReading background map (tileId, paletteId, hflip, vflip):\n");
+	debug("\tReading background map (tileId, paletteId, hflip, vflip, col):\n");
 	unsigned int maxWidth = 0;
 	unsigned int h = 0;
 	uint8_t numPalettes = 0;
+	bool hasCollision = false;
 	while (bgRowXML)
 	{
 		++h;
@@ -215,11 +352,16 @@ void parseBackground(TiXmlElement *bgXML, FILE *output, int bgNo, uint32_t pal,
 			getIntAttr(bgTileXML, "hflip", hflip);
 			getIntAttr(bgTileXML, "vflip", vflip);
 
+			// Collision is optional, defaulting to empty
+			uint8_t col = getTileCollision(bgTileXML->Attribute("col"), w, h, bgNo);
+			if (col)
+				hasCollision = true;
+
 			// debug printing made easy
-			debug("(%d %d %d %d) ", tileId, palId, hflip, vflip);
+			debug("(%d %d %d %d %d) ", tileId, palId, hflip, vflip, col);
 
 			// make a new bgTile and add it to the vector
-			bgTile newTile(tileId, palId, hflip == 1, vflip == 1);
+			bgTile newTile(tileId, palId, hflip == 1, vflip == 1, col);
 			rowTiles.push_back(newTile);
 
 			// Get the next tile
@@ -293,6 +435,30 @@ void parseBackground(TiXmlElement *bgXML, FILE *output, int bgNo, uint32_t pal,
 	}
 	goWrite<uint32_t>(mapLen, output, &mapLenPos);
 	debug("\tBackground map length: %dB\n", mapLen);
+
+	// Write the collision layer, one byte per tile. Backgrounds without any collision
+	// tiles don't need one so they get a length of 0.
+	uint32_t colLen = hasCollision ? w * h : 0;
+	fwrite<uint32_t>(colLen, output);
+	if (hasCollision)
+	{
+		debug("\tWriting collision layer:\n");
+		for (unsigned int i = 0; i < h; i++)
+		{
+			debug("\t\t");
+			for (unsigned int j = 0; j < w; j++)
+			{
+				uint8_t toWrite = 0;
+				if ( i < tiles.size() && j < tiles[i].size() )
+					toWrite = tiles[i][j].col;
+
+				debug("%d ", toWrite);
+				fwrite<uint8_t>(toWrite, output);
+			}
+			debug("\n");
+		}
+	}
+	debug("\tCollision layer length: %dB\n", colLen);
 }
 
 
@@ -376,6 +542,9 @@ int parseBackgrounds(TiXmlElement *zbeXML, FILE *output)
 				uint32_t dataLen = appendData(output, extBgBINfile);
 				goWrite<uint32_t>(dataLen, output, &dataLenPos);
 				debug("\tWrote %dB of map data.\n", dataLen);
+
+				// No collision layer for bin maps
+				fwrite<uint32_t>(0, output);
 			}
 			else
 				parseBackground(bgXML, output, totalBg, pal, defPal);
@@ -392,6 +561,167 @@ int parseBackgrounds(TiXmlElement *zbeXML, FILE *output)
 }
 
 
+/**
+ * getFrameBoxes function
+ *
+ * Gets all of a frame's hitbox or hurtbox elements.
+ * NOTE: no more than ZBE_MAX_FRAME_BOXES (15) of each fit in the zbe file
+ *
+ * @param TiXmlElement *frameXML
+ *   The frame element
+ * @param const char *type
+ *   "hitbox" or "hurtbox"
+ * @param uint32_t objNo
+ *   Which object the frame is in, for the warning
+ * @return vector<TiXmlElement*>
+ *   The boxes' elements, at most 15 of them
+ * @author Joe Balough
+ */
+vector<TiXmlElement*> getFrameBoxes(TiXmlElement *frameXML, const char *type, uint32_t objNo)
+{
+	vector<TiXmlElement*> boxes;
+	for (TiXmlElement *boxXML = frameXML->FirstChildElement(type); boxXML; boxXML = boxXML->NextSiblingElement(type))
+	{
+		if (boxes.size() == 15)
+		{
+			fprintf(stderr, "WARNING: Too many %ses on a frame of object %d. Only using the first 15.\n", type, objNo);
+			break;
+		}
+		boxes.push_back(boxXML);
+	}
+	return boxes;
+}
+
+
+/**
+ * getGfxXML function
+ *
+ * Finds a gfx's element by its id, which is its place in the graphics list.
+ *
+ * @param TiXmlElement *zbeXML
+ *   The zbe element
+ * @param int gfxId
+ *   Which gfx to find
+ * @return TiXmlElement*
+ *   The gfx's element or NULL if there isn't one with that id
+ * @author Joe Balough
+ */
+TiXmlElement *getGfxXML(TiXmlElement *zbeXML, int gfxId)
+{
+	TiXmlElement *graphicsXML = zbeXML->FirstChildElement("bin")->FirstChildElement("graphics");
+	if (!graphicsXML)
+		return NULL;
+	TiXmlElement *gfxXML = graphicsXML->FirstChildElement("gfx");
+	for (int i = 0; gfxXML && i < gfxId; i++)
+		gfxXML = gfxXML->NextSiblingElement("gfx");
+	return gfxXML;
+}
+
+
+/**
+ * writeFrameBox function
+ *
+ * Writes a hitbox or hurtbox's left, top, width and height to the zbe file, one byte each.
+ * Boxes are clamped to the frame's gfx box because the DS only uses that box to find
+ * what's near an object.
+ *
+ * @param TiXmlElement *boxXML
+ *   The box's element
+ * @param const char *type
+ *   What kind of box it is, for the debug output
+ * @param TiXmlElement *gfxXML
+ *   The frame's gfx element or NULL to write the box as is
+ * @param uint32_t objNo
+ *   Which object the frame is in, for the warning
+ * @param FILE *output
+ *   The zbe file
+ * @author Joe Balough
+ */
+void writeFrameBox(TiXmlElement *boxXML, const char *type, TiXmlElement *gfxXML, uint32_t objNo, FILE *output)
+{
+	int x = getIntAttr(boxXML, "x");
+	int y = getIntAttr(boxXML, "y");
+	int w = getIntAttr(boxXML, "w");
+	int h = getIntAttr(boxXML, "h");
+
+	if (gfxXML)
+	{
+		int gfxLeft = getIntAttr(gfxXML, "left"), gfxTop = getIntAttr(gfxXML, "top");
+		int gfxRight = gfxLeft + getIntAttr(gfxXML, "w"), gfxBottom = gfxTop + getIntAttr(gfxXML, "h");
+		int left = max(x, gfxLeft), top = max(y, gfxTop);
+		int right = max(left, min(x + w, gfxRight)), bottom = max(top, min(y + h, gfxBottom));
+		if (left != x || top != y || right - left != w || bottom - top != h)
+		{
+			fprintf(stderr, "WARNING: %s on a frame of object %d goes past its gfx. Clamping it to %d x %d at (%d, %d).\n",
+			        type, objNo, right - left, bottom - top, left, top);
+			x = left;
+			y = top;
+			w = right - left;
+			h = bottom - top;
+		}
+	}
+
+	debug("\t\t\t\t%s: %d x %d at (%d, %d)\n", type, w, h, x, y);
+	fwrite<uint8_t>((uint8_t) x, output);
+	fwrite<uint8_t>((uint8_t) y, output);
+	fwrite<uint8_t>((uint8_t) w, output);
+	fwrite<uint8_t>((uint8_t) h, output);
+}
+
+
+/**
+ * getCollisionLayers function
+ *
+ * Converts an object's category or mask attribute into a bitfield. The attribute is a
+ * list of layer numbers from 0 to 15 separated by spaces or commas, or "all" or "none".
+ *
+ * @param TiXmlElement *objectXML
+ *   The object element
+ * @param const char *attr
+ *   "category" or "mask"
+ * @param uint16_t defaultLayers
+ *   The bitfield to use if the attribute isn't set
+ * @param uint32_t objNo
+ *   Which object it is, for the warning
+ * @return uint16_t
+ *   One bit set for every layer listed
+ * @author Joe Balough
+ */
+uint16_t getCollisionLayers(TiXmlElement *objectXML, const char *attr, uint16_t defaultLayers, uint32_t objNo)
+{
+	const char *layersStr = objectXML->Attribute(attr);
+	if (!layersStr)
+		return defaultLayers;
+
+	string layers = layersStr;
+	if (layers == "all")
+		return 0xFFFF;
+	if (layers == "none")
+		return 0;
+
+	// Replace the commas so it's just a list of numbers
+	for (unsigned int i = 0; i < layers.size(); i++)
+		if (layers[i] == ',')
+			layers[i] = ' ';
+
+	uint16_t bits = 0;
+	istringstream layerList(layers);
+	string layer;
+	while (layerList >> layer)
+	{
+		char *end;
+		long l = strtol(layer.c_str(), &end, 10);
+		if (*end || l < 0 || l > 15)
+		{
+			fprintf(stderr, "WARNING: Unknown %s layer \"%s\" for object %d. Layers are 0 to 15.\n", attr, layer.c_str(), objNo);
+			continue;
+		}
+		bits |= 1 << l;
+	}
+	return bits;
+}
+
+
 // Parse out object definitions
 int parseObjects(TiXmlElement *zbeXML, FILE *output)
 {
@@ -415,6 +745,28 @@ int parseObjects(TiXmlElement *zbeXML, FILE *output)
 			debug("\tWeight : %d\n", weight);
 			fwrite<uint8_t>(uint8_t(weight), output);
 
+			// Collision layers. Objects are on layer 0 and collide with everything by default.
+			// NOTE: these defaults need to match ZBE_CATEGORY_DEFAULT and ZBE_MASK_ALL in assettypes.h
+			uint16_t category = getCollisionLayers(objectXML, "category", 0x0001, totalObj);
+			uint16_t mask = getCollisionLayers(objectXML, "mask", 0xFFFF, totalObj);
+			debug("\tCategory : 0x%04X Mask : 0x%04X\n", category, mask);
+			fwrite<uint16_t>(category, output);
+			fwrite<uint16_t>(mask, output);
+
+			// Sensors only detect overlaps. Defaults to not a sensor.
+			bool isSensor = false;
+			const char *sensorStr = objectXML->Attribute("sensor");
+			if (sensorStr)
+			{
+				string sStr = sensorStr;
+				if (sStr == "true" || sStr == "1")
+					isSensor = true;
+				else if (sStr != "false" && sStr != "0")
+					fprintf(stderr, "WARNING: Unknown sensor value \"%s\" for object %d. Using false.\n", sensorStr, totalObj);
+			}
+			debug("\tSensor : %s\n", isSensor ? "true" : "false");
+			fwrite<uint8_t>(uint8_t(isSensor), output);
+
 
 			// Total # Animations
 			uint32_t totalAnimations = 0;
@@ -452,6 +804,16 @@ int parseObjects(TiXmlElement *zbeXML, FILE *output)
 						fwrite<uint32_t>((uint32_t) palId, output);
 						fwrite<uint8_t>((uint8_t) time, output);
 
+						// Then its hitboxes and hurtboxes. Both counts go in one byte, hitboxes in the low nibble.
+						vector<TiXmlElement*> hitboxes = getFrameBoxes(frameXML, "hitbox", totalObj);
+						vector<TiXmlElement*> hurtboxes = getFrameBoxes(frameXML, "hurtbox", totalObj);
+						fwrite<uint8_t>(uint8_t(hurtboxes.size() << 4 | hitboxes.size()), output);
+						TiXmlElement *gfxXML = getGfxXML(zbeXML, gfxId);
+						for (unsigned int i = 0; i < hitboxes.size(); i++)
+							writeFrameBox(hitboxes[i], "Hitbox", gfxXML, totalObj, output);
+						for (unsigned int i = 0; i < hurtboxes.size(); i++)
+							writeFrameBox(hurtboxes[i], "Hurtbox", gfxXML, totalObj, output);
+
 						// get the next frame
 						frameXML = frameXML->NextSiblingElement("frame");
 					}
@@ -520,6 +882,23 @@ int parseLevels(TiXmlElement *zbeXML, FILE *output)
 			fwrite<uint32_t>(uint32_t(h), output);
 			debug("\tLevel \"%s\": %d x %d\n", lvlName.c_str(), w, h);
 
+			// Add the level's broadphase collision engine. Defaults to the grid.
+			// NOTE: these values need to match the ZBE_BROADPHASE_ defines in broadphase.h
+			uint8_t broadphase = 0;
+			const char *broadphaseStr = levelXML->Attribute("broadphase");
+			if (broadphaseStr)
+			{
+				string bpStr = broadphaseStr;
+				if (bpStr == "sap")
+					broadphase = 1;
+				else if (bpStr == "tree")
+					broadphase = 2;
+				else if (bpStr != "grid")
+					fprintf(stderr, "WARNING: Unknown broadphase \"%s\" for level %d. Using grid.\n", broadphaseStr, totalLvl);
+			}
+			fwrite<uint8_t>(broadphase, output);
+			debug("\tUsing broadphase %d\n", broadphase);
+
 			// exp, debug, and timer values if making testing
 			if (testing)
 			{
@@ -576,6 +955,9 @@ int parseLevels(TiXmlElement *zbeXML, FILE *output)
 			map<int, uint32_t> bgIds;
 			map<int, uint8_t> bgDistances;
 			int numBackgrounds = 0;
+
+			// The layer whose collision layer the level collides with. -1 for none.
+			int collisionLayer = -1;
 			
 			if (backgroundsXML)
 			{
@@ -606,6 +988,21 @@ int parseLevels(TiXmlElement *zbeXML, FILE *output)
 					bgDistances[layer] = distance;
 					debug("\tLevel background %d using background %d at distance %d\n", layer, id, distance);
 
+					// See if this is the one to collide with
+					string collideStr = getStrAttr(backgroundXML, "collide");
+					if (collideStr == "true" || collideStr == "1")
+					{
+						if (collisionLayer >= 0)
+							fprintf(stderr, "WARNING: More than one collision background for level %d. Using layer %d.\n", totalLvl, collisionLayer);
+						else
+						{
+							if (distance != 1)
+								fprintf(stderr, "WARNING: Collision background for level %d is at distance %d. It won't line up with the objects.\n", totalLvl, distance);
+							collisionLayer = layer;
+							debug("\tColliding with background %d\n", layer);
+						}
+					}
+
 					// Got another background
 					++numBackgrounds;
 
@@ -647,6 +1044,9 @@ int parseLevels(TiXmlElement *zbeXML, FILE *output)
 			}
 			fwrite<uint32_t>(uint32_t(tilesetId), output);
 
+			// Collision layer
+			fwrite<uint8_t>(uint8_t(collisionLayer), output);
+
 
 
 
@@ -736,13 +1136,26 @@ int parseLevels(TiXmlElement *zbeXML, FILE *output)
 						fprintf(stderr, "WARNING: No vertical gravity set for level object %d. Using default %f.\n", totalLvlObj, fvgrav);
 					int32_t ivgrav = int32_t(fvgrav * pow(2, 12));
 
+					// Static level geometry. Defaults to not static.
+					bool isStatic = false;
+					const char *staticStr = objectXML->Attribute("static");
+					if (staticStr)
+					{
+						string sStr = staticStr;
+						if (sStr == "true" || sStr == "1")
+							isStatic = true;
+						else if (sStr != "false" && sStr != "0")
+							fprintf(stderr, "WARNING: Unknown static value \"%s\" for level object %d. Using false.\n", staticStr, totalLvlObj);
+					}
+
 					// Write them up
-					debug("\t\tObject using object id %d at (%d, %d) w/ grav (%f, %f) = (%d, %d) 20.12\n", id, x, y, fhgrav, fvgrav, ihgrav, ivgrav);
+					debug("\t\tObject using object id %d at (%d, %d) w/ grav (%f, %f) = (%d, %d) 20.12%s\n", id, x, y, fhgrav, fvgrav, ihgrav, ivgrav, isStatic ? " static" : "");
 					fwrite<uint32_t>(uint32_t(id), output);
 					fwrite<uint16_t>(uint16_t(x), output);
 					fwrite<uint16_t>(uint16_t(y), output);
 					fwrite<int32_t>(ihgrav, output);
 					fwrite<int32_t>(ivgrav, output);
+					fwrite<uint8_t>(uint8_t(isStatic), output);
 
 					// Get the next object
 					objectXML = objectXML->NextSiblingElement("object");
@@ -35,7 +35,9 @@
 #include "creatorutil.h"
 #include <map>
 #include <vector>
+#include <algorithm>
 #include <string>
+#include <sstream>
 #include <math.h>
 #include "lib/tinyxml/tinyxml.h"
 